@@ -20,15 +20,11 @@ namespace fast {
 
         mIterationError = mTolerance + 10.0;
         mObjectiveFunction = mObjectiveFunction = std::numeric_limits<double>::max();
-        mResponsibilityMatrix = MatrixXf::Zero(mNumMovingPoints, mNumFixedPoints);
     }
 
     void CoherentPointDriftAffine::maximization(Eigen::MatrixXf &fixedPoints, Eigen::MatrixXf &movingPoints) {
 
-        // Define some useful matrix sums
-        mPt1 = mResponsibilityMatrix.transpose().rowwise().sum();      // mNumFixedPoints x 1
-        mP1 = mResponsibilityMatrix.rowwise().sum();                   // mNumMovingPoints x 1
-        mNp = mPt1.sum();                                           // 1 (sum of all P elements)
+        // The matrix reductions mPt1, mP1, mPX and mNp are calculated in the expectation step
 
         // Estimate new mean vectors
         MatrixXf fixedMean = fixedPoints.transpose() * mPt1 / mNp;
@@ -41,7 +37,8 @@ namespace fast {
         /* **********************************************************
          * Find transformation parameters: affine matrix, translation
          * *********************************************************/
-        MatrixXf A = fixedPointsCentered.transpose() * mResponsibilityMatrix.transpose() * movingPointsCentered;
+        // A = fixedPointsCentered^T * P^T * movingPointsCentered, without using P directly
+        MatrixXf A = (mPX - mP1 * fixedMean.transpose()).transpose() * movingPointsCentered;
         MatrixXf YPY = movingPointsCentered.transpose() * mP1.asDiagonal() * movingPointsCentered;
         MatrixXf XPX = fixedPointsCentered.transpose() * mPt1.asDiagonal() * fixedPointsCentered;
 
@@ -21,12 +21,9 @@ class FAST_EXPORT CoherentPointDriftAffine: public CoherentPointDrift {
         void maximization(MatrixXf& fixedPoints, MatrixXf& movingPoints) override;
 
     private:
-        MatrixXf mPt1;                          // Colwise sum of P, then transpose
-        MatrixXf mP1;                           // Rowwise sum of P
         MatrixXf mAffineMatrix;                 // B
         MatrixXf mTranslation;                  // t
         double mIterationError;                 // Change in error from iteration to iteration
-        float mNp;                              // Sum of all elements in P
         TransformationType mTransformationType;
     };
 
@@ -3,6 +3,7 @@
 #include "CoherentPointDrift.hpp"
 
 #include "FAST/Algorithms/CoherentPointDrift/Rigid.hpp"
+#include "FAST/Algorithms/KDTree/KDTree.hpp"
 
 #undef min
 #undef max
@@ -112,6 +113,13 @@ namespace fast {
         auto c = (float) (pow(2*(double)EIGEN_PI*mVariance, (double)mNumDimensions/2.0)
                           * (mUniformWeight/(1-mUniformWeight)) * (float)mNumMovingPoints/mNumFixedPoints);
 
+        if(mTruncatedExpectation) {
+            truncatedExpectation(fixedPoints, movingPoints, c);
+            return;
+        }
+
+        if(mResponsibilityMatrix.rows() != mNumMovingPoints || mResponsibilityMatrix.cols() != mNumFixedPoints)
+            mResponsibilityMatrix.resize(mNumMovingPoints, mNumFixedPoints);
 #pragma omp parallel for //collapse(2)
         for (int col = 0; col < mNumFixedPoints; ++col) {
             for (int row = 0; row < mNumMovingPoints; ++row) {
@@ -125,6 +133,66 @@ namespace fast {
             float denom = mResponsibilityMatrix.col(col).sum() + c;
             mResponsibilityMatrix.col(col) /= max(denom, Eigen::NumTraits<float>::epsilon() );
         }
+
+        // Matrix reductions used by the maximization step
+        mPt1 = mResponsibilityMatrix.colwise().sum().transpose();
+        mP1 = mResponsibilityMatrix.rowwise().sum();
+        mPX = mResponsibilityMatrix * fixedPoints;
+        mNp = mPt1.sum();
+    }
+
+    void CoherentPointDrift::truncatedExpectation(const MatrixXf& fixedPoints, const MatrixXf& movingPoints, float uniformTerm) {
+        // Only pairs of points closer than this contribute, as exp(-radius^2/(2*variance)) == cutoff
+        const float radius = (float)sqrt(-2.0 * mVariance * log((double)mTruncationCutoff));
+        // If the radius spans both point sets, all pairs contribute and tree searches only add overhead
+        const VectorXf minimum = fixedPoints.colwise().minCoeff().cwiseMin(movingPoints.colwise().minCoeff()).transpose();
+        const VectorXf maximum = fixedPoints.colwise().maxCoeff().cwiseMax(movingPoints.colwise().maxCoeff()).transpose();
+        const bool allPairs = radius >= (maximum - minimum).norm();
+        std::unique_ptr<KDTree> movingTree;
+        if(!allPairs) {
+            movingTree = std::make_unique<KDTree>(movingPoints.transpose());
+            if(!mFixedTree)
+                mFixedTree = std::make_shared<KDTree>(fixedPoints.transpose());
+        }
+        auto findWithinRadius = [&](const KDTree* tree, const MatrixXf& points, const VectorXf& point) {
+            if(!allPairs)
+                return tree->findWithinRadius(point, radius);
+            std::vector<std::pair<int, float>> neighbours(points.rows());
+            for(int i = 0; i < points.rows(); ++i)
+                neighbours[i] = {i, (points.row(i).transpose() - point).squaredNorm()};
+            return neighbours;
+        };
+
+        // Normalization for each fixed point, i.e. column sums of P before division
+        VectorXf denominators(mNumFixedPoints);
+        mPt1.resize(mNumFixedPoints);
+#pragma omp parallel for schedule(dynamic, 64)
+        for (int col = 0; col < mNumFixedPoints; ++col) {
+            const VectorXf point = fixedPoints.row(col).transpose();
+            double sum = 0.0;
+            for (const auto& neighbour : findWithinRadius(movingTree.get(), movingPoints, point))
+                sum += exp(neighbour.second / (-2.0 * mVariance));
+            denominators(col) = std::max((float)sum + uniformTerm, Eigen::NumTraits<float>::epsilon());
+            mPt1(col) = (float)sum / denominators(col);
+        }
+
+        // Row sums of P and P times fixed points
+        mP1.resize(mNumMovingPoints);
+        mPX.resize(mNumMovingPoints, mNumDimensions);
+#pragma omp parallel for schedule(dynamic, 64)
+        for (int row = 0; row < mNumMovingPoints; ++row) {
+            const VectorXf point = movingPoints.row(row).transpose();
+            double sum = 0.0;
+            Eigen::VectorXd weightedSum = Eigen::VectorXd::Zero(mNumDimensions);
+            for (const auto& neighbour : findWithinRadius(mFixedTree.get(), fixedPoints, point)) {
+                const double probability = exp(neighbour.second / (-2.0 * mVariance)) / denominators(neighbour.first);
+                sum += probability;
+                weightedSum += probability * fixedPoints.row(neighbour.first).transpose().cast<double>();
+            }
+            mP1(row) = (float)sum;
+            mPX.row(row) = weightedSum.transpose().cast<float>();
+        }
+        mNp = mPt1.sum();
     }
 
     void CoherentPointDrift::execute() {
@@ -144,6 +212,10 @@ namespace fast {
         // Initialize variance and error
         initializeVarianceAndMore();
 
+        // The fixed points are not changed during registration, so the tree is only built once
+        if(mTruncatedExpectation)
+            mFixedTree = std::make_shared<KDTree>(mFixedPoints.transpose());
+
 
         /* *************************
          * Get some points drifting!
@@ -218,6 +290,17 @@ namespace fast {
         mTolerance = tolerance;
     }
 
+    void CoherentPointDrift::setTruncatedExpectation(bool truncated, float cutoff) {
+        if (cutoff <= 0.0f || cutoff >= 1.0f)
+            throw Exception("Truncation cutoff of coherent point drift must be in (0, 1)");
+        mTruncatedExpectation = truncated;
+        mTruncationCutoff = cutoff;
+    }
+
+    bool CoherentPointDrift::getTruncatedExpectation() const {
+        return mTruncatedExpectation;
+    }
+
     Transform::pointer CoherentPointDrift::getOutputTransformation() {
         return mTransformation;
     }
@@ -6,6 +6,8 @@
 
 namespace fast {
 
+class KDTree;
+
 /**
  * @brief Abstract base class for Coherent Point Drift (CPD) registration
  */
@@ -20,6 +22,19 @@ class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
         void setMaximumIterations(unsigned char maxIterations);
         void setUniformWeight(float uniformWeight);
         void setTolerance(double tolerance);
+        /**
+         * @brief Use a truncated Gaussian kernel in the expectation step
+         *
+         * By default, the expectation step stores the full moving x fixed responsibility matrix, which requires
+         * too much memory for large point sets. When enabled, only fixed and moving points closer than a cutoff
+         * distance are paired, using k-d trees, and the sums needed by the maximization step are computed directly.
+         * Memory usage is then linear in the number of points. While the cutoff distance spans both point sets,
+         * e.g. in the first iterations, all pairs are summed directly instead.
+         * @param truncated
+         * @param cutoff Pairs of points with a Gaussian kernel value below this are ignored. Must be in (0, 1).
+         */
+        void setTruncatedExpectation(bool truncated, float cutoff = 1e-6f);
+        bool getTruncatedExpectation() const;
         Transform::pointer getOutputTransformation();
 
         virtual void initializeVarianceAndMore() = 0;
@@ -33,7 +48,11 @@ class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
         MatrixXf mMovingPoints;
         MatrixXf mMovingMeanInitial;
         MatrixXf mFixedMeanInitial;
-        MatrixXf mResponsibilityMatrix;         // P
+        MatrixXf mResponsibilityMatrix;         // P, only used with the dense expectation step
+        VectorXf mPt1;                          // Colwise sum of P, then transpose
+        VectorXf mP1;                           // Rowwise sum of P
+        MatrixXf mPX;                           // P times fixed points
+        float mNp;                              // Sum of all elements in P
         unsigned int mNumFixedPoints;           // N
         unsigned int mNumMovingPoints;          // M
         unsigned int mNumDimensions;            // D
@@ -63,10 +82,14 @@ class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
         void initializePointSets();
         void printCloudDimensions();
         void normalizePointSets();
+        void truncatedExpectation(const MatrixXf& fixedPoints, const MatrixXf& movingPoints, float uniformTerm);
 
         std::shared_ptr<Mesh> mFixedMesh;
         std::shared_ptr<Mesh> mMovingMesh;
         unsigned char mMaxIterations;
+        bool mTruncatedExpectation = false;
+        float mTruncationCutoff = 1e-6f;
+        std::shared_ptr<KDTree> mFixedTree;     // Built once per registration, only used with truncated expectation
         CoherentPointDrift::TransformationType mTransformationType;
     };
 
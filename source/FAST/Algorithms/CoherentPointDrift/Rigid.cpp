@@ -21,29 +21,10 @@ namespace fast {
 
         mIterationError = mTolerance + 10.0;
         mObjectiveFunction = std::numeric_limits<double>::max();
-        mResponsibilityMatrix = MatrixXf::Zero(mNumMovingPoints, mNumFixedPoints);
-        mPt1 = VectorXf::Zero(mNumFixedPoints);
-        mP1 = VectorXf::Zero(mNumMovingPoints);
     }
 
     void CoherentPointDriftRigid::maximization(MatrixXf& fixedPoints, MatrixXf& movingPoints) {
-        // Calculate some useful matrix reductions
-        mP1 = VectorXf::Zero(mNumMovingPoints);
-        #pragma omp parallel for
-            for (int col = 0; col < mNumFixedPoints; ++col) {
-                mPt1(col) = mResponsibilityMatrix.col(col).sum();
-            }
-        #pragma omp parallel
-        {
-            VectorXf mP1Local = VectorXf::Zero(mNumMovingPoints);
-            #pragma omp for
-            for (int col = 0; col < mNumFixedPoints; ++col) {
-                mP1Local += mResponsibilityMatrix.col(col);
-            }
-            #pragma omp critical
-            mP1 += mP1Local;
-        }
-        mNp = mPt1.sum();                                           // 1 (sum of all P elements)
+        // The matrix reductions mPt1, mP1, mPX and mNp are calculated in the expectation step
 
         // Estimate new mean vectors
         MatrixXf fixedMean = fixedPoints.transpose() * mPt1 / mNp;
@@ -56,7 +37,8 @@ namespace fast {
 
 
         // Single value decomposition (SVD)
-        const MatrixXf A = fixedPointsCentered.transpose() * mResponsibilityMatrix.transpose() * movingPointsCentered;
+        // A = fixedPointsCentered^T * P^T * movingPointsCentered, without using P directly
+        const MatrixXf A = (mPX - mP1 * fixedMean.transpose()).transpose() * movingPointsCentered;
         auto svdU =  A.bdcSvd(Eigen::ComputeThinU);
         auto svdV =  A.bdcSvd(Eigen::ComputeThinV);
         const MatrixXf* U = &svdU.matrixU();
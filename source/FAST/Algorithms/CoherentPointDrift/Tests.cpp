@@ -7,6 +7,7 @@
 #include "FAST/Visualization/TriangleRenderer/TriangleRenderer.hpp"
 #include "FAST/Algorithms/SurfaceExtraction/SurfaceExtraction.hpp"
 #include "FAST/Testing.hpp"
+#include "FAST/SceneGraph.hpp"
 #include "CoherentPointDrift.hpp"
 #include "Rigid.hpp"
 #include "Affine.hpp"
@@ -181,4 +182,29 @@ TEST_CASE("cpd", "[fast][coherentpointdrift][visual][cpd]") {
         window->start();
     }
 
-}
\ No newline at end of file
+}
+
+TEST_CASE("cpd truncated expectation gives same result as dense", "[fast][coherentpointdrift][cpd]") {
+    auto fixed = getPointCloud("Surface_LV.vtk");
+    auto moving = getPointCloud("Surface_LV.vtk");
+    modifyPointCloud(fixed, 0.5);
+    modifyPointCloud(moving, 0.4);
+    Affine3f affine = Affine3f::Identity();
+    affine.rotate(Eigen::AngleAxisf(3.141592f / 180.0f * 20.0f, Eigen::Vector3f::UnitY()));
+    affine.translate(Vector3f(0.01f, 0.005f, -0.002f));
+    auto transform = Transform::create(affine);
+
+    std::vector<Matrix4f> results;
+    for(bool truncated : {false, true}) {
+        moving->getSceneGraphNode()->setTransform(transform);
+        auto cpd = CoherentPointDriftRigid::create();
+        cpd->setFixedMesh(fixed);
+        cpd->setMovingMesh(moving);
+        cpd->setMaximumIterations(50);
+        cpd->setTolerance(1e-4);
+        cpd->setTruncatedExpectation(truncated);
+        cpd->run();
+        results.push_back(SceneGraph::getEigenTransformFromData(moving).matrix());
+    }
+    CHECK(results[0].isApprox(results[1], 1e-3f));
+}
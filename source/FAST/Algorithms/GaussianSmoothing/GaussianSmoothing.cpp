@@ -2,6 +2,9 @@
 #include "FAST/Exception.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include <cstring>
+#include <limits>
+#include <type_traits>
 using namespace fast;
 
 void GaussianSmoothing::setMaskSize(unsigned char maskSize) {
@@ -40,6 +43,8 @@ GaussianSmoothing::GaussianSmoothing(float stdDev, uchar maskSize) {
     mRecreateMask = true;
     mDimensionCLCodeCompiledFor = 0;
     mMask = NULL;
+    mMaskDimensions = 0;
+    mMaskSeparable = false;
     mOutputTypeSet = false;
     setStandardDeviation(stdDev);
     if(maskSize > 0)
@@ -49,15 +54,27 @@ GaussianSmoothing::GaussianSmoothing(float stdDev, uchar maskSize) {
 GaussianSmoothing::~GaussianSmoothing() {
 }
 
-// TODO have to set mRecreateMask to true if input change dimension
 void GaussianSmoothing::createMask(Image::pointer input, uchar maskSize, bool useSeperableFilter) {
-    if(!mRecreateMask)
+    // Mask has to be recreated if the input dimension or the type of mask changes
+    if(!mRecreateMask && mMaskDimensions == input->getDimensions() && mMaskSeparable == useSeperableFilter)
         return;
 
     unsigned char halfSize = (maskSize-1)/2;
     float sum = 0.0f;
 
-    if(input->getDimensions() == 2) {
+    if(useSeperableFilter) {
+        // 1D mask which is applied in each direction
+        mMask = std::make_unique<float[]>(maskSize);
+
+        for(int x = -halfSize; x <= halfSize; x++) {
+            float value = exp(-(float)(x*x)/(2.0f*mStdDev*mStdDev));
+            mMask[x+halfSize] = value;
+            sum += value;
+        }
+
+        for(int i = 0; i < maskSize; ++i)
+            mMask[i] /= sum;
+    } else if(input->getDimensions() == 2) {
         mMask = std::make_unique<float[]>(maskSize*maskSize);
 
         for(int x = -halfSize; x <= halfSize; x++) {
@@ -69,33 +86,19 @@ void GaussianSmoothing::createMask(Image::pointer input, uchar maskSize, bool us
 
         for(int i = 0; i < maskSize*maskSize; ++i)
             mMask[i] /= sum;
-    } else if(input->getDimensions() == 3) {
-        // Use separable filtering for 3D
-        if(useSeperableFilter) {
-            mMask = std::make_unique<float[]>(maskSize);
+    } else {
+        mMask = std::make_unique<float[]>(maskSize*maskSize*maskSize);
 
-            for(int x = -halfSize; x <= halfSize; x++) {
-                float value = exp(-(float)(x*x)/(2.0f*mStdDev*mStdDev));
-                mMask[x+halfSize] = value;
-                sum += value;
-            }
+        for(int x = -halfSize; x <= halfSize; x++) {
+        for(int y = -halfSize; y <= halfSize; y++) {
+        for(int z = -halfSize; z <= halfSize; z++) {
+            float value = exp(-(float)(x*x+y*y+z*z)/(2.0f*mStdDev*mStdDev));
+            mMask[x+halfSize+(y+halfSize)*maskSize+(z+halfSize)*maskSize*maskSize] = value;
+            sum += value;
+        }}}
 
-            for(int i = 0; i < maskSize; ++i)
-                mMask[i] /= sum;
-        } else {
-            mMask = std::make_unique<float[]>(maskSize*maskSize*maskSize);
-
-            for(int x = -halfSize; x <= halfSize; x++) {
-            for(int y = -halfSize; y <= halfSize; y++) {
-            for(int z = -halfSize; z <= halfSize; z++) {
-                float value = exp(-(float)(x*x+y*y+z*z)/(2.0f*mStdDev*mStdDev));
-                mMask[x+halfSize+(y+halfSize)*maskSize+(z+halfSize)*maskSize*maskSize] = value;
-                sum += value;
-            }}}
-
-            for(int i = 0; i < maskSize*maskSize*maskSize; ++i)
-                mMask[i] /= sum;
-        }
+        for(int i = 0; i < maskSize*maskSize*maskSize; ++i)
+            mMask[i] /= sum;
     }
 
     ExecutionDevice::pointer device = getMainDevice();
@@ -115,6 +118,8 @@ void GaussianSmoothing::createMask(Image::pointer input, uchar maskSize, bool us
         );
     }
 
+    mMaskDimensions = input->getDimensions();
+    mMaskSeparable = useSeperableFilter;
     mRecreateMask = false;
 }
 
@@ -140,61 +145,135 @@ void GaussianSmoothing::recompileOpenCLCode(Image::pointer input) {
     mTypeCLCodeCompiledFor = input->getDataType();
 }
 
+/**
+ * Store a row of float values, rounding and clamping to the range of integer types as the OpenCL kernels do.
+ */
+template <class T>
+static inline void storeRow(const float* values, T* output, int size) {
+    // Clamp 32 bit integers in double, as their maximum is rounded up to an out of range value in float
+    typedef typename std::conditional<sizeof(T) < 4, float, double>::type Clamp;
+    constexpr Clamp minimum = (Clamp)std::numeric_limits<T>::lowest();
+    constexpr Clamp maximum = (Clamp)std::numeric_limits<T>::max();
+    for(int i = 0; i < size; ++i)
+        output[i] = (T)std::min(std::max(std::round((Clamp)values[i]), minimum), maximum);
+}
+
+template <>
+inline void storeRow<float>(const float* values, float* output, int size) {
+    std::memcpy(output, values, sizeof(float)*size);
+}
+
+/**
+ * Convolve all rows of the image along the x direction with clamp to edge.
+ * Each row is first copied into a padded float row, so that the inner loop over the row
+ * has no border checks and can be vectorized by the compiler.
+ */
 template <class T>
-void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, const float* const mask, unsigned char maskSize) {
-    // TODO: this method currently only processes the first component
-    unsigned int nrOfComponents = input->getNrOfChannels();
-    ImageAccess::pointer inputAccess = input->getImageAccess(ACCESS_READ);
-    ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
-
-    T * inputData = (T*)inputAccess->get();
-    T * outputData = (T*)outputAccess->get();
-
-    const unsigned char halfSize = (maskSize-1)/2;
-    unsigned int width = input->getWidth();
-    unsigned int height = input->getHeight();
-    if(input->getDimensions() == 3) {
-        unsigned int depth = input->getDepth();
-        for(unsigned int z = 0; z < depth; z++) {
-        for(unsigned int y = 0; y < height; y++) {
-        for(unsigned int x = 0; x < width; x++) {
-
-            if(x < halfSize || x >= width-halfSize ||
-            y < halfSize || y >= height-halfSize ||
-            z < halfSize || z >= depth-halfSize) {
-                // on border only copy values
-                outputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height] = inputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height];
-                continue;
+static void convolveXOnHost(const T* input, float* output, int width, int rows, int channels, const float* mask, int maskSize) {
+    const int halfSize = (maskSize-1)/2;
+    const int rowLength = width*channels;
+    #pragma omp parallel
+    {
+        std::vector<float> padded((width + maskSize - 1)*channels);
+        #pragma omp for
+        for(int row = 0; row < rows; ++row) {
+            const T* inputRow = input + (std::size_t)row*rowLength;
+            for(int x = -halfSize; x < width + halfSize; ++x) {
+                const int clampedX = std::min(std::max(x, 0), width - 1);
+                for(int c = 0; c < channels; ++c)
+                    padded[(x + halfSize)*channels + c] = (float)inputRow[clampedX*channels + c];
             }
+            float* outputRow = output + (std::size_t)row*rowLength;
+            std::fill(outputRow, outputRow + rowLength, 0.0f);
+            for(int k = 0; k < maskSize; ++k) {
+                const float weight = mask[k];
+                const float* source = padded.data() + k*channels;
+                for(int i = 0; i < rowLength; ++i)
+                    outputRow[i] += weight*source[i];
+            }
+        }
+    }
+}
 
-            double sum = 0.0;
-            for(int c = -halfSize; c <= halfSize; c++) {
-            for(int b = -halfSize; b <= halfSize; b++) {
-            for(int a = -halfSize; a <= halfSize; a++) {
-                sum += mask[a+halfSize+(b+halfSize)*maskSize+(c+halfSize)*maskSize*maskSize]*
-                        inputData[(x+a)*nrOfComponents+(y+b)*nrOfComponents*width+(z+c)*nrOfComponents*width*height];
-            }}}
-            outputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height] = (T)sum;
-        }}}
-    } else {
-        for(unsigned int y = halfSize; y < height-halfSize; y++) {
-        for(unsigned int x = halfSize; x < width-halfSize; x++) {
-
-            if(x < halfSize || x >= width-halfSize ||
-            y < halfSize || y >= height-halfSize) {
-                // on border only copy values
-                outputData[x*nrOfComponents+y*nrOfComponents*width] = inputData[x*nrOfComponents+y*nrOfComponents*width];
-                continue;
+/**
+ * Convolve along the y or z direction with clamp to edge.
+ * Output row i of a group is the weighted sum of input rows i-halfSize to i+halfSize of the same group.
+ * Consecutive rows of a group share most of their input rows, thus rows of the same group are processed by
+ * the same thread to keep these in cache.
+ */
+template <class T>
+static void convolveRowsOnHost(const float* input, T* output, int rowLength, int rows, std::size_t rowStride, int groups, std::size_t groupStride, const float* mask, int maskSize) {
+    const int halfSize = (maskSize-1)/2;
+    #pragma omp parallel
+    {
+        std::vector<float> sum(rowLength);
+        #pragma omp for schedule(static)
+        for(int i = 0; i < groups*rows; ++i) {
+            const int group = i / rows;
+            const int row = i % rows;
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            for(int k = 0; k < maskSize; ++k) {
+                const float weight = mask[k];
+                const int sourceRow = std::min(std::max(row + k - halfSize, 0), rows - 1);
+                const float* source = input + group*groupStride + sourceRow*rowStride;
+                for(int j = 0; j < rowLength; ++j)
+                    sum[j] += weight*source[j];
             }
+            storeRow(sum.data(), output + group*groupStride + row*rowStride, rowLength);
+        }
+    }
+}
 
-            double sum = 0.0;
-            for(int b = -halfSize; b <= halfSize; b++) {
-            for(int a = -halfSize; a <= halfSize; a++) {
-                sum += mask[a+halfSize+(b+halfSize)*maskSize]*
-                        inputData[(x+a)*nrOfComponents+(y+b)*nrOfComponents*width];
-            }}
-            outputData[x*nrOfComponents+y*nrOfComponents*width] = (T)sum;
-        }}
+/**
+ * Separable Gaussian smoothing on host. Processes all channels.
+ * Intermediate results are stored in a float buffer, so that input and output can be of any data type.
+ */
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, const float* const mask, int maskSize) {
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDimensions() == 3 ? input->getDepth() : 1;
+    const int channels = input->getNrOfChannels();
+    const int rowLength = width*channels;
+    const std::size_t sliceSize = (std::size_t)rowLength*height;
+
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    auto buffer = std::make_unique<float[]>(sliceSize*depth);
+
+    switch(input->getDataType()) {
+        fastSwitchTypeMacro(convolveXOnHost<FAST_TYPE>((const FAST_TYPE*)inputAccess->get(), buffer.get(), width, height*depth, channels, mask, maskSize));
+    }
+
+    if(depth == 1) {
+        switch(output->getDataType()) {
+            fastSwitchTypeMacro(convolveRowsOnHost<FAST_TYPE>(buffer.get(), (FAST_TYPE*)outputAccess->get(), rowLength, height, rowLength, 1, sliceSize, mask, maskSize));
+        }
+    } else {
+        // y direction, one slice at a time to be able to write the result back into the buffer
+        #pragma omp parallel
+        {
+            auto slice = std::make_unique<float[]>(sliceSize);
+            #pragma omp for
+            for(int z = 0; z < depth; ++z) {
+                float* bufferSlice = buffer.get() + z*sliceSize;
+                const int halfSize = (maskSize-1)/2;
+                for(int y = 0; y < height; ++y) {
+                    float* sliceRow = slice.get() + (std::size_t)y*rowLength;
+                    std::fill(sliceRow, sliceRow + rowLength, 0.0f);
+                    for(int k = 0; k < maskSize; ++k) {
+                        const float weight = mask[k];
+                        const float* source = bufferSlice + (std::size_t)std::min(std::max(y + k - halfSize, 0), height - 1)*rowLength;
+                        for(int i = 0; i < rowLength; ++i)
+                            sliceRow[i] += weight*source[i];
+                    }
+                }
+                std::memcpy(bufferSlice, slice.get(), sizeof(float)*sliceSize);
+            }
+        }
+        // z direction, each image row y is a group of depth rows
+        switch(output->getDataType()) {
+            fastSwitchTypeMacro(convolveRowsOnHost<FAST_TYPE>(buffer.get(), (FAST_TYPE*)outputAccess->get(), rowLength, depth, sliceSize, height, rowLength, mask, maskSize));
+        }
     }
 }
 
@@ -222,10 +301,8 @@ void GaussianSmoothing::execute() {
 
 
     if(device->isHost()) {
-        createMask(input, maskSize, false);
-        switch(input->getDataType()) {
-            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, mMask.get(), maskSize));
-        }
+        createMask(input, maskSize, true);
+        executeAlgorithmOnHost(input, output, mMask.get(), maskSize);
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
 
@@ -9,6 +9,8 @@ namespace fast {
 /**
  * @brief Smoothing by convolution with a Gaussian mask
  *
+ * On the host, separable 1D passes are used in each direction, processed in parallel with OpenMP.
+ *
  * Inputs:
  * - 0: Image, 2D or 3D
  *
@@ -48,6 +50,8 @@ class FAST_EXPORT GaussianSmoothing : public ProcessObject {
         cl::Buffer mCLMask;
         std::unique_ptr<float[]> mMask;
         bool mRecreateMask;
+        uchar mMaskDimensions;
+        bool mMaskSeparable;
 
         cl::Kernel mKernel;
         unsigned char mDimensionCLCodeCompiledFor;
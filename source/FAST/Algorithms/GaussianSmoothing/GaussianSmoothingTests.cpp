@@ -1,6 +1,7 @@
 #include "FAST/Testing.hpp"
 #include "FAST/Algorithms/GaussianSmoothing/GaussianSmoothing.hpp"
 #include "FAST/DeviceManager.hpp"
+#include <chrono>
 
 namespace fast {
 
@@ -202,4 +203,84 @@ TEST_CASE("Correct output with small 3x3x3 3D image as input to GaussianSmoothin
 }
 */
 
+TEST_CASE("Separable GaussianSmoothing on Host gives same result as full convolution", "[fast][GaussianSmoothing]") {
+    const int width = 31;
+    const int height = 17;
+    const int depth = 9;
+    const int channels = 2;
+    const int maskSize = 5;
+    const int halfSize = 2;
+    const float stdDev = 1.2f;
+    auto data = std::make_unique<uchar[]>(width*height*depth*channels);
+    for(int i = 0; i < width*height*depth*channels; ++i)
+        data[i] = (uchar)((i*37 + i/7) % 256);
+    auto input = Image::create(width, height, depth, TYPE_UINT8, channels, data.get());
+
+    // Full 3D convolution with clamp to edge as reference
+    float mask[maskSize];
+    float maskSum = 0.0f;
+    for(int i = 0; i < maskSize; ++i) {
+        mask[i] = std::exp(-(float)((i-halfSize)*(i-halfSize))/(2.0f*stdDev*stdDev));
+        maskSum += mask[i];
+    }
+    auto reference = std::make_unique<float[]>(width*height*depth*channels);
+    for(int z = 0; z < depth; ++z) {
+    for(int y = 0; y < height; ++y) {
+    for(int x = 0; x < width; ++x) {
+    for(int c = 0; c < channels; ++c) {
+        float sum = 0.0f;
+        for(int a = -halfSize; a <= halfSize; ++a) {
+        for(int b = -halfSize; b <= halfSize; ++b) {
+        for(int d = -halfSize; d <= halfSize; ++d) {
+            const int sampleX = std::min(std::max(x+a, 0), width-1);
+            const int sampleY = std::min(std::max(y+b, 0), height-1);
+            const int sampleZ = std::min(std::max(z+d, 0), depth-1);
+            sum += mask[a+halfSize]*mask[b+halfSize]*mask[d+halfSize]*
+                    data[((sampleX + sampleY*width + sampleZ*width*height))*channels + c];
+        }}}
+        reference[(x + y*width + z*width*height)*channels + c] = sum / (maskSum*maskSum*maskSum);
+    }}}}
+
+    auto filter = GaussianSmoothing::create(stdDev, maskSize);
+    filter->setMainDevice(Host::getInstance());
+    filter->setOutputType(TYPE_FLOAT);
+    filter->setInputData(input);
+    auto output = filter->runAndGetOutputData<Image>();
+    CHECK(output->getDataType() == TYPE_FLOAT);
+    CHECK(output->getNrOfChannels() == channels);
+    auto access = output->getImageAccess(ACCESS_READ);
+    auto outputData = (float*)access->get();
+    for(int i = 0; i < width*height*depth*channels; ++i)
+        CHECK(outputData[i] == Approx(reference[i]).margin(0.001));
+
+    // Integer output is rounded
+    auto filter2 = GaussianSmoothing::create(stdDev, maskSize);
+    filter2->setMainDevice(Host::getInstance());
+    filter2->setInputData(input);
+    auto output2 = filter2->runAndGetOutputData<Image>();
+    CHECK(output2->getDataType() == TYPE_UINT8);
+    auto access2 = output2->getImageAccess(ACCESS_READ);
+    auto outputData2 = (uchar*)access2->get();
+    for(int i = 0; i < width*height*depth*channels; ++i)
+        CHECK(std::abs((int)outputData2[i] - (int)std::round(reference[i])) <= 1);
+}
+
+TEST_CASE("GaussianSmoothing on Host 512x512x512 benchmark", "[fast][GaussianSmoothing][benchmark][visual]") {
+    const int size = 512;
+    auto input = Image::create(size, size, size, TYPE_INT16, 1);
+    auto inputAccess = input->getImageAccess(ACCESS_READ_WRITE);
+    auto data = (short*)inputAccess->get();
+    for(std::size_t i = 0; i < (std::size_t)size*size*size; ++i)
+        data[i] = (short)(i % 2048 - 1024);
+    inputAccess->release();
+
+    auto filter = GaussianSmoothing::create(2.0f);
+    filter->setMainDevice(Host::getInstance());
+    filter->setInputData(input);
+    auto start = std::chrono::high_resolution_clock::now();
+    filter->run();
+    std::cout << "GaussianSmoothing on host of " << size << "^3 volume: " <<
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << std::endl;
+}
+
 } // end namespace fast
@@ -1,6 +1,9 @@
 #include "ImageToBatchGenerator.hpp"
 #include <FAST/Data/Image.hpp>
 #include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
+#include <deque>
+#include <condition_variable>
+#include <exception>
 
 namespace fast {
 
@@ -12,17 +15,24 @@ ImageToBatchGenerator::ImageToBatchGenerator() {
     mIsModified = true;
 
     createIntegerAttribute("max-batch-size", "Maximum batch size", "", m_maxBatchSize);
+    createIntegerAttribute("max-latency", "Maximum latency", "Maximum time in milliseconds to wait for a batch to be filled", m_maxLatency);
 }
 
-ImageToBatchGenerator::ImageToBatchGenerator(int maxBatchSize) : ImageToBatchGenerator() {
+ImageToBatchGenerator::ImageToBatchGenerator(int maxBatchSize, int maxLatency) : ImageToBatchGenerator() {
     setMaxBatchSize(maxBatchSize);
+    setMaxLatency(maxLatency);
 }
 
 void ImageToBatchGenerator::loadAttributes() {
     setMaxBatchSize(getIntegerAttribute("max-batch-size"));
+    setMaxLatency(getIntegerAttribute("max-latency"));
 }
 
 void ImageToBatchGenerator::generateStream() {
+    if(m_maxLatency > 0) {
+        generateStreamWithDeadline();
+        return;
+    }
     std::vector<Image::pointer> imageList;
     imageList.reserve(m_maxBatchSize);
     int i = 0;
@@ -67,6 +77,137 @@ void ImageToBatchGenerator::generateStream() {
     //updateThread.join();
 }
 
+void ImageToBatchGenerator::generateStreamWithDeadline() {
+    // Images are read from the parent in a separate thread, so that a batch can be output when
+    // the deadline expires, even if the parent is blocking
+    typedef std::chrono::steady_clock Clock;
+    struct QueuedImage {
+        Image::pointer image;
+        Clock::time_point arrival;
+    };
+    std::deque<QueuedImage> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    bool readerDone = false;
+    bool batcherDone = false;
+    std::exception_ptr readerError;
+    auto po = mParent->getProcessObject();
+    std::thread reader([&]() {
+        try {
+            bool firstTime = true;
+            bool lastFrame = false;
+            while(!lastFrame) {
+                {
+                    std::unique_lock<std::mutex> lock(m_stopMutex);
+                    if(m_stop)
+                        break;
+                }
+                if(!firstTime) // parent is execute the first time, thus drop it here
+                    po->update(); // Make sure execute is called on previous
+                firstTime = false;
+                auto image = mParent->getNextFrame<Image>();
+                const auto arrival = Clock::now();
+                if(!image)
+                    throw Exception("ImageToBatchGenerator did not receive an image from its parent");
+                lastFrame = image->isLastFrame();
+                {
+                    // Don't read too far ahead of the batcher
+                    std::unique_lock<std::mutex> lock(queueMutex);
+                    queueChanged.wait(lock, [&]() { return queue.size() < 2*m_maxBatchSize || batcherDone; });
+                    if(batcherDone)
+                        break;
+                    queue.push_back({image, arrival});
+                }
+                queueChanged.notify_all();
+            }
+        } catch(ThreadStopped &e) {
+        } catch(...) {
+            // Exceptions can not leave the thread, give it to the batcher instead
+            std::lock_guard<std::mutex> lock(queueMutex);
+            readerError = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            readerDone = true;
+        }
+        queueChanged.notify_all();
+    });
+
+    try {
+        bool lastFrame = false;
+        while(!lastFrame) {
+            {
+                std::unique_lock<std::mutex> lock(m_stopMutex);
+                if(m_stop) {
+                    m_streamIsStarted = false;
+                    m_firstFrameIsInserted = false;
+                    break;
+                }
+            }
+            std::vector<Image::pointer> imageList;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                // Wait for first image of the batch
+                queueChanged.wait(lock, [&]() { return !queue.empty() || readerDone; });
+                if(readerError)
+                    std::rethrow_exception(readerError);
+                if(queue.empty())
+                    break;
+                // Wait until the batch is full, or the deadline of the first image in the batch has expired
+                const auto deadline = queue.front().arrival + std::chrono::milliseconds(m_maxLatency);
+                queueChanged.wait_until(lock, deadline, [&]() {
+                    return queue.size() >= m_maxBatchSize || readerDone || queue.back().image->isLastFrame();
+                });
+                if(readerError)
+                    std::rethrow_exception(readerError);
+                while(!queue.empty() && imageList.size() < m_maxBatchSize) {
+                    imageList.push_back(queue.front().image);
+                    queue.pop_front();
+                    if(imageList.back()->isLastFrame()) {
+                        lastFrame = true;
+                        break;
+                    }
+                }
+            }
+            queueChanged.notify_all();
+            auto batch = Batch::create(imageList);
+            if(lastFrame)
+                batch->setLastFrame(getNameOfClass());
+            try {
+                addOutputData(0, batch);
+            } catch(ThreadStopped &e) {
+                std::unique_lock<std::mutex> lock(m_stopMutex);
+                m_stop = true;
+                break;
+            }
+            frameAdded();
+        }
+    } catch(std::exception &e) {
+        // Exception happened when reading images. Stop pipeline, and propagate error message.
+        for(auto item : mOutputConnections) {
+            for(auto output : item.second) {
+                output.lock()->stop(e.what());
+            }
+        }
+        frameAdded(); // To unlock if happens before first frame
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        batcherDone = true;
+    }
+    queueChanged.notify_all();
+    reader.join();
+}
+
+void ImageToBatchGenerator::setMaxLatency(int milliseconds) {
+    m_maxLatency = milliseconds;
+    mIsModified = true;
+}
+
+int ImageToBatchGenerator::getMaxLatency() const {
+    return m_maxLatency;
+}
+
 void ImageToBatchGenerator::execute() {
     if(m_maxBatchSize == -1)
         throw Exception("Max batch size must be given to the ImageToBatchGenerator");
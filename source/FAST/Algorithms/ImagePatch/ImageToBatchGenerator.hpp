@@ -12,8 +12,13 @@ class Image;
  * @brief Converts a stream of images into stream of Batch data objects
  *
  * This is used for doing batch processing on a stream of images.
+ * By default, a batch is output when it is full. If a maximum latency is set, a smaller batch is output
+ * when the latency deadline of the first image in the batch expires. This enables dynamic batching
+ * of streams where images arrive irregularly.
+ * The output of a NeuralNetwork can be converted back to a stream of single data objects with BatchSplitter.
  *
  * @ingroup neural-network
+ * @sa BatchSplitter
  */
 class FAST_EXPORT ImageToBatchGenerator : public Streamer {
     FAST_PROCESS_OBJECT(ImageToBatchGenerator)
@@ -23,14 +28,30 @@ class FAST_EXPORT ImageToBatchGenerator : public Streamer {
          * @param maxBatchSize Maximum batch size
          * @return instance
          */
-        FAST_CONSTRUCTOR(ImageToBatchGenerator, int, maxBatchSize,);
+        FAST_CONSTRUCTOR(ImageToBatchGenerator, int, maxBatchSize,, int, maxLatency, = -1);
+        /**
+         * @brief Set maximum batch size.
+         * Use the max batch size of the inference engine, NeuralNetwork::getInferenceEngine()->getMaxBatchSize(),
+         * to get as large batches as possible.
+         * @param size
+         */
         void setMaxBatchSize(int size);
+        /**
+         * @brief Set maximum time to wait for a batch to be filled.
+         * When this amount of time has passed since the first image of a batch arrived, the batch is output even if
+         * it is not full.
+         * @param milliseconds Maximum latency in milliseconds. If <= 0 (default), batches are only output when full.
+         */
+        void setMaxLatency(int milliseconds);
+        int getMaxLatency() const;
         ~ImageToBatchGenerator() override;
         void loadAttributes() override;
     protected:
         void execute() override;
         void generateStream() override;
+        void generateStreamWithDeadline();
         int m_maxBatchSize;
+        int m_maxLatency = -1;
 
         DataChannel::pointer mParent;
     private:
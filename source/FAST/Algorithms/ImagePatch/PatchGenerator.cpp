@@ -1,6 +1,8 @@
 #include <FAST/Data/ImagePyramid.hpp>
 #include <FAST/Data/Image.hpp>
+#include <FAST/ThreadPool.hpp>
 #include "PatchGenerator.hpp"
+#include <deque>
 
 namespace fast {
 
@@ -24,6 +26,8 @@ PatchGenerator::PatchGenerator() {
     createFloatAttribute("patch-overlap", "Patch overlap", "Patch overlap in percent", m_overlapPercent);
     createFloatAttribute("mask-threshold", "Mask threshold", "Threshold, in percent, for how much of the candidate patch must be inside the mask to be accepted", m_maskThreshold);
     createIntegerAttribute("padding-value", "Padding value", "Value to pad patches with when out-of-bounds. Default is negative, meaning it will use (white)255 for color images, and (black)0 for grayscale images", m_paddingValue);
+    createIntegerAttribute("threads", "Threads", "Number of worker threads creating image pyramid patches. 0 means patches are created on the streaming thread", m_threads);
+    createIntegerAttribute("prefetch", "Prefetch", "Maximum number of image pyramid patches created ahead of the consumer when using worker threads", m_maximumNumberOfPrefetchedPatches);
 }
 
 PatchGenerator::PatchGenerator(int width, int height, int depth, int level, int magnification, float percent, float maskThreshold, int paddingValue) : PatchGenerator() {
@@ -50,21 +54,14 @@ void PatchGenerator::loadAttributes() {
     setMaskThreshold(getFloatAttribute("mask-threshold"));
     setPaddingValue(getIntegerAttribute("padding-value"));
     setPatchMagnification(getIntegerAttribute("patch-magnification"));
+    setNumberOfThreads(getIntegerAttribute("threads"));
+    setMaximumNumberOfPrefetchedPatches(getIntegerAttribute("prefetch"));
 }
 
 PatchGenerator::~PatchGenerator() {
     stop();
 }
 
-template <typename T>
-std::string to_string_with_precision(const T a_value, const int n = 6)
-{
-    std::ostringstream out;
-    out.precision(n);
-    out << std::fixed << a_value;
-    return std::move(out).str();
-}
-
 void PatchGenerator::generateStream() {
     try {
         Image::pointer previousPatch;
@@ -103,9 +100,16 @@ void PatchGenerator::generateStream() {
             const int patchesX = std::ceil((float) levelWidth / (float) patchWidthWithoutOverlap);
             const int patchesY = std::ceil((float) levelHeight / (float) patchHeightWithoutOverlap);
 
+            // Find position of all patches, in the order they should be output
+            struct PatchPosition {
+                int patchX, patchY;
+                int offsetX, offsetY;
+                int width, height;
+                float progress = 0.0f;
+            };
+            std::vector<PatchPosition> positions;
             for(int patchY = 0; patchY < patchesY; ++patchY) {
                 for(int patchX = 0; patchX < patchesX; ++patchX) {
-                    mRuntimeManager->startRegularTimer("create patch");
                     int patchWidth = m_width;
                     if(patchX*patchWidthWithoutOverlap + patchWidth - overlapInPixelsX >= levelWidth) {
                         patchWidth = levelWidth - patchX * patchWidthWithoutOverlap + overlapInPixelsX;
@@ -122,107 +126,143 @@ void PatchGenerator::generateStream() {
                     if(patchY == 0 && overlapInPixelsY > 0) {
                         patchOffsetY = 0;
                     }
-
+                    if(patchWidth < overlapInPixelsX*2 || patchHeight < overlapInPixelsY*2)
+                        continue;
                     if(m_inputMask) {
                         // If a mask exist, check if this patch should be included or not
-                        // At least half of the patch should be clasified as foreground
-                        auto access = m_inputMask->getImageAccess(ACCESS_READ);
                         // Calculate physical position and size
-                        float x = patchOffsetX * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
-                        float y = patchOffsetY * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
-                        float width = patchWidth * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
-                        float height = patchHeight * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
-                        auto croppedMask = m_inputMask->crop(
-                                Vector2i(
-                                        round(x/m_inputMask->getSpacing().x()),
-                                        round(y/m_inputMask->getSpacing().y())
-                                        ),
-                                        Vector2i(
-                                                std::floor(width/m_inputMask->getSpacing().x()),
-                                                std::floor(height/m_inputMask->getSpacing().y())
-                                                )
-                                                );
-                        float average = croppedMask->calculateAverageIntensity();
+                        const float scale = m_inputImagePyramid->getLevelScale(level);
+                        const Vector3f spacing = m_inputImagePyramid->getSpacing();
+                        const Vector3f maskSpacing = m_inputMask->getSpacing();
+                        float x = patchOffsetX * scale * spacing.x();
+                        float y = patchOffsetY * scale * spacing.y();
+                        float width = patchWidth * scale * spacing.x();
+                        float height = patchHeight * scale * spacing.y();
+                        float average = getMaskAverage(
+                                round(x/maskSpacing.x()),
+                                round(y/maskSpacing.y()),
+                                std::floor(width/maskSpacing.x()),
+                                std::floor(height/maskSpacing.y())
+                        );
                         if(average < m_maskThreshold)  // A specific percentage of the mask has to be foreground to be assessed
                             continue;
                     }
-                    reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
-                    auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
-                    if(patchWidth < overlapInPixelsX*2 || patchHeight < overlapInPixelsY*2)
-                        continue;
-                    auto patch = access->getPatchAsImage(level,
-                                                         patchOffsetX,
-                                                         patchOffsetY,
-                                                         patchWidth,
-                                                         patchHeight);
-
-                    // If patch does not have correct size, pad it
-                    int paddingValue = m_paddingValue;
-                    if(m_paddingValue < 0) {
-                        if(m_inputImagePyramid->getNrOfChannels() > 1) {
-                            paddingValue = 255;
-                        } else {
-                            paddingValue = 0;
-                        }
-                    }
-                    if(patch->getWidth() != m_width || patch->getHeight() != m_height) {
-                        patch = patch->crop(Vector2i(0, 0), Vector2i(m_width, m_height), true, paddingValue);
-                    }
-                    if(m_overlapPercent > 0.0f && (patchX == 0 || patchY == 0)) {
-                        int offsetX = patchX == 0 ? -overlapInPixelsX : 0;
-                        int offsetY = patchY == 0 ? -overlapInPixelsY : 0;
-                        patch = patch->crop(Vector2i(offsetX, offsetY), Vector2i(m_width, m_height), true, paddingValue);
-                    }
+                    positions.push_back({patchX, patchY, patchOffsetX, patchOffsetY, patchWidth, patchHeight});
+                }
+            }
+            if(positions.empty())
+                throw Exception("No patches were accepted by the mask in PatchGenerator");
+            // Only accepted patches are in the list, thus progress is accurate also when a mask is used
+            for(int i = 0; i < positions.size(); ++i)
+                positions[i].progress = (float)i/positions.size();
+
+            // If patch does not have correct size, pad it
+            int paddingValue = m_paddingValue;
+            if(m_paddingValue < 0) {
+                if(m_inputImagePyramid->getNrOfChannels() > 1) {
+                    paddingValue = 255;
+                } else {
+                    paddingValue = 0;
+                }
+            }
 
-                    // Store some frame data useful for patch stitching
-                    patch->setFrameData("original-width", std::to_string(levelWidth));
-                    patch->setFrameData("original-height", std::to_string(levelHeight));
-                    patch->setFrameData("patchid-x", std::to_string(patchX));
-                    patch->setFrameData("patchid-y", std::to_string(patchY));
-                    // Target width/height of patches
-                    patch->setFrameData("patch-width", std::to_string(m_width));
-                    patch->setFrameData("patch-height", std::to_string(m_height));
-                    patch->setFrameData("patch-overlap-x", std::to_string(overlapInPixelsX));
-                    patch->setFrameData("patch-overlap-y", std::to_string(overlapInPixelsY));
-                    // Image patch spacing of a WSI can be very small, and std::to_string can round the numbers,
-                    // and there is no way to set the precision, so we use a custom function instead.
-                    patch->setFrameData("patch-spacing-x", to_string_with_precision(patch->getSpacing().x(), 32));
-                    patch->setFrameData("patch-spacing-y", to_string_with_precision(patch->getSpacing().y(), 32));
-                    patch->setFrameData("patch-level", std::to_string(level));
-                    m_progress = (float)(patchX+patchY*patchesX)/(patchesX*patchesY);
-                    patch->setFrameData("progress", std::to_string(m_progress));
+            // Create a patch. May be called from multiple worker threads simultaneously.
+            auto createPatch = [&](const PatchPosition& position) -> Image::pointer {
+                reportInfo() << "Generating patch " << position.patchX << " " << position.patchY << reportEnd();
+                auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
+                auto patch = access->getPatchAsImage(level,
+                                                     position.offsetX,
+                                                     position.offsetY,
+                                                     position.width,
+                                                     position.height);
+
+                if(patch->getWidth() != m_width || patch->getHeight() != m_height) {
+                    patch = patch->crop(Vector2i(0, 0), Vector2i(m_width, m_height), true, paddingValue);
+                }
+                if(m_overlapPercent > 0.0f && (position.patchX == 0 || position.patchY == 0)) {
+                    int offsetX = position.patchX == 0 ? -overlapInPixelsX : 0;
+                    int offsetY = position.patchY == 0 ? -overlapInPixelsY : 0;
+                    patch = patch->crop(Vector2i(offsetX, offsetY), Vector2i(m_width, m_height), true, paddingValue);
+                }
 
-                    mRuntimeManager->stopRegularTimer("create patch");
-                    try {
-                        if(previousPatch) {
-                            addOutputData(0, previousPatch, false);
-                            frameAdded();
-                        }
-                    } catch(ThreadStopped &e) {
-                        std::unique_lock<std::mutex> lock(m_stopMutex);
-                        m_stop = true;
-                        break;
+                // Store some frame data useful for patch stitching
+                patch->setFrameData("original-width", levelWidth);
+                patch->setFrameData("original-height", levelHeight);
+                patch->setFrameData("patchid-x", position.patchX);
+                patch->setFrameData("patchid-y", position.patchY);
+                // Target width/height of patches
+                patch->setFrameData("patch-width", m_width);
+                patch->setFrameData("patch-height", m_height);
+                patch->setFrameData("patch-overlap-x", overlapInPixelsX);
+                patch->setFrameData("patch-overlap-y", overlapInPixelsY);
+                patch->setFrameData("patch-spacing-x", patch->getSpacing().x());
+                patch->setFrameData("patch-spacing-y", patch->getSpacing().y());
+                patch->setFrameData("patch-level", level);
+                patch->setFrameData("progress", position.progress);
+                return patch;
+            };
+
+            // Output a patch, returns false if the stream should stop
+            auto outputPatch = [&](Image::pointer patch, float progress) -> bool {
+                m_progress = progress;
+                try {
+                    if(previousPatch) {
+                        addOutputData(0, previousPatch, false);
+                        frameAdded();
                     }
-                    previousPatch = patch;
+                } catch(ThreadStopped &e) {
                     std::unique_lock<std::mutex> lock(m_stopMutex);
-                    if(m_stop)
-                        break;
+                    m_stop = true;
+                    return false;
                 }
+                previousPatch = patch;
                 std::unique_lock<std::mutex> lock(m_stopMutex);
-                if(m_stop) {
-                    //m_streamIsStarted = false;
-                    m_firstFrameIsInserted = false;
-                    break;
+                return !m_stop;
+            };
+
+            if(m_threads <= 0) {
+                for(const auto& position : positions) {
+                    mRuntimeManager->startRegularTimer("create patch");
+                    auto patch = createPatch(position);
+                    mRuntimeManager->stopRegularTimer("create patch");
+                    if(!outputPatch(patch, position.progress))
+                        break;
                 }
+            } else {
+                // Worker threads create patches ahead of the consumer, while the patches are output
+                // in the same order as they would have been without threads.
+                ThreadPool pool(m_threads);
+                std::deque<std::future<Image::pointer>> prefetched;
+                const int maxPrefetched = std::max(m_maximumNumberOfPrefetchedPatches, m_threads);
+                int next = 0;
+                int current = 0;
+                while(current < positions.size()) {
+                    while(next < positions.size() && prefetched.size() < maxPrefetched) {
+                        const auto& position = positions[next];
+                        prefetched.push_back(pool.submit([&createPatch, &position]() { return createPatch(position); }));
+                        ++next;
+                    }
+                    mRuntimeManager->startRegularTimer("create patch");
+                    auto patch = prefetched.front().get();
+                    mRuntimeManager->stopRegularTimer("create patch");
+                    prefetched.pop_front();
+                    const float progress = positions[current].progress;
+                    ++current;
+                    if(!outputPatch(patch, progress))
+                        break;
+                }
+                // Pool finishes the remaining prefetched patches when destroyed
+            }
+            std::unique_lock<std::mutex> lock(m_stopMutex);
+            if(m_stop) {
+                //m_streamIsStarted = false;
+                m_firstFrameIsInserted = false;
             }
         } else if(m_inputVolume) { // Could be 3D or 2D
             const int width = m_inputVolume->getWidth();
             const int height = m_inputVolume->getHeight();
             const int depth = m_inputVolume->getDepth();
-            auto transformData = SceneGraph::getEigenTransformFromData(m_inputVolume).data();
-            std::string transformString;
-            for(int i = 0; i < 16; ++i)
-                transformString += std::to_string(transformData[i]) + " ";
+            const Matrix4f transform = SceneGraph::getEigenTransformFromData(m_inputVolume).matrix();
 
             const int patchesX = std::ceil((float) width / (float) patchWidthWithoutOverlap);
             const int patchesY = std::ceil((float) height / (float) patchHeightWithoutOverlap);
@@ -260,28 +300,28 @@ void PatchGenerator::generateStream() {
                             }
                         }
                         auto patch = m_inputVolume->crop(Vector3i(x, y, z), Vector3i(m_width, m_height, m_depth), true, paddingValue);
-                        patch->setFrameData("original-width", std::to_string(width));
-                        patch->setFrameData("original-height", std::to_string(height));
-                        patch->setFrameData("original-depth", std::to_string(depth));
-                        patch->setFrameData("original-transform", transformString);
-                        patch->setFrameData("patch-offset-x", std::to_string(x));
-                        patch->setFrameData("patch-offset-y", std::to_string(y));
-                        patch->setFrameData("patch-offset-z", std::to_string(z));
-                        patch->setFrameData("patch-width", std::to_string(m_width));
-                        patch->setFrameData("patch-height", std::to_string(m_height));
-                        patch->setFrameData("patch-depth", std::to_string(m_depth));
-                        patch->setFrameData("patchid-x", std::to_string(patchX));
-                        patch->setFrameData("patchid-y", std::to_string(patchY));
-                        patch->setFrameData("patchid-z", std::to_string(patchZ));
-                        patch->setFrameData("patch-overlap-x", std::to_string(overlapInPixelsX));
-                        patch->setFrameData("patch-overlap-y", std::to_string(overlapInPixelsY));
-                        patch->setFrameData("patch-overlap-z", std::to_string(overlapInPixelsZ));
+                        patch->setFrameData("original-width", width);
+                        patch->setFrameData("original-height", height);
+                        patch->setFrameData("original-depth", depth);
+                        patch->setFrameData("original-transform", transform);
+                        patch->setFrameData("patch-offset-x", x);
+                        patch->setFrameData("patch-offset-y", y);
+                        patch->setFrameData("patch-offset-z", z);
+                        patch->setFrameData("patch-width", m_width);
+                        patch->setFrameData("patch-height", m_height);
+                        patch->setFrameData("patch-depth", m_depth);
+                        patch->setFrameData("patchid-x", patchX);
+                        patch->setFrameData("patchid-y", patchY);
+                        patch->setFrameData("patchid-z", patchZ);
+                        patch->setFrameData("patch-overlap-x", overlapInPixelsX);
+                        patch->setFrameData("patch-overlap-y", overlapInPixelsY);
+                        patch->setFrameData("patch-overlap-z", overlapInPixelsZ);
                         Vector3f spacing = m_inputVolume->getSpacing();
-                        patch->setFrameData("patch-spacing-x", std::to_string(spacing.x()));
-                        patch->setFrameData("patch-spacing-y", std::to_string(spacing.y()));
-                        patch->setFrameData("patch-spacing-z", std::to_string(spacing.z()));
+                        patch->setFrameData("patch-spacing-x", spacing.x());
+                        patch->setFrameData("patch-spacing-y", spacing.y());
+                        patch->setFrameData("patch-spacing-z", spacing.z());
                         m_progress = ((float)(patchX+patchY*patchesX+patchZ*patchesX*patchesY)/(patchesX*patchesY*patchesZ));
-                        patch->setFrameData("progress", std::to_string(m_progress));
+                        patch->setFrameData("progress", m_progress);
                         try {
                             if(previousPatch) {
                                 addOutputData(0, previousPatch, false);
@@ -321,6 +361,51 @@ void PatchGenerator::generateStream() {
     }
 }
 
+template <class T>
+static void calculateSummedAreaTable(const T* data, int width, int height, int channels, std::vector<double>& table) {
+    table.assign((std::size_t)(width + 1)*(height + 1), 0.0);
+    for(int y = 0; y < height; ++y) {
+        double rowSum = 0.0;
+        for(int x = 0; x < width; ++x) {
+            for(int channel = 0; channel < channels; ++channel)
+                rowSum += data[((std::size_t)x + (std::size_t)y*width)*channels + channel];
+            table[(x + 1) + (std::size_t)(y + 1)*(width + 1)] = table[(x + 1) + (std::size_t)y*(width + 1)] + rowSum;
+        }
+    }
+}
+
+void PatchGenerator::createMaskSummedAreaTable() {
+    if(m_inputMask->getDimensions() != 2)
+        throw Exception("Mask given to PatchGenerator must be 2D");
+    auto access = m_inputMask->getImageAccess(ACCESS_READ);
+    const int width = m_inputMask->getWidth();
+    const int height = m_inputMask->getHeight();
+    const int channels = m_inputMask->getNrOfChannels();
+    switch(m_inputMask->getDataType()) {
+        fastSwitchTypeMacro(calculateSummedAreaTable<FAST_TYPE>((const FAST_TYPE*)access->get(), width, height, channels, m_maskSummedAreaTable))
+    }
+}
+
+float PatchGenerator::getMaskAverage(int x, int y, int width, int height) const {
+    // Clamp region to mask
+    const int maskWidth = m_inputMask->getWidth();
+    const int maskHeight = m_inputMask->getHeight();
+    const int startX = std::max(0, std::min(x, maskWidth));
+    const int startY = std::max(0, std::min(y, maskHeight));
+    const int endX = std::max(0, std::min(x + width, maskWidth));
+    const int endY = std::max(0, std::min(y + height, maskHeight));
+    const int area = (endX - startX)*(endY - startY);
+    if(area <= 0)
+        return 0.0f;
+    // The table sums all channels, thus average over both area and channels
+    const int channels = m_inputMask->getNrOfChannels();
+    auto at = [this, maskWidth](int x, int y) {
+        return m_maskSummedAreaTable[x + (std::size_t)y*(maskWidth + 1)];
+    };
+    const double sum = at(endX, endY) - at(startX, endY) - at(endX, startY) + at(startX, startY);
+    return (float)(sum / ((double)area*channels));
+}
+
 void PatchGenerator::execute() {
     if(m_width <= 0 || m_height <= 0 || m_depth <= 0)
         throw Exception("Width, height and depth must be set to a positive number");
@@ -331,7 +416,12 @@ void PatchGenerator::execute() {
 
     if(mInputConnections.count(1) > 0) {
         // If a mask was given store it
-        m_inputMask = getInputData<Image>(1);
+        auto mask = getInputData<Image>(1);
+        if(mask != m_inputMask || mask->getTimestamp() != m_maskTimestamp) {
+            m_inputMask = mask;
+            m_maskTimestamp = mask->getTimestamp();
+            createMaskSummedAreaTable();
+        }
     }
 
     startStream();
@@ -374,6 +464,28 @@ void PatchGenerator::setPatchMagnification(int magnification) {
     setModified(true);
 }
 
+void PatchGenerator::setNumberOfThreads(int threads) {
+    if(threads < 0)
+        throw Exception("Number of threads in PatchGenerator must be >= 0");
+    m_threads = threads;
+    setModified(true);
+}
+
+int PatchGenerator::getNumberOfThreads() const {
+    return m_threads;
+}
+
+void PatchGenerator::setMaximumNumberOfPrefetchedPatches(int patches) {
+    if(patches <= 0)
+        throw Exception("Maximum number of prefetched patches in PatchGenerator must be > 0");
+    m_maximumNumberOfPrefetchedPatches = patches;
+    setModified(true);
+}
+
+int PatchGenerator::getMaximumNumberOfPrefetchedPatches() const {
+    return m_maximumNumberOfPrefetchedPatches;
+}
+
 float PatchGenerator::getProgress() {
     return m_progress;
 }
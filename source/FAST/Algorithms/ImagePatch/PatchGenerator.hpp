@@ -60,6 +60,21 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         void setPatchMagnification(int magnification);
         void setMaskThreshold(float percent);
         void setPaddingValue(int paddingValue);
+        /**
+         * @brief Set number of worker threads which create patches from an ImagePyramid
+         *
+         * Patches are created ahead of the consumer by the worker threads, while they are still output
+         * in the same order. If 0 (default), patches are created one by one on the streaming thread.
+         * @param threads
+         */
+        void setNumberOfThreads(int threads);
+        int getNumberOfThreads() const;
+        /**
+         * @brief Set maximum number of patches which are created ahead of the consumer when using worker threads
+         * @param patches
+         */
+        void setMaximumNumberOfPrefetchedPatches(int patches);
+        int getMaximumNumberOfPrefetchedPatches() const;
         ~PatchGenerator();
         void loadAttributes() override;
         /**
@@ -74,14 +89,24 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         int m_paddingValue = -1;
         int m_magnification = -1;
         float m_progress = 0.0f;
+        int m_threads = 0;
+        int m_maximumNumberOfPrefetchedPatches = 16;
 
         std::shared_ptr<ImagePyramid> m_inputImagePyramid;
         std::shared_ptr<Image> m_inputVolume;
         std::shared_ptr<Image> m_inputMask;
+        uint64_t m_maskTimestamp = 0;
+        // Summed-area table of the mask, used to calculate the mask average of a patch in constant time
+        std::vector<double> m_maskSummedAreaTable;
         int m_level;
 
         void execute() override;
         void generateStream() override;
+        void createMaskSummedAreaTable();
+        /**
+         * Get average mask value in a region, given in mask pixels
+         */
+        float getMaskAverage(int x, int y, int width, int height) const;
     private:
         PatchGenerator();
 };
@@ -14,11 +14,13 @@ PatchStitcher::PatchStitcher(bool patchesAreCropped) {
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher3D.cl", "3D");
     createBooleanAttribute("patches-are-cropped", "Patches are cropped", "Indicate whether incomming patches are already cropped or not.", false);
+    createBooleanAttribute("deferred-level-building", "Deferred level building", "Build the coarser levels of the output image pyramid when the last patch has been stitched, instead of for every patch.", false);
     setPatchesAreCropped(patchesAreCropped);
 }
 
 void PatchStitcher::loadAttributes() {
     setPatchesAreCropped(getBooleanAttribute("patches-are-cropped"));
+    setDeferredLevelBuilding(getBooleanAttribute("deferred-level-building"));
 }
 
 void PatchStitcher::execute() {
@@ -45,6 +47,11 @@ void PatchStitcher::execute() {
             processImage(imagePatch);
         }
     }
+    if(m_outputImagePyramid && m_deferredLevelBuilding && patch->isLastFrame()) {
+        mRuntimeManager->startRegularTimer("build pyramid levels");
+        m_outputImagePyramid->getAccess(ACCESS_READ_WRITE)->buildPyramidLevels();
+        mRuntimeManager->stopRegularTimer("build pyramid levels");
+    }
     mRuntimeManager->stopRegularTimer("stitch patch");
 
     if(m_outputImage) {
@@ -59,14 +66,14 @@ void PatchStitcher::execute() {
 }
 
 void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
 
-    const int patchWidth = std::stoi(patch->getFrameData("patch-width"))- 2*std::stoi(patch->getFrameData("patch-overlap-x"));;
-    const int patchHeight = std::stoi(patch->getFrameData("patch-height")) - 2*std::stoi(patch->getFrameData("patch-overlap-y"));;
+    const int patchWidth = patch->getFrameData<int>("patch-width")- 2*patch->getFrameData<int>("patch-overlap-x");;
+    const int patchHeight = patch->getFrameData<int>("patch-height") - 2*patch->getFrameData<int>("patch-overlap-y");;
 
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    const float patchSpacingX = patch->getFrameData<float>("patch-spacing-x");
+    const float patchSpacingY = patch->getFrameData<float>("patch-spacing-y");
 
     auto shape = patch->getShape();
     if(shape.getDimensions() != 1) {
@@ -85,8 +92,8 @@ void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
     reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y") << reportEnd();
     reportInfo() << "Stitching data with spacing " << patch->getFrameData("patch-spacing-x") << " " << patch->getFrameData("patch-spacing-y") << reportEnd();
 
-    const int startX = std::stoi(patch->getFrameData("patchid-x"));
-    const int startY = std::stoi(patch->getFrameData("patchid-y"));
+    const int startX = patch->getFrameData<int>("patchid-x");
+    const int startY = patch->getFrameData<int>("patchid-y");
 
     auto inputAccess = patch->getAccess(ACCESS_READ);
     auto tensorData = inputAccess->getData<1>();
@@ -99,17 +106,17 @@ void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
 }
 
 void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
+    const float patchSpacingX = patch->getFrameData<float>("patch-spacing-x");
+    const float patchSpacingY = patch->getFrameData<float>("patch-spacing-y");
 
     int fullDepth = 1;
     float patchSpacingZ = 1.0f;
     bool is3D = true;
     try {
-        fullDepth = std::stoi(patch->getFrameData("original-depth"));
-        patchSpacingZ = std::stof(patch->getFrameData("patch-spacing-z"));
+        fullDepth = patch->getFrameData<int>("original-depth");
+        patchSpacingZ = patch->getFrameData<float>("patch-spacing-z");
         if(fullDepth == 1)
             is3D = false;
     } catch(Exception &e) {
@@ -127,9 +134,10 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
 				m_outputImage = Image::create(fullWidth, fullHeight, patch->getDataType(), patch->getNrOfChannels());
             } else {
                 // Large image, create image pyramid instead
-                int patchWidth = std::stoi(patch->getFrameData("patch-width")) - 2*std::stoi(patch->getFrameData("patch-overlap-x"));
-                int patchHeight = std::stoi(patch->getFrameData("patch-height")) - 2*std::stoi(patch->getFrameData("patch-overlap-y"));
+                int patchWidth = patch->getFrameData<int>("patch-width") - 2*patch->getFrameData<int>("patch-overlap-x");
+                int patchHeight = patch->getFrameData<int>("patch-height") - 2*patch->getFrameData<int>("patch-overlap-y");
                 m_outputImagePyramid = ImagePyramid::create(fullWidth, fullHeight, patch->getNrOfChannels(), patchWidth, patchHeight);
+                m_outputImagePyramid->setDeferredLevelBuilding(m_deferredLevelBuilding);
                 reportInfo() << "Patch stitcher creating image PYRAMID with size " << fullWidth << " " << fullHeight << ", patch size: " <<
                     patchWidth << " " << patchHeight << " Levels: " << m_outputImagePyramid->getNrOfLevels() << reportEnd();
             }
@@ -142,11 +150,9 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
             m_outputImagePyramid->setSpacing(Vector3f(patchSpacingX, patchSpacingY, patchSpacingZ));
         }
         try {
-            auto transformData = split(patch->getFrameData("original-transform"));
             auto T = Transform::create();
             Affine3f transform;
-            for(int i = 0; i < 16; ++i)
-                transform.matrix()(i) = std::stof(transformData[i]);
+            transform.matrix() = patch->getFrameData<Matrix4f>("original-transform");
             T->set(transform);
             if(m_outputImage) {
                 m_outputImage->getSceneGraphNode()->setTransform(T);
@@ -165,12 +171,12 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
 		reportInfo() << "Stitching 2D data " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y")
 			<< reportEnd();
 
-        const int patchOverlapX = std::stoi(patch->getFrameData("patch-overlap-x"));
-        const int patchOverlapY = std::stoi(patch->getFrameData("patch-overlap-y"));
+        const int patchOverlapX = patch->getFrameData<int>("patch-overlap-x");
+        const int patchOverlapY = patch->getFrameData<int>("patch-overlap-y");
         // Calculate offset. If this calculation is incorrect. Update in ImagePyramidPatchExporter as well.
         // Position of where to insert the (cropped) patch
-        const int startX = std::stoi(patch->getFrameData("patchid-x")) * (std::stoi(patch->getFrameData("patch-width")) - patchOverlapX*2); // TODO + overlap to compensate for start offset
-        const int startY = std::stoi(patch->getFrameData("patchid-y")) * (std::stoi(patch->getFrameData("patch-height")) - patchOverlapY*2);
+        const int startX = patch->getFrameData<int>("patchid-x") * (patch->getFrameData<int>("patch-width") - patchOverlapX*2); // TODO + overlap to compensate for start offset
+        const int startY = patch->getFrameData<int>("patchid-y") * (patch->getFrameData<int>("patch-height") - patchOverlapY*2);
         if(m_outputImage) {
             // 2D image
             cl::Program program = getOpenCLProgram(device, "2D");
@@ -220,9 +226,9 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
     } else {
         // 3D
         // TODO overlap not implemented for 3D
-        const int startX = std::stoi(patch->getFrameData("patch-offset-x"));
-        const int startY = std::stoi(patch->getFrameData("patch-offset-y"));
-        const int startZ = std::stoi(patch->getFrameData("patch-offset-z"));
+        const int startX = patch->getFrameData<int>("patch-offset-x");
+        const int startY = patch->getFrameData<int>("patch-offset-y");
+        const int startZ = patch->getFrameData<int>("patch-offset-z");
         const int endX = startX + patch->getWidth();
         const int endY = startY + patch->getHeight();
         reportInfo() << "Stitching " << startZ << reportEnd();
@@ -307,5 +313,14 @@ bool PatchStitcher::getPatchesAreCropped() const {
     return m_patchesAreCropped;
 }
 
+void PatchStitcher::setDeferredLevelBuilding(bool deferred) {
+    m_deferredLevelBuilding = deferred;
+    setModified(true);
+}
+
+bool PatchStitcher::getDeferredLevelBuilding() const {
+    return m_deferredLevelBuilding;
+}
+
 
 }
\ No newline at end of file
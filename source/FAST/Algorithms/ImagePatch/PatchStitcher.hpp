@@ -41,6 +41,17 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
          * @param cropped
          */
         bool getPatchesAreCropped() const;
+        /**
+         * @brief Defer building of the coarser levels of the output image pyramid until the last patch
+         *
+         * When enabled, only level 0 of the output image pyramid is updated for each patch, and the coarser levels are
+         * built in bulk when the last patch has been stitched. This is much faster for large images, but the coarser
+         * levels are not updated while the patches are streamed. Only used when the output is an image pyramid.
+         * Default is false.
+         * @param deferred
+         */
+        void setDeferredLevelBuilding(bool deferred);
+        bool getDeferredLevelBuilding() const;
     protected:
         void execute() override;
 
@@ -52,6 +63,7 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
         void processImage(std::shared_ptr<Image> tensor);
     private:
         bool m_patchesAreCropped = false;
+        bool m_deferredLevelBuilding = false;
 
 };
 
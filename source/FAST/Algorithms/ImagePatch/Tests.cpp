@@ -9,8 +9,14 @@
 #include <FAST/Algorithms/ImagePatch/PatchStitcher.hpp>
 #include <FAST/Algorithms/ImagePatch/ImageToBatchGenerator.hpp>
 #include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
+#include <FAST/Algorithms/NeuralNetwork/BatchSplitter.hpp>
 #include <FAST/Importers/ImageFileImporter.hpp>
 #include <FAST/Visualization/VolumeRenderer/AlphaBlendingVolumeRenderer.hpp>
+#include <FAST/Streamers/ImageFileStreamer.hpp>
+#include <FAST/Algorithms/Lambda/RunLambda.hpp>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 
 using namespace fast;
 
@@ -37,6 +43,87 @@ TEST_CASE("Patch generator for WSI", "[fast][wsi][PatchGenerator]") {
     REQUIRE(nrOfPatches == counter);
 }
 
+TEST_CASE("Patch generator for WSI with worker threads gives same output order", "[fast][wsi][PatchGenerator]") {
+    auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs");
+    auto wsi = importer->runAndGetOutputData<ImagePyramid>();
+
+    auto getPatches = [wsi](int threads) {
+        auto generator = PatchGenerator::create(256, 256, 1, 2)
+                ->connect(wsi);
+        generator->setNumberOfThreads(threads);
+        generator->setMaximumNumberOfPrefetchedPatches(8);
+        std::vector<Image::pointer> patches;
+        auto stream = DataStream(generator);
+        while(!stream.isDone())
+            patches.push_back(stream.getNextFrame<Image>());
+        return patches;
+    };
+    auto sequential = getPatches(0);
+    auto parallel = getPatches(4);
+    REQUIRE(sequential.size() == parallel.size());
+    for(int i = 0; i < sequential.size(); ++i) {
+        CHECK(sequential[i]->getFrameData("patchid-x") == parallel[i]->getFrameData("patchid-x"));
+        CHECK(sequential[i]->getFrameData("patchid-y") == parallel[i]->getFrameData("patchid-y"));
+        CHECK(sequential[i]->getFrameData("progress") == parallel[i]->getFrameData("progress"));
+        auto access1 = sequential[i]->getImageAccess(ACCESS_READ);
+        auto access2 = parallel[i]->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access1->get(), access2->get(), sequential[i]->getBufferSize()) == 0);
+    }
+    CHECK(parallel.back()->isLastFrame());
+}
+
+TEST_CASE("Patch generator for WSI with mask", "[fast][wsi][PatchGenerator]") {
+    auto wsi = ImagePyramid::create(1024, 1024, 3, 256, 256);
+    // Mask with a quarter of the resolution, where only the left half is foreground
+    auto maskData = std::make_unique<uchar[]>(256*256);
+    for(int y = 0; y < 256; ++y) {
+        for(int x = 0; x < 256; ++x) {
+            maskData[x + y*256] = x < 128 ? 1 : 0;
+        }
+    }
+    auto mask = Image::create(256, 256, TYPE_UINT8, 1, maskData.get());
+    mask->setSpacing(Vector3f(4.0f, 4.0f, 1.0f));
+
+    auto generator = PatchGenerator::create(256, 256);
+    generator->setInputData(0, wsi);
+    generator->setInputData(1, mask);
+    std::vector<Image::pointer> patches;
+    auto stream = DataStream(generator);
+    while(!stream.isDone())
+        patches.push_back(stream.getNextFrame<Image>());
+    REQUIRE(patches.size() == 8);
+    for(int i = 0; i < patches.size(); ++i) {
+        CHECK(patches[i]->getFrameData<int>("patchid-x") < 2);
+        CHECK(patches[i]->getFrameData<float>("progress") == Approx((float)i/patches.size()));
+    }
+}
+
+TEST_CASE("Patch generator for WSI with multi-channel mask", "[fast][wsi][PatchGenerator]") {
+    auto wsi = ImagePyramid::create(1024, 1024, 3, 256, 256);
+    // First channel is foreground everywhere, second channel only in the left half
+    auto maskData = std::make_unique<uchar[]>(256*256*2);
+    for(int y = 0; y < 256; ++y) {
+        for(int x = 0; x < 256; ++x) {
+            maskData[(x + y*256)*2] = 1;
+            maskData[(x + y*256)*2 + 1] = x < 128 ? 1 : 0;
+        }
+    }
+    auto mask = Image::create(256, 256, TYPE_UINT8, 2, maskData.get());
+    mask->setSpacing(Vector3f(4.0f, 4.0f, 1.0f));
+
+    // Average over both channels is 1 in the left half and 0.5 in the right half
+    auto generator = PatchGenerator::create(256, 256, 1, 0, -1, 0.0f, 0.75f);
+    generator->setInputData(0, wsi);
+    generator->setInputData(1, mask);
+    std::vector<Image::pointer> patches;
+    auto stream = DataStream(generator);
+    while(!stream.isDone())
+        patches.push_back(stream.getNextFrame<Image>());
+    REQUIRE(patches.size() == 8);
+    for(int i = 0; i < patches.size(); ++i)
+        CHECK(patches[i]->getFrameData<int>("patchid-x") < 2);
+}
+
 TEST_CASE("Patch generator on 2D image", "[fast][PatchGenerator]") {
     auto importer = ImageFileImporter::create(Config::getTestDataPath() + "/US/US-2D.jpg");
     auto image = importer->runAndGetOutputData<Image>();
@@ -163,4 +250,69 @@ TEST_CASE("Patch generator, sticher and image to batch generator for WSI", "[fas
         std::cout << "Got a batch" << std::endl;
     }
     std::cout << "Done" << std::endl;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Image to batch generator with max latency and batch splitter", "[fast][ImageToBatchGenerator][BatchSplitter]") {
+    auto importer = ImageFileImporter::create(Config::getTestDataPath() + "/US/US-2D.jpg");
+    auto image = importer->runAndGetOutputData<Image>();
+
+    const int width = 64;
+    const int height = 64;
+    auto generator = PatchGenerator::create(width, height)
+            ->connect(importer);
+    auto batchGenerator = ImageToBatchGenerator::create(4, 10)
+            ->connect(generator);
+    CHECK(batchGenerator->getMaxLatency() == 10);
+    auto splitter = BatchSplitter::create()
+            ->connect(batchGenerator);
+    auto stream = DataStream(splitter);
+    const int patchesX = std::ceil((float)image->getWidth()/width);
+    const int nrOfPatches = patchesX*std::ceil((float)image->getHeight()/height);
+    int counter = 0;
+    while(!stream.isDone()) {
+        auto patch = stream.getNextFrame<Image>();
+        // Order must be the same as from the patch generator
+        CHECK(patch->getFrameData<int>("patchid-x") == counter % patchesX);
+        CHECK(patch->getFrameData<int>("patchid-y") == counter / patchesX);
+        ++counter;
+    }
+    CHECK(counter == nrOfPatches);
+}
+
+TEST_CASE("Image to batch generator with max latency, neural network and batch splitter", "[fast][ImageToBatchGenerator][BatchSplitter][neuralnetwork]") {
+    const int frames = 8;
+    auto streamer = ImageFileStreamer::create(Config::getTestDataPath() + "US/JugularVein/US-2D_#.mhd", false, false);
+    streamer->setMaximumNumberOfFrames(frames);
+    // Images arrive irregularly, thus the max latency flushes batches of size 1 and partial batches of size 3
+    int counter = 0;
+    auto delay = RunLambda::create([&counter](DataObject::pointer data) -> DataList {
+        if(counter % 4 < 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        ++counter;
+        return DataList(data);
+    })->connect(streamer);
+    auto batchGenerator = ImageToBatchGenerator::create(4, 100)
+            ->connect(delay);
+    std::vector<int> batchSizes;
+    auto recordBatchSize = RunLambda::create([&batchSizes](DataObject::pointer data) -> DataList {
+        batchSizes.push_back(std::dynamic_pointer_cast<Batch>(data)->get().getSize());
+        return DataList(data);
+    })->connect(batchGenerator);
+    auto network = NeuralNetwork::New();
+    network->getInferenceEngine()->setMaxBatchSize(4);
+    network->load(join(Config::getTestDataPath(), "NeuralNetworkModels/jugular_vein_segmentation." +
+            getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+    network->setScaleFactor(1.0f / 255.0f);
+    network->connect(recordBatchSize);
+    auto splitter = BatchSplitter::create()
+            ->connect(network);
+    auto stream = DataStream(splitter);
+    int outputs = 0;
+    while(!stream.isDone()) {
+        stream.getNextFrame<Tensor>();
+        ++outputs;
+    }
+    CHECK(outputs == frames);
+    CHECK(std::find(batchSizes.begin(), batchSizes.end(), 1) != batchSizes.end());
+    CHECK(std::any_of(batchSizes.begin(), batchSizes.end(), [](int size) { return size > 1 && size < 4; }));
+}
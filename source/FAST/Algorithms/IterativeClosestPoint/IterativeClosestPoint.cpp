@@ -1,5 +1,6 @@
 #include "FAST/Algorithms/IterativeClosestPoint/IterativeClosestPoint.hpp"
 #include "FAST/SceneGraph.hpp"
+#include "FAST/Algorithms/KDTree/KDTree.hpp"
 #undef min
 #undef max
 #include <limits>
@@ -69,44 +70,29 @@ inline Vector3f RGB2YIQ(Vector3f rgb) {
 }
 
 /**
- * Create a new matrix which is matrix A rearranged.
- * This matrix has the same size as B
+ * Create points used to find closest points, consisting of the position and the weighted YIQ color of each point
  */
-inline MatrixXf rearrangeMatrixToClosestPoints(const MatrixXf& A, const MatrixXf& B, const MatrixXf& Acolors, const MatrixXf& Bcolors, float colorWeight) {
-    MatrixXf result = MatrixXf::Constant(B.rows(), B.cols(), 0);
+inline MatrixXf createClosestPointFeatures(const MatrixXf& points, const MatrixXf& colors) {
+    const Vector3f colorWeights(100.0, 1000.0, 1000.0);
+    MatrixXf features(6, points.cols());
+    features.topRows(3) = points;
+    for(int i = 0; i < points.cols(); ++i)
+        features.col(i).tail(3) = RGB2YIQ(colors.col(i)).cwiseProduct(colorWeights);
+    return features;
+}
 
-    Vector3f colorWeights(100.0, 1000.0, 1000.0);
+/**
+ * Create a new matrix which is matrix A rearranged, so that column i is the point in A closest to point i in B.
+ * This matrix has the same size as B
+ */
+inline MatrixXf rearrangeMatrixToClosestPoints(const MatrixXf& A, const KDTree& treeA, const MatrixXf& B, const MatrixXf& Bcolors) {
     // For each point in B, find the closest point in A
-#pragma omp parallel for
-    for(int b = 0; b < B.cols(); ++b) {
-        Vector3f pointInB = B.col(b);
-        Vector3f Bcolor = RGB2YIQ(Bcolors.col(b));
-        float minDistance = std::numeric_limits<float>::max();
-        uint closestPoint = 0;
-        for(int a = 0; a < A.cols(); ++a) {
-            Vector3f pointInA = A.col(a);
-            Vector3f Acolor = RGB2YIQ(Acolors.col(a));
-            VectorXf distanceVector = VectorXf::Zero(6);
-            distanceVector.head(3) = pointInA - pointInB;
-            distanceVector(3) = (Acolor.x() - Bcolor.x())*colorWeights.x();
-            distanceVector(4) = (Acolor.y() - Bcolor.y())*colorWeights.y();
-            distanceVector(5) = (Acolor.z() - Bcolor.z())*colorWeights.z();
-            //std::cout << distanceVector.tail(3) << std::endl;
-            float distance = distanceVector.norm();
-            //float distance = (pointInA-pointInB).norm();
-            //std::cout << colorDistance(Acolor, Bcolor) << std::endl;
-            //if(colorDistance(Acolor, Bcolor) < 100) {
-                if(distance < minDistance) {
-                    minDistance = distance;
-                    closestPoint = a;
-                }
-            //}
-        }
-        result.col(b) = A.col(closestPoint);
-    }
+    const std::vector<int> closestPoints = treeA.findNearest(createClosestPointFeatures(B, Bcolors));
+    MatrixXf result(B.rows(), B.cols());
+    for(int b = 0; b < B.cols(); ++b)
+        result.col(b) = A.col(closestPoints[b]);
 
     return result;
-
 }
 
 /*
@@ -243,14 +229,17 @@ void IterativeClosestPoint::execute() {
     }
     fixedPoints = fixedPointTransform*fixedPoints.colwise().homogeneous();
 
-    float colorWeight = 1.0f;
+    // The fixed points do not move, thus the search tree is built only once
+    mRuntimeManager->startRegularTimer("build_kd_tree");
+    KDTree fixedTree(createClosestPointFeatures(fixedPoints, fixedColors));
+    mRuntimeManager->stopRegularTimer("build_kd_tree");
 
     // Want to choose the smallest one as moving
     bool invertTransform = false;
 	MatrixXf movedPoints = currentTransformation*(movingPoints.colwise().homogeneous());
     // Match closest points using current transformation
     MatrixXf rearrangedFixedPoints = rearrangeMatrixToClosestPoints(
-            fixedPoints, movedPoints, fixedColors, movingColors, colorWeight);
+            fixedPoints, fixedTree, movedPoints, movingColors);
     do {
         previousError = error;        
 
@@ -302,7 +291,7 @@ void IterativeClosestPoint::execute() {
         // Should we rearrange the points here?
         mRuntimeManager->startRegularTimer("find_closest");
         rearrangedFixedPoints = rearrangeMatrixToClosestPoints(
-                fixedPoints, movedPoints, fixedColors, movingColors, colorWeight);
+                fixedPoints, fixedTree, movedPoints, movingColors);
         mRuntimeManager->stopRegularTimer("find_closest");
 		MatrixXf distance = rearrangedFixedPoints - movedPoints;
         error = 0;
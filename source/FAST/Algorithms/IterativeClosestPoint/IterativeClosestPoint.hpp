@@ -8,6 +8,8 @@ namespace fast {
 /**
  * @brief Registration of two meshes using ICP algorithm
  *
+ * Closest points are found using a KDTree of the fixed points, with both position and color used as distance.
+ *
  * @ingroup registration
  */
 class FAST_EXPORT  IterativeClosestPoint : public ProcessObject {
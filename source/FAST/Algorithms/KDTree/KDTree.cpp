@@ -0,0 +1,153 @@
+#include "KDTree.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace fast {
+
+KDTree::KDTree(const MatrixXf& points, int maxLeafSize) {
+    if(maxLeafSize < 1)
+        throw Exception("Maximum leaf size of KDTree must be at least 1");
+    m_dimensions = points.rows();
+    m_maxLeafSize = maxLeafSize;
+    m_indices.resize(points.cols());
+    std::iota(m_indices.begin(), m_indices.end(), 0);
+    m_points = points;
+    if(points.cols() > 0) {
+        m_nodes.reserve(2*points.cols()/maxLeafSize + 1);
+        build(0, points.cols());
+        // Store points in leaf order for better memory locality during search
+        for(int i = 0; i < m_indices.size(); ++i)
+            m_points.col(i) = points.col(m_indices[i]);
+    }
+}
+
+int KDTree::build(int start, int end) {
+    const int nodeIndex = m_nodes.size();
+    m_nodes.push_back({-1, 0.0f, -1, -1, start, end});
+    if(end - start <= m_maxLeafSize)
+        return nodeIndex;
+
+    // Split along the dimension with the largest spread
+    VectorXf minimum = VectorXf::Constant(m_dimensions, std::numeric_limits<float>::max());
+    VectorXf maximum = VectorXf::Constant(m_dimensions, std::numeric_limits<float>::lowest());
+    for(int i = start; i < end; ++i) {
+        minimum = minimum.cwiseMin(m_points.col(m_indices[i]));
+        maximum = maximum.cwiseMax(m_points.col(m_indices[i]));
+    }
+    int dimension;
+    const float spread = (maximum - minimum).maxCoeff(&dimension);
+    if(spread <= 0) // All points are equal
+        return nodeIndex;
+
+    // Split at the median
+    const int middle = start + (end - start)/2;
+    std::nth_element(m_indices.begin() + start, m_indices.begin() + middle, m_indices.begin() + end, [this, dimension](int a, int b) {
+        return m_points(dimension, a) < m_points(dimension, b);
+    });
+    const float split = m_points(dimension, m_indices[middle]);
+    const int left = build(start, middle);
+    const int right = build(middle, end);
+    Node& node = m_nodes[nodeIndex];
+    node.dimension = dimension;
+    node.split = split;
+    node.left = left;
+    node.right = right;
+    return nodeIndex;
+}
+
+float KDTree::squaredDistance(int point, const float* query) const {
+    const float* data = m_points.data() + (std::size_t)point*m_dimensions;
+    float distance = 0.0f;
+    for(int d = 0; d < m_dimensions; ++d) {
+        const float difference = data[d] - query[d];
+        distance += difference*difference;
+    }
+    return distance;
+}
+
+void KDTree::findNearest(int nodeIndex, const float* query, int& nearest, float& nearestDistance) const {
+    const Node& node = m_nodes[nodeIndex];
+    if(node.dimension < 0) {
+        for(int i = node.start; i < node.end; ++i) {
+            const float distance = squaredDistance(i, query);
+            if(distance < nearestDistance) {
+                nearestDistance = distance;
+                nearest = i;
+            }
+        }
+        return;
+    }
+    // Search the side of the split containing the query first, and the other side only if it can contain a closer point
+    const float difference = query[node.dimension] - node.split;
+    const int first = difference < 0 ? node.left : node.right;
+    const int second = difference < 0 ? node.right : node.left;
+    findNearest(first, query, nearest, nearestDistance);
+    if(difference*difference < nearestDistance)
+        findNearest(second, query, nearest, nearestDistance);
+}
+
+int KDTree::findNearest(const VectorXf& query, float* squaredDistance) const {
+    if(query.size() != m_dimensions)
+        throw Exception("Query point has " + std::to_string(query.size()) + " dimensions, KDTree has " + std::to_string(m_dimensions));
+    if(m_nodes.empty())
+        return -1;
+    int nearest = -1;
+    float nearestDistance = std::numeric_limits<float>::max();
+    findNearest(0, query.data(), nearest, nearestDistance);
+    if(squaredDistance != nullptr)
+        *squaredDistance = nearestDistance;
+    return m_indices[nearest];
+}
+
+std::vector<int> KDTree::findNearest(const MatrixXf& queries) const {
+    if(queries.rows() != m_dimensions)
+        throw Exception("Query points have " + std::to_string(queries.rows()) + " dimensions, KDTree has " + std::to_string(m_dimensions));
+    std::vector<int> result(queries.cols(), -1);
+    if(m_nodes.empty())
+        return result;
+#pragma omp parallel for
+    for(int i = 0; i < queries.cols(); ++i) {
+        int nearest = -1;
+        float nearestDistance = std::numeric_limits<float>::max();
+        findNearest(0, queries.data() + (std::size_t)i*m_dimensions, nearest, nearestDistance);
+        result[i] = m_indices[nearest];
+    }
+    return result;
+}
+
+void KDTree::findWithinRadius(int nodeIndex, const float* query, float squaredRadius, std::vector<std::pair<int, float>>& result) const {
+    const Node& node = m_nodes[nodeIndex];
+    if(node.dimension < 0) {
+        for(int i = node.start; i < node.end; ++i) {
+            const float distance = squaredDistance(i, query);
+            if(distance <= squaredRadius)
+                result.push_back({m_indices[i], distance});
+        }
+        return;
+    }
+    const float difference = query[node.dimension] - node.split;
+    if(difference < 0 || difference*difference <= squaredRadius)
+        findWithinRadius(node.left, query, squaredRadius, result);
+    if(difference >= 0 || difference*difference <= squaredRadius)
+        findWithinRadius(node.right, query, squaredRadius, result);
+}
+
+std::vector<std::pair<int, float>> KDTree::findWithinRadius(const VectorXf& query, float radius) const {
+    if(query.size() != m_dimensions)
+        throw Exception("Query point has " + std::to_string(query.size()) + " dimensions, KDTree has " + std::to_string(m_dimensions));
+    std::vector<std::pair<int, float>> result;
+    if(!m_nodes.empty())
+        findWithinRadius(0, query.data(), radius*radius, result);
+    return result;
+}
+
+int KDTree::getNrOfPoints() const {
+    return m_points.cols();
+}
+
+int KDTree::getNrOfDimensions() const {
+    return m_dimensions;
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+
+namespace fast {
+
+/**
+ * @brief K-d tree for fast nearest neighbour and radius search in point sets
+ *
+ * The tree is built once from a set of points, and can then be queried from multiple threads simultaneously.
+ * Points can have any number of dimensions, e.g. 3D positions, or 3D positions combined with colors.
+ * To use a weighted distance, for instance to weight colors against positions, multiply each dimension
+ * of both the points and the queries with its weight.
+ *
+ * Used by IterativeClosestPoint to find correspondences.
+ *
+ * @ingroup registration
+ */
+class FAST_EXPORT KDTree : public Object {
+    public:
+        typedef std::shared_ptr<KDTree> pointer;
+        /**
+         * @brief Build k-d tree
+         * @param points DxN matrix, where each column is a point of D dimensions
+         * @param maxLeafSize Maximum number of points in each leaf node
+         */
+        explicit KDTree(const MatrixXf& points, int maxLeafSize = 16);
+        /**
+         * @brief Find the nearest point
+         * @param query point with same number of dimensions as the points in the tree
+         * @param squaredDistance if not nullptr, the squared distance to the nearest point is stored here
+         * @return index of nearest point, or -1 if tree is empty
+         */
+        int findNearest(const VectorXf& query, float* squaredDistance = nullptr) const;
+        /**
+         * @brief Find the nearest point for each query point, in parallel
+         * @param queries DxM matrix, where each column is a query point
+         * @return index of nearest point for each query point
+         */
+        std::vector<int> findNearest(const MatrixXf& queries) const;
+        /**
+         * @brief Find all points within a given radius
+         * @param query
+         * @param radius
+         * @return list of pairs of point index and squared distance, in no particular order
+         */
+        std::vector<std::pair<int, float>> findWithinRadius(const VectorXf& query, float radius) const;
+        int getNrOfPoints() const;
+        int getNrOfDimensions() const;
+        std::string getNameOfClass() const { return "KDTree"; };
+    private:
+        struct Node {
+            int dimension; // -1 for leaf nodes
+            float split;
+            int left;
+            int right;
+            int start; // Range of points in leaf node
+            int end;
+        };
+        int build(int start, int end);
+        void findNearest(int node, const float* query, int& nearest, float& nearestDistance) const;
+        void findWithinRadius(int node, const float* query, float squaredRadius, std::vector<std::pair<int, float>>& result) const;
+        float squaredDistance(int point, const float* query) const;
+
+        int m_dimensions;
+        int m_maxLeafSize;
+        // Points are reordered so that the points of each leaf are stored contiguously
+        MatrixXf m_points;
+        std::vector<int> m_indices;
+        std::vector<Node> m_nodes;
+};
+
+}
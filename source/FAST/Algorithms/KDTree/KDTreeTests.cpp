@@ -0,0 +1,99 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/KDTree/KDTree.hpp>
+#include <chrono>
+#include <limits>
+
+using namespace fast;
+
+static int findNearestBruteForce(const MatrixXf& points, const VectorXf& query) {
+    int nearest = -1;
+    float nearestDistance = std::numeric_limits<float>::max();
+    for(int i = 0; i < points.cols(); ++i) {
+        const float distance = (points.col(i) - query).squaredNorm();
+        if(distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = i;
+        }
+    }
+    return nearest;
+}
+
+TEST_CASE("KDTree finds same nearest points as brute force", "[fast][KDTree]") {
+    std::srand(0);
+    for(int dimensions : {2, 3, 6}) {
+        MatrixXf points = MatrixXf::Random(dimensions, 5000);
+        MatrixXf queries = MatrixXf::Random(dimensions, 500);
+        KDTree tree(points);
+        CHECK(tree.getNrOfPoints() == 5000);
+        CHECK(tree.getNrOfDimensions() == dimensions);
+        auto result = tree.findNearest(queries);
+        REQUIRE(result.size() == 500);
+        for(int i = 0; i < queries.cols(); ++i) {
+            const int expected = findNearestBruteForce(points, queries.col(i));
+            // Different points may have the same distance
+            CHECK((points.col(result[i]) - queries.col(i)).squaredNorm() == Approx((points.col(expected) - queries.col(i)).squaredNorm()));
+        }
+    }
+}
+
+TEST_CASE("KDTree radius search", "[fast][KDTree]") {
+    std::srand(0);
+    MatrixXf points = MatrixXf::Random(3, 2000);
+    KDTree tree(points, 8);
+    const VectorXf query = Vector3f(0.1f, -0.2f, 0.3f);
+    const float radius = 0.4f;
+    auto result = tree.findWithinRadius(query, radius);
+    int expected = 0;
+    for(int i = 0; i < points.cols(); ++i) {
+        if((points.col(i) - query).norm() <= radius)
+            expected += 1;
+    }
+    CHECK(result.size() == expected);
+    for(auto& point : result)
+        CHECK(point.second == Approx((points.col(point.first) - query).squaredNorm()));
+}
+
+TEST_CASE("KDTree with duplicate and no points", "[fast][KDTree]") {
+    MatrixXf points = MatrixXf::Ones(3, 100);
+    KDTree tree(points, 4);
+    float distance;
+    CHECK(tree.findNearest(VectorXf(Vector3f(1, 1, 2)), &distance) >= 0);
+    CHECK(distance == Approx(1.0f));
+
+    KDTree empty(MatrixXf(3, 0));
+    CHECK(empty.findNearest(VectorXf(Vector3f(1, 1, 2))) == -1);
+    CHECK(empty.findWithinRadius(VectorXf(Vector3f(1, 1, 2)), 1.0f).empty());
+    CHECK_THROWS(tree.findNearest(VectorXf(Vector2f(1, 1))));
+}
+
+TEST_CASE("KDTree vs brute force nearest point benchmark", "[fast][KDTree][benchmark][visual]") {
+    // Same number of dimensions as the position and color features used in IterativeClosestPoint
+    const int dimensions = 6;
+    for(int size : {1000, 10000, 100000}) {
+        MatrixXf points = MatrixXf::Random(dimensions, size);
+        MatrixXf queries = MatrixXf::Random(dimensions, size);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        KDTree tree(points);
+        const double buildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        start = std::chrono::high_resolution_clock::now();
+        auto result = tree.findNearest(queries);
+        const double treeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<int> bruteForceResult(queries.cols());
+#pragma omp parallel for
+        for(int i = 0; i < queries.cols(); ++i)
+            bruteForceResult[i] = findNearestBruteForce(points, queries.col(i));
+        const double bruteForceTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // Different points may have the same distance, thus compare distances instead of indices
+        int different = 0;
+        for(int i = 0; i < queries.cols(); ++i) {
+            if((points.col(result[i]) - queries.col(i)).squaredNorm() != (points.col(bruteForceResult[i]) - queries.col(i)).squaredNorm())
+                ++different;
+        }
+        CHECK(different == 0);
+        std::cout << size << " points: KDTree build " << buildTime << " ms, query " << treeTime << " ms, brute force " << bruteForceTime << " ms" << std::endl;
+    }
+}
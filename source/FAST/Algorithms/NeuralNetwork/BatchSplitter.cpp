@@ -0,0 +1,88 @@
+#include "BatchSplitter.hpp"
+#include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
+
+namespace fast {
+
+BatchSplitter::BatchSplitter() {
+    createInputPort<Batch>(0, false);
+    createOutputPort<DataObject>(0);
+    mIsModified = true;
+}
+
+void BatchSplitter::generateStream() {
+    bool lastFrame = false;
+    // Update will eventually block, therefore we need to call this in a separate thread
+    auto po = mParent->getProcessObject();
+    bool firstTime = true;
+    try {
+        while(!lastFrame) {
+            {
+                std::unique_lock<std::mutex> lock(m_stopMutex);
+                if(m_stop) {
+                    m_streamIsStarted = false;
+                    m_firstFrameIsInserted = false;
+                    break;
+                }
+            }
+            if(!firstTime) // parent is execute the first time, thus drop it here
+                po->update(); // Make sure execute is called on previous
+            firstTime = false;
+            DataObject::pointer data;
+            try {
+                data = mParent->getNextFrame();
+            } catch(ThreadStopped &e) {
+                break;
+            }
+            lastFrame = data->isLastFrame();
+            std::vector<DataObject::pointer> dataObjects;
+            if(auto batch = std::dynamic_pointer_cast<Batch>(data)) {
+                auto list = batch->get();
+                if(list.isImages()) {
+                    for(auto&& image : list.getImages())
+                        dataObjects.push_back(image);
+                } else {
+                    for(auto&& tensor : list.getTensors())
+                        dataObjects.push_back(tensor);
+                }
+            } else {
+                // Not a batch, pass it through unchanged
+                dataObjects.push_back(data);
+            }
+            try {
+                for(int i = 0; i < dataObjects.size(); ++i) {
+                    if(lastFrame && i == dataObjects.size() - 1)
+                        dataObjects[i]->setLastFrame(getNameOfClass());
+                    addOutputData(0, dataObjects[i]);
+                    frameAdded();
+                }
+            } catch(ThreadStopped &e) {
+                break;
+            }
+        }
+    } catch(std::exception &e) {
+        // Exception happened in thread. Stop pipeline, and propagate error message.
+        for(auto item : mOutputConnections) {
+            for(auto output : item.second) {
+                output.lock()->stop(e.what());
+            }
+        }
+        frameAdded(); // To unlock if happens before first frame
+    }
+}
+
+void BatchSplitter::execute() {
+    if(!m_streamIsStarted) {
+        m_streamIsStarted = true;
+        mParent = mInputConnections[0];
+        mInputConnections.clear();
+        m_thread = std::make_unique<std::thread>(std::bind(&BatchSplitter::generateStream, this));
+    }
+
+    waitForFirstFrame();
+}
+
+BatchSplitter::~BatchSplitter() {
+    stop();
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+#include <FAST/Streamers/Streamer.hpp>
+#include <thread>
+
+namespace fast {
+
+/**
+ * @brief Converts a stream of Batch data objects into a stream of the single data objects in each batch
+ *
+ * This is used to scatter the output of a NeuralNetwork processing batches back to a stream of Image or Tensor
+ * objects, in the same order as they were batched. Frame data of each sample is preserved.
+ * Data objects which are not a Batch are passed through unchanged.
+ *
+ * @ingroup neural-network
+ * @sa ImageToBatchGenerator
+ */
+class FAST_EXPORT BatchSplitter : public Streamer {
+    FAST_PROCESS_OBJECT(BatchSplitter)
+    public:
+        /**
+         * @brief Create instance
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(BatchSplitter)
+        ~BatchSplitter() override;
+    protected:
+        void execute() override;
+        void generateStream() override;
+
+        DataChannel::pointer mParent;
+};
+
+}
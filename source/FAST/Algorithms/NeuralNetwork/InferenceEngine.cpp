@@ -86,6 +86,61 @@ int InferenceEngine::getMaxBatchSize() {
     return m_maxBatchSize;
 }
 
+void InferenceEngine::setNumberOfThreads(int intraOpThreads, int interOpThreads) {
+    if(intraOpThreads < 0 || interOpThreads < 0)
+        throw Exception("Number of threads must be >= 0");
+    m_intraOpThreads = intraOpThreads;
+    m_interOpThreads = interOpThreads;
+}
+
+int InferenceEngine::getNumberOfIntraOpThreads() const {
+    return m_intraOpThreads;
+}
+
+int InferenceEngine::getNumberOfInterOpThreads() const {
+    return m_interOpThreads;
+}
+
+void InferenceEngine::setUseGlobalThreadPool(bool useGlobalThreadPool) {
+    m_useGlobalThreadPool = useGlobalThreadPool;
+}
+
+bool InferenceEngine::getUseGlobalThreadPool() const {
+    return m_useGlobalThreadPool;
+}
+
+void InferenceEngine::setGraphOptimizationLevel(GraphOptimizationLevel level) {
+    m_graphOptimizationLevel = level;
+}
+
+GraphOptimizationLevel InferenceEngine::getGraphOptimizationLevel() const {
+    return m_graphOptimizationLevel;
+}
+
+void InferenceEngine::setMemoryPattern(bool enable) {
+    m_memoryPattern = enable;
+}
+
+bool InferenceEngine::getMemoryPattern() const {
+    return m_memoryPattern;
+}
+
+void InferenceEngine::setMemoryArena(bool enable) {
+    m_memoryArena = enable;
+}
+
+bool InferenceEngine::getMemoryArena() const {
+    return m_memoryArena;
+}
+
+void InferenceEngine::setOptimizedModelCaching(bool cache) {
+    m_optimizedModelCaching = cache;
+}
+
+bool InferenceEngine::getOptimizedModelCaching() const {
+    return m_optimizedModelCaching;
+}
+
 void InferenceEngine::loadCustomPlugins(std::vector<std::string> filenames) {
     throw NotImplementedException();
 }
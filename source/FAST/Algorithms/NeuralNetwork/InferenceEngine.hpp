@@ -35,6 +35,16 @@ enum class InferenceDeviceType {
     OTHER,
 };
 
+/**
+ * @brief Level of graph optimizations performed by the inference engine when loading a model
+ */
+enum class GraphOptimizationLevel {
+    Disabled,
+    Basic,
+    Extended,
+    All,
+};
+
 struct InferenceDeviceInfo {
     std::string name;
     InferenceDeviceType type;
@@ -158,6 +168,54 @@ class FAST_EXPORT InferenceEngine : public Object {
 
         virtual int getMaxBatchSize();
         virtual void setMaxBatchSize(int size);
+        /**
+         * @brief Set number of CPU threads the inference engine may use. Must be called before load()
+         *
+         * Running several networks in the same process with the default settings, may oversubscribe the CPU cores.
+         * Not all inference engines support this.
+         *
+         * @param intraOpThreads Threads used to parallelize the execution of a single operation. 0 means engine default.
+         * @param interOpThreads Threads used to execute independent operations in parallel. 0 means engine default.
+         */
+        virtual void setNumberOfThreads(int intraOpThreads, int interOpThreads = 0);
+        virtual int getNumberOfIntraOpThreads() const;
+        virtual int getNumberOfInterOpThreads() const;
+        /**
+         * @brief Use one thread pool shared by all networks of this inference engine, instead of one per network.
+         * Must be called before load()
+         *
+         * The number of threads of the shared pool is decided by the first network which is loaded with this enabled.
+         *
+         * @param useGlobalThreadPool
+         */
+        virtual void setUseGlobalThreadPool(bool useGlobalThreadPool);
+        virtual bool getUseGlobalThreadPool() const;
+        /**
+         * @brief Set level of graph optimizations performed when loading the model. Must be called before load()
+         * @param level
+         */
+        virtual void setGraphOptimizationLevel(GraphOptimizationLevel level);
+        virtual GraphOptimizationLevel getGraphOptimizationLevel() const;
+        /**
+         * @brief Enable/disable memory pattern optimization, which pre-allocates memory based on
+         * the first run when input shapes are fixed. Must be called before load()
+         * @param enable
+         */
+        virtual void setMemoryPattern(bool enable);
+        virtual bool getMemoryPattern() const;
+        /**
+         * @brief Enable/disable arena allocator for CPU memory. Must be called before load()
+         * @param enable
+         */
+        virtual void setMemoryArena(bool enable);
+        virtual bool getMemoryArena() const;
+        /**
+         * @brief Store the optimized model on disk, and load it instead of the original model next time to reduce
+         * startup time. Must be called before load()
+         * @param cache
+         */
+        virtual void setOptimizedModelCaching(bool cache);
+        virtual bool getOptimizedModelCaching() const;
         /**
          * Load a custom operator (op), plugin. Must be called before load()
          *
@@ -193,6 +251,13 @@ class FAST_EXPORT InferenceEngine : public Object {
         int m_deviceIndex = -1;
         InferenceDeviceType m_deviceType = InferenceDeviceType::ANY;
         int m_maxBatchSize = 1;
+        int m_intraOpThreads = 0;
+        int m_interOpThreads = 0;
+        bool m_useGlobalThreadPool = false;
+        GraphOptimizationLevel m_graphOptimizationLevel = GraphOptimizationLevel::All;
+        bool m_memoryPattern = true;
+        bool m_memoryArena = true;
+        bool m_optimizedModelCaching = false;
 
         std::vector<uint8_t> m_model;
         std::vector<uint8_t> m_weights;
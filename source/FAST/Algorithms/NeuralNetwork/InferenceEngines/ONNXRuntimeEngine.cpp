@@ -8,6 +8,10 @@
 #endif
 
 #include <FAST/Config.hpp>
+#include <FAST/Utility.hpp>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
 
 namespace fast {
 
@@ -23,99 +27,272 @@ std::string print_shape(const std::vector<int64_t>& v) {
 
 void ONNXRuntimeEngine::run() {
 	//auto start = std::chrono::high_resolution_clock::now();
-    std::vector<const char*> inputNames;
+    Ort::MemoryInfo info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeCPU); // Must be TypeCPU to work on CPU
+    Ort::IoBinding binding(*m_session);
+    // ONNX Runtime reads the input data directly, thus the accesses must be kept until the network has been run
+    std::vector<TensorAccess::pointer> inputAccesses;
     std::vector<Ort::Value> inputTensors;
-	// Important to use reference here, as we are using c_str() which does not copy string, and will be deleted if std::string is deleted.
+    inputTensors.reserve(mInputNodes.size());
+    int batchSize = -1;
     for (const auto& inputNode : mInputNodes) {
         auto tensor = inputNode.second.data;
         auto access = tensor->getAccess(ACCESS_READ);
-		inputNames.push_back(strdup(inputNode.first.c_str()));
         float* tensorData = access->getRawData();
-        reportInfo() << "ONNXRuntime: Creating memory info.." << reportEnd();
-        Ort::MemoryInfo info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeCPU); // Must be TypeCPU to work on CPU
         auto shape = tensor->getShape();
+        if(batchSize < 0)
+            batchSize = shape[0];
 
         std::vector<int64_t> dims;
         for (int x : shape.getAll())
             dims.push_back(x);
         inputTensors.emplace_back(Ort::Value::CreateTensor<float>(info, tensorData, shape.getTotalSize(), dims.data(), shape.getDimensions()));
+        binding.BindInput(inputNode.first.c_str(), inputTensors.back());
+        inputAccesses.push_back(std::move(access));
     }
-    std::vector<const char*> outputNames;
-	// Important to use reference here, as we are using c_str() which does not copy string, and will be deleted if std::string is deleted.
+
+    // Let ONNX Runtime write the output directly to buffers which are reused when FAST is done with them.
+    // If the output shape is not known in advance, ONNX Runtime allocates the output instead.
+    for (auto& outputNode : mOutputNodes)
+        outputNode.second.data.reset(); // Release previous output, so that its buffer may be reused
+    std::map<std::string, std::shared_ptr<float[]>> outputBuffers;
+    std::vector<Ort::Value> outputTensors;
+    outputTensors.reserve(mOutputNodes.size());
     for (const auto& outputNode : mOutputNodes) {
-        outputNames.push_back(outputNode.first.c_str());
+        const auto& name = outputNode.first;
+        auto shape = m_modelOutputShapes.count(name) > 0 ? m_modelOutputShapes[name] : TensorShape();
+        if(!shape.empty() && shape[0] < 0)
+            shape[0] = batchSize;
+        if(m_preallocateOutputs && !shape.empty() && shape.getUnknownDimensions() == 0) {
+            auto buffer = getOutputBuffer(name, shape.getTotalSize());
+            std::vector<int64_t> dims;
+            for(int x : shape.getAll())
+                dims.push_back(x);
+            outputTensors.emplace_back(Ort::Value::CreateTensor<float>(info, buffer.get(), shape.getTotalSize(), dims.data(), dims.size()));
+            binding.BindOutput(name.c_str(), outputTensors.back());
+            outputBuffers[name] = buffer;
+        } else {
+            binding.BindOutput(name.c_str(), info);
+        }
     }
-		
+
     Ort::RunOptions runOptions;
     reportInfo() << "Running ONNX runtime .." << reportEnd();
-    std::vector<Ort::Value> output = m_session->Run(runOptions, inputNames.data(), inputTensors.data(), inputNames.size(), outputNames.data(), outputNames.size());
+    try {
+        m_session->Run(runOptions, binding);
+    } catch(Ort::Exception& e) {
+        if(outputBuffers.empty())
+            throw;
+        // Output shape of the model may depend on the input in other ways than the batch size
+        reportWarning() << "Running ONNX Runtime with preallocated outputs failed: " << e.what() << ". Letting ONNX Runtime allocate outputs instead." << reportEnd();
+        m_preallocateOutputs = false;
+        m_outputBuffers.clear();
+        binding.ClearBoundOutputs();
+        outputBuffers.clear();
+        for (const auto& outputNode : mOutputNodes)
+            binding.BindOutput(outputNode.first.c_str(), info);
+        m_session->Run(runOptions, binding);
+    }
     reportInfo() << "Finished run ONNX runtime" << reportEnd();
     //std::chrono::duration<float, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
     //std::cout << "Run: " << duration.count() << std::endl;
 
-    // Copy output data to FAST
+    // Give output data to FAST without copying it
+    std::vector<Ort::Value> output = binding.GetOutputValues();
     int counter = 0;
     for(auto& outputNode : mOutputNodes) {
-        const float* data = output[counter].GetTensorData<float>();
         // Get shape of output tensor
         auto shape = TensorShape();
         for(int x : output[counter].GetTensorTypeAndShapeInfo().GetShape()) {
             shape.addDimension(x);
         }
-        const auto name = outputNode.first;
+        std::shared_ptr<float[]> data;
+        if(outputBuffers.count(outputNode.first) > 0) {
+            data = outputBuffers[outputNode.first];
+        } else {
+            // The tensor takes ownership of the output allocated by ONNX Runtime
+            auto value = std::make_shared<Ort::Value>(std::move(output[counter]));
+            data = std::shared_ptr<float[]>(value, value->GetTensorMutableData<float>());
+        }
         outputNode.second.shape = shape;
-        auto outputTensor = Tensor::create(data, shape);
-        outputNode.second.data = outputTensor;
+        outputNode.second.data = Tensor::create(data, shape);
         ++counter;
     }
 }
 
+std::shared_ptr<float[]> ONNXRuntimeEngine::getOutputBuffer(const std::string& name, std::size_t size) {
+    auto& buffers = m_outputBuffers[name];
+    for(auto& buffer : buffers) {
+        // Buffer can only be reused if no tensors are referring to it anymore
+        if(buffer.first == size && buffer.second.use_count() == 1)
+            return buffer.second;
+    }
+    std::shared_ptr<float[]> buffer = make_uninitialized_unique<float[]>(size);
+    // Remove buffers of other sizes, e.g. from a different batch size
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [size](const std::pair<std::size_t, std::shared_ptr<float[]>>& buffer) {
+        return buffer.first != size;
+    }), buffers.end());
+    if(buffers.size() < m_maximumNumberOfOutputBuffers)
+        buffers.push_back({size, buffer});
+    return buffer;
+}
+
+
+// Environment with thread pools shared by all sessions which are created with per session threads disabled
+static std::mutex globalEnvironmentMutex;
+static std::shared_ptr<Ort::Env> globalEnvironment;
+
+static std::shared_ptr<Ort::Env> getGlobalEnvironment(int intraOpThreads, int interOpThreads) {
+    std::lock_guard<std::mutex> lock(globalEnvironmentMutex);
+    if(!globalEnvironment) {
+        Ort::ThreadingOptions threadingOptions;
+        if(intraOpThreads > 0)
+            threadingOptions.SetGlobalIntraOpNumThreads(intraOpThreads);
+        if(interOpThreads > 0)
+            threadingOptions.SetGlobalInterOpNumThreads(interOpThreads);
+        globalEnvironment = std::make_shared<Ort::Env>(threadingOptions, ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime");
+    }
+    return globalEnvironment;
+}
+
+static ::GraphOptimizationLevel toOrtGraphOptimizationLevel(fast::GraphOptimizationLevel level) {
+    switch(level) {
+        case fast::GraphOptimizationLevel::Disabled:
+            return ORT_DISABLE_ALL;
+        case fast::GraphOptimizationLevel::Basic:
+            return ORT_ENABLE_BASIC;
+        case fast::GraphOptimizationLevel::Extended:
+            return ORT_ENABLE_EXTENDED;
+        default:
+            return ORT_ENABLE_ALL;
+    }
+}
+
+static std::basic_string<ORTCHAR_T> toOrtPath(const std::string& path) {
+    return std::basic_string<ORTCHAR_T>(path.begin(), path.end());
+}
+
 void ONNXRuntimeEngine::load() {
     const auto filename = getFilename();
-    std::wstring wideStr(filename.begin(), filename.end());
+    m_modelOutputShapes.clear();
+    m_outputBuffers.clear();
+    m_preallocateOutputs = true;
 
 	reportInfo() << "Setting up ONNX Runtime" << reportEnd();
     //auto start = std::chrono::high_resolution_clock::now();
-	m_env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime");
+    // May fall back to per session threads for this session, without changing the setting
+    bool useGlobalThreadPool = m_useGlobalThreadPool;
+    if(useGlobalThreadPool) {
+        m_env = getGlobalEnvironment(m_intraOpThreads, m_interOpThreads);
+    } else {
+        m_env = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime");
+    }
+
+    // Optimized models may contain hardware specific operations, thus they are only cached for the CPU execution provider
+    const std::string ortVersion = OrtGetApiBase()->GetVersionString();
+    const std::size_t hash = std::hash<std::string>{}(filename + std::to_string((int)m_graphOptimizationLevel));
+    const std::string optimizedFilename = join(Config::getKernelBinaryPath(), getFileName(filename) + "_" + std::to_string(hash) + ".optimized.onnx");
+    const std::string optimizedCacheFilename = join(Config::getKernelBinaryPath(), getFileName(filename) + "_" + std::to_string(hash) + ".optimized.cache");
+    bool loadOptimizedModel = false;
+    if(m_optimizedModelCaching && fileExists(optimizedFilename) && fileExists(optimizedCacheFilename)) {
+        // Optimized model must be created from the same model file with the same ONNX Runtime version
+        std::ifstream file(optimizedCacheFilename.c_str());
+        std::string modifiedDate, version;
+        std::getline(file, modifiedDate);
+        std::getline(file, version);
+        trim(modifiedDate);
+        trim(version);
+        loadOptimizedModel = modifiedDate == getModifiedDate(filename) && version == ortVersion;
+        if(loadOptimizedModel) {
+            reportInfo() << "[ONNXRuntime] Optimized model " << optimizedFilename << " is up to date." << reportEnd();
+        } else {
+            reportInfo() << "[ONNXRuntime] Optimized model " << optimizedFilename << " was not up to date." << reportEnd();
+        }
+    }
+
+    auto createSessionOptions = [&](bool cpu) {
+        Ort::SessionOptions options;
+        if(useGlobalThreadPool) {
+            options.DisablePerSessionThreads();
+        } else {
+            if(m_intraOpThreads > 0)
+                options.SetIntraOpNumThreads(m_intraOpThreads);
+            if(m_interOpThreads > 0)
+                options.SetInterOpNumThreads(m_interOpThreads);
+        }
+        // Inter op threads are only used when independent nodes can be executed in parallel
+        if(m_interOpThreads > 1)
+            options.SetExecutionMode(ORT_PARALLEL);
+        if(!m_memoryPattern)
+            options.DisableMemPattern();
+        if(!m_memoryArena)
+            options.DisableCpuMemArena();
+        if(cpu && m_optimizedModelCaching && loadOptimizedModel) {
+            // Model is already optimized
+            options.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
+        } else {
+            options.SetGraphOptimizationLevel(toOrtGraphOptimizationLevel(m_graphOptimizationLevel));
+            if(cpu && m_optimizedModelCaching) {
+                createDirectories(Config::getKernelBinaryPath());
+                options.SetOptimizedModelFilePath(toOrtPath(optimizedFilename).c_str());
+            }
+        }
+        return options;
+    };
+    auto createSession = [&](Ort::SessionOptions& options, bool cpu) {
+        const std::string path = cpu && m_optimizedModelCaching && loadOptimizedModel ? optimizedFilename : filename;
+        try {
+            m_session = std::make_unique<Ort::Session>(*m_env, toOrtPath(path).c_str(), options);
+        } catch(Ort::Exception& e) {
+            if(!useGlobalThreadPool)
+                throw;
+            // The environment of ONNX Runtime is shared by the entire process. If it was created before without
+            // global thread pools, sessions have to use their own threads.
+            reportWarning() << "Unable to use global thread pool in ONNX Runtime: " << e.what() << ". Using per session threads instead." << reportEnd();
+            useGlobalThreadPool = false;
+            Ort::SessionOptions fallbackOptions = createSessionOptions(cpu);
+            m_session = std::make_unique<Ort::Session>(*m_env, toOrtPath(path).c_str(), fallbackOptions);
+        }
+        if(cpu && m_optimizedModelCaching && !loadOptimizedModel) {
+            std::ofstream file(optimizedCacheFilename.c_str());
+            file << getModifiedDate(filename) << "\n" << ortVersion << "\n";
+        }
+    };
+
     if(m_deviceType == InferenceDeviceType::CPU) {
-		Ort::SessionOptions session_options;
-#ifdef WIN32
-		m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
-#else
-		m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
-#endif
+		Ort::SessionOptions session_options = createSessionOptions(true);
+        createSession(session_options, true);
     } else {
 #ifdef WIN32
         try {
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(false);
             SetDllDirectory(Config::getLibraryPath().c_str()); // Make sure delay-load dlls are found (directml.dll) etc.
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_DML(session_options, 0));
             session_options.DisableMemPattern();
-            m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
+            createSession(session_options, false);
             SetDllDirectory("");
         }
         catch (Ort::Exception& e) {
             reportWarning() << "Exception occured while trying to load DirectML for ONNXRuntime with message: (" << e.GetOrtErrorCode() << ") " << e.what()  << ". Falling back to CPU." << reportEnd();
-            Ort::SessionOptions session_options;
-            m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
+            Ort::SessionOptions session_options = createSessionOptions(true);
+            createSession(session_options, true);
         }
 #elif defined(__APPLE__) || defined(__MACOSX)
         // APPLE
         try {
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(false);
             uint32_t coreml_flags = 0;
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(session_options, coreml_flags));
-            m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+            createSession(session_options, false);
         }
         catch (Ort::Exception& e) {
             reportWarning() << "Exception occured while trying to load CoreML for ONNXRuntime with message: (" << e.GetOrtErrorCode() << ") " << e.what() << ". Falling back to CPU." << reportEnd();
-            Ort::SessionOptions session_options;
-            m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+            Ort::SessionOptions session_options = createSessionOptions(true);
+            createSession(session_options, true);
         }
 #else
         // LINUX (only CPU available)
-        Ort::SessionOptions session_options;
-        m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+        Ort::SessionOptions session_options = createSessionOptions(true);
+        createSession(session_options, true);
 #endif
     }
 	Ort::AllocatorWithDefaultOptions allocator;
@@ -161,6 +338,7 @@ void ONNXRuntimeEngine::load() {
 		for (int x : m_session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape()) {
 			shape.addDimension(x);
 		}
+		m_modelOutputShapes[name] = shape;
 		NodeType type = detectNodeType(shape);
 		if(outputsDefined) {
 			if(mOutputNodes.count(name) > 0) {
@@ -44,8 +44,16 @@ public:
 	 */
 	std::vector<InferenceDeviceInfo> getDeviceList() override;
 private:
+	std::shared_ptr<float[]> getOutputBuffer(const std::string& name, std::size_t size);
+	// Environment must outlive the session, and may be shared with other engines when using the global thread pool
+	std::shared_ptr<Ort::Env> m_env;
 	std::unique_ptr<Ort::Session> m_session;
-	std::unique_ptr<Ort::Env> m_env;
+	// Output shapes as specified by the model, unknown dimensions are -1
+	std::map<std::string, TensorShape> m_modelOutputShapes;
+	// Preallocated output buffers with their size, which are reused when no tensor refer to them anymore
+	std::map<std::string, std::vector<std::pair<std::size_t, std::shared_ptr<float[]>>>> m_outputBuffers;
+	const std::size_t m_maximumNumberOfOutputBuffers = 4;
+	bool m_preallocateOutputs = true;
 };
 
 DEFINE_INFERENCE_ENGINE(ONNXRuntimeEngine, INFERENCEENGINEONNXRUNTIME_EXPORT)
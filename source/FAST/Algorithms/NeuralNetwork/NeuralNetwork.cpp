@@ -3,6 +3,7 @@
 #include "FAST/Data/Tensor.hpp"
 #include "FAST/Algorithms/ImageResizer/ImageResizer.hpp"
 #include "InferenceEngineManager.hpp"
+#include <type_traits>
 
 
 namespace fast {
@@ -33,6 +34,26 @@ void NeuralNetwork::loadAttributes() {
         reportInfo() << "Selected " << getInferenceEngine()->getName() << " as the best engine for format " << getModelFormatName(format) << reportEnd();
     }
 
+    // Inference engine performance settings, must be set before loading
+    auto engine = getInferenceEngine();
+    engine->setNumberOfThreads(getIntegerAttribute("intra-op-threads"), getIntegerAttribute("inter-op-threads"));
+    engine->setUseGlobalThreadPool(getBooleanAttribute("global-thread-pool"));
+    engine->setMemoryPattern(getBooleanAttribute("memory-pattern"));
+    engine->setMemoryArena(getBooleanAttribute("memory-arena"));
+    engine->setOptimizedModelCaching(getBooleanAttribute("cache-optimized-model"));
+    auto optimization = getStringAttribute("graph-optimization");
+    if(optimization == "disabled") {
+        engine->setGraphOptimizationLevel(GraphOptimizationLevel::Disabled);
+    } else if(optimization == "basic") {
+        engine->setGraphOptimizationLevel(GraphOptimizationLevel::Basic);
+    } else if(optimization == "extended") {
+        engine->setGraphOptimizationLevel(GraphOptimizationLevel::Extended);
+    } else if(optimization == "all") {
+        engine->setGraphOptimizationLevel(GraphOptimizationLevel::All);
+    } else {
+        throw Exception("Incorrect graph-optimization: " + optimization + ". Should be disabled, basic, extended or all");
+    }
+
     // If input and/or output nodes names and shapes are defined:
     for(std::string inputOrOutput : {"input", "output"}) {
         auto nodes = getStringListAttribute(inputOrOutput + "-nodes");
@@ -135,6 +156,13 @@ NeuralNetwork::NeuralNetwork() {
 	createBooleanAttribute("signed-input-normalization", "Signed input normalization", "Normalize input to -1 and 1 instead of 0 to 1.", false);
     createBooleanAttribute("preserve-aspect", "Preserve aspect ratio of input images", "", mPreserveAspectRatio);
     createStringAttribute("dimension-ordering", "Dimension ordering", "Dimension ordering (channel-last or channel-first), will override auto detecting if set.", "");
+    createIntegerAttribute("intra-op-threads", "Intra-op threads", "Number of threads used to parallelize a single operation. 0 means inference engine default.", 0);
+    createIntegerAttribute("inter-op-threads", "Inter-op threads", "Number of threads used to execute independent operations in parallel. 0 means inference engine default.", 0);
+    createBooleanAttribute("global-thread-pool", "Global thread pool", "Share one thread pool between all networks using the same inference engine.", false);
+    createStringAttribute("graph-optimization", "Graph optimization level", "Graph optimization level (disabled, basic, extended or all)", "all");
+    createBooleanAttribute("memory-pattern", "Memory pattern", "Pre-allocate memory based on the first run.", true);
+    createBooleanAttribute("memory-arena", "Memory arena", "Use arena allocator for CPU memory.", true);
+    createBooleanAttribute("cache-optimized-model", "Cache optimized model", "Store the optimized model on disk to reduce startup time.", false);
 
 	m_engine = InferenceEngineManager::loadBestAvailableEngine();
 	reportInfo() << "Inference engine " << m_engine->getName() << " selected" << reportEnd();
@@ -275,7 +303,17 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
                         }
                     }
                     shape[0] = m_batchSize;
-                    tensors[inputNode.first] = convertImagesToTensor(inputImages, shape, containsSequence);
+                    if(getMainDevice()->isHost()) {
+                        tensors[inputNode.first] = convertImagesToTensorHost(inputImages, shape, containsSequence);
+                    } else {
+                        tensors[inputNode.first] = convertImagesToTensor(inputImages, shape, containsSequence);
+                    }
+                } else if(getMainDevice()->isHost()) {
+                    // Resize and normalize in one pass on the host, without OpenCL
+                    shape[0] = m_batchSize;
+                    mRuntimeManager->startRegularTimer("image input resize and normalization");
+                    tensors[inputNode.first] = convertImagesToTensorHost(inputImages, shape, containsSequence);
+                    mRuntimeManager->stopRegularTimer("image input resize and normalization");
                 } else {
                     auto inputImages2 = resizeImages(inputImages, width, height, depth);
                     // Convert images to tensors
@@ -351,19 +389,17 @@ Tensor::pointer NeuralNetwork::standardizeOutputTensorData(Tensor::pointer tenso
     // Transfer frame data and spacing information from input to output data
     for(auto& inputNode : m_engine->getInputNodes()) {
         if(mInputImages.count(inputNode.first) > 0) {
-            for(auto &&frameData : mInputImages[inputNode.first][sample]->getFrameData())
-                tensor->setFrameData(frameData.first, frameData.second);
+            tensor->addFrameData(mInputImages[inputNode.first][sample]->getFrameDataContainer());
             for(auto &&lastFrame : mInputImages[inputNode.first][sample]->getLastFrame())
                 tensor->setLastFrame(lastFrame);
             // TODO will cause issue if multiple input images:
             tensor->setSpacing(mNewInputSpacing);
-            tensor->setFrameData("network-input-size-x", std::to_string(m_newInputSize.x()));
-            tensor->setFrameData("network-input-size-y", std::to_string(m_newInputSize.y()));
-            tensor->setFrameData("network-input-size-z", std::to_string(m_newInputSize.z()));
+            tensor->setFrameData("network-input-size-x", m_newInputSize.x());
+            tensor->setFrameData("network-input-size-y", m_newInputSize.y());
+            tensor->setFrameData("network-input-size-z", m_newInputSize.z());
             SceneGraph::setParentNode(tensor, mInputImages[inputNode.first][sample]);
         } else {
-            for(auto &&frameData : mInputTensors[inputNode.first][sample]->getFrameData())
-                tensor->setFrameData(frameData.first, frameData.second);
+            tensor->addFrameData(mInputTensors[inputNode.first][sample]->getFrameDataContainer());
             for(auto &&lastFrame : mInputTensors[inputNode.first][sample]->getLastFrame())
                 tensor->setLastFrame(lastFrame);
             SceneGraph::setParentNode(tensor, mInputTensors[inputNode.first][sample]);
@@ -407,23 +443,10 @@ void NeuralNetwork::processOutputTensors() {
         }
 
         if(m_batchSize > 1) {
-            // Create a batch of tensors
+            // Create a batch of tensors, each sample is a view of the batch tensor to avoid copying
             std::vector<Tensor::pointer> tensorList;
-            auto tensorAccess = tensor->getAccess(ACCESS_READ);
-            const float* rawTensorData = tensorAccess->getRawData();
-            // Calculate sample size
-            auto shape = tensor->getShape();
-            int size = 1;
-            auto newShape = TensorShape();
-            for(int i = 1; i < shape.getDimensions(); ++i) {
-                size *= shape[i];
-                newShape.addDimension(shape[i]);
-            }
-
             for(int i = 0; i < m_batchSize; ++i) {
-                auto newData = make_uninitialized_unique<float[]>(size);
-                std::memcpy(newData.get(), &(rawTensorData[i*size]), size*sizeof(float));
-                auto newTensor = Tensor::create(std::move(newData), newShape);
+                auto newTensor = tensor->getSubTensor(i);
                 newTensor = standardizeOutputTensorData(newTensor, i);
                 tensorList.push_back(newTensor);
             }
@@ -453,6 +476,177 @@ void NeuralNetwork::execute() {
     }
 }
 
+/**
+ * Precomputed linear interpolation of one axis, equal to OpenCL linear sampling with
+ * normalized coordinates and clamp to edge.
+ */
+struct InterpolationTable {
+    std::vector<int> index0;
+    std::vector<int> index1;
+    std::vector<float> weight;
+    InterpolationTable(int inputSize, int outputSize, int validOutputSize) {
+        index0.resize(outputSize);
+        index1.resize(outputSize);
+        weight.resize(outputSize);
+        const float scale = (float)inputSize / validOutputSize;
+        for(int i = 0; i < outputSize; ++i) {
+            const float position = ((float)i + 0.5f)*scale - 0.5f;
+            const int base = (int)std::floor(position);
+            index0[i] = std::min(std::max(base, 0), inputSize - 1);
+            index1[i] = std::min(std::max(base + 1, 0), inputSize - 1);
+            weight[i] = position - base;
+        }
+    }
+};
+
+/**
+ * Resize, normalize, reorder channels and flip a single image on the host, and write it directly to output.
+ * Same as ImageResizer followed by the normalize2DInput/normalize3DInput kernels.
+ */
+template <class T>
+static void normalizeInputHost(const T* input, float* output, Vector3i inputSize, Vector3i outputSize, int validHeight,
+                               int channels, bool channelFirst, bool horizontalFlip, float scaleFactor, float mean,
+                               float std, bool signedInputNormalization, bool clipIntensity, float minIntensity, float maxIntensity) {
+    const bool resize = inputSize != outputSize;
+    // ImageResizer stores the resized image with the input data type
+    const bool truncate = resize && !std::is_floating_point<T>::value;
+    const InterpolationTable tableX(inputSize.x(), outputSize.x(), outputSize.x());
+    const InterpolationTable tableY(inputSize.y(), outputSize.y(), validHeight);
+    const InterpolationTable tableZ(inputSize.z(), outputSize.z(), outputSize.z());
+    const int width = outputSize.x();
+    const int height = outputSize.y();
+    const int depth = outputSize.z();
+    const std::size_t channelSize = (std::size_t)width*height*depth;
+    // Combine (v - mean)/std*scale and optional v*2 - 1 into a single multiply-add
+    float multiplier = scaleFactor/std;
+    float offset = -mean*scaleFactor/std;
+    if(signedInputNormalization) {
+        multiplier *= 2.0f;
+        offset = offset*2.0f - 1.0f;
+    }
+
+    #pragma omp parallel for
+    for(int row = 0; row < depth*height; ++row) {
+        const int z = row / height;
+        const int y = row % height;
+        const T* slice0 = input + (std::size_t)tableZ.index0[z]*inputSize.x()*inputSize.y()*channels;
+        const T* slice1 = input + (std::size_t)tableZ.index1[z]*inputSize.x()*inputSize.y()*channels;
+        const T* rows[4] = {
+            slice0 + (std::size_t)tableY.index0[y]*inputSize.x()*channels,
+            slice0 + (std::size_t)tableY.index1[y]*inputSize.x()*channels,
+            slice1 + (std::size_t)tableY.index0[y]*inputSize.x()*channels,
+            slice1 + (std::size_t)tableY.index1[y]*inputSize.x()*channels,
+        };
+        const float wy = tableY.weight[y];
+        const float wz = tableZ.weight[z];
+        const bool outside = y >= validHeight; // Padding when preserving aspect ratio
+        const std::size_t rowOffset = ((std::size_t)z*height + y)*width;
+        for(int x = 0; x < width; ++x) {
+            const int x0 = tableX.index0[x]*channels;
+            const int x1 = tableX.index1[x]*channels;
+            const float wx = tableX.weight[x];
+            const int outputX = horizontalFlip ? width - x - 1 : x;
+            for(int c = 0; c < channels; ++c) {
+                float value = 0.0f;
+                if(!outside) {
+                    const float v00 = rows[0][x0 + c] + wx*(rows[0][x1 + c] - rows[0][x0 + c]);
+                    const float v10 = rows[1][x0 + c] + wx*(rows[1][x1 + c] - rows[1][x0 + c]);
+                    const float v01 = rows[2][x0 + c] + wx*(rows[2][x1 + c] - rows[2][x0 + c]);
+                    const float v11 = rows[3][x0 + c] + wx*(rows[3][x1 + c] - rows[3][x0 + c]);
+                    const float v0 = v00 + wy*(v10 - v00);
+                    const float v1 = v01 + wy*(v11 - v01);
+                    value = v0 + wz*(v1 - v0);
+                    if(truncate)
+                        value = std::trunc(value);
+                }
+                if(clipIntensity)
+                    value = std::min(std::max(value, minIntensity), maxIntensity);
+                value = value*multiplier + offset;
+                if(channelFirst) {
+                    output[c*channelSize + rowOffset + outputX] = value;
+                } else {
+                    output[(rowOffset + outputX)*channels + c] = value;
+                }
+            }
+        }
+    }
+}
+
+Tensor::pointer NeuralNetwork::convertImagesToTensorHost(std::vector<Image::pointer> images, const TensorShape& shape, bool temporal) {
+    if(shape.getUnknownDimensions() > 0)
+        throw Exception("Shape must be known at this time");
+
+    const bool channelFirst = m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst;
+    const int dims = shape.getDimensions();
+    int channels = shape[dims-1];
+    int width = shape[dims-2];
+    int height = shape[dims-3];
+    int depth = 1;
+    if(channelFirst) {
+        channels = shape[dims-3];
+        width = shape[dims-1];
+        height = shape[dims-2];
+    }
+    if(temporal && shape[0] != 1)
+        throw Exception("Batch of sequences for NN processing not supported yet!");
+    if(images[0]->getDimensions() == 2) {
+        if((!temporal && shape.getDimensions() != 4) || (temporal && shape.getDimensions() != 5))
+            throw Exception("Incorrect shape size");
+    } else {
+        if((!temporal && shape.getDimensions() != 5) || (temporal && shape.getDimensions() != 6))
+            throw Exception("Incorrect shape size");
+        if(channelFirst) {
+            channels = shape[dims-4];
+            depth = shape[dims-3];
+        } else {
+            depth = shape[dims-4];
+        }
+    }
+    m_newInputSize = Vector3i(width, height, depth);
+
+    // Write directly into the tensor which is given to the inference engine
+    auto tensor = Tensor::create(shape);
+    auto tensorAccess = tensor->getAccess(ACCESS_READ_WRITE);
+    float* values = tensorAccess->getRawData();
+    const std::size_t size = (std::size_t)width*height*depth*channels; // nr of elements per image
+    for(int i = 0; i < images.size(); ++i) {
+        auto image = images[i];
+        if(image->getNrOfChannels() != channels)
+            throw Exception("Input image sent to executeNetwork has incorrect nr of channels: " +
+                    std::to_string(image->getNrOfChannels())+ ". Expected: " + std::to_string(channels) + ".");
+        const Vector3i inputSize(image->getWidth(), image->getHeight(), image->getDepth());
+        int validHeight = height;
+        if(inputSize != m_newInputSize) {
+            // Same spacing as the output of ImageResizer
+            if(mPreserveAspectRatio) {
+                if(image->getDimensions() == 3)
+                    throw NotImplementedException();
+                const float scale = (float)image->getWidth() / width;
+                validHeight = std::min(height, (int)std::round(image->getHeight()/scale));
+                mNewInputSpacing = Vector3f(image->getSpacing().x()*scale, image->getSpacing().y()*scale, 1.0f);
+            } else {
+                mNewInputSpacing = Vector3f(
+                        image->getSpacing().x()*((float)image->getWidth()/width),
+                        image->getSpacing().y()*((float)image->getHeight()/height),
+                        image->getDimensions() == 2 ? 1.0f : image->getSpacing().z()*((float)image->getDepth()/depth)
+                );
+            }
+        } else {
+            mNewInputSpacing = image->getSpacing();
+        }
+        // As with normalize3DInput, only 2D images are flipped
+        const bool flip = mHorizontalImageFlipping && image->getDimensions() == 2;
+        auto access = image->getImageAccess(ACCESS_READ);
+        switch(image->getDataType()) {
+            fastSwitchTypeMacro(normalizeInputHost<FAST_TYPE>((const FAST_TYPE*)access->get(), values + i*size, inputSize,
+                    m_newInputSize, validHeight, channels, channelFirst, flip, mScaleFactor, mMean, mStd,
+                    mSignedInputNormalization, mMinAndMaxIntensitySet, mMinIntensity, mMaxIntensity))
+        }
+    }
+
+    return tensor;
+}
+
 Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer> images, const TensorShape& shape, bool temporal) {
     if(shape.getUnknownDimensions() > 0)
         throw Exception("Shape must be known at this time");
@@ -272,6 +272,11 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
         std::unordered_map<std::string, Tensor::pointer> processInputData();
         std::vector<std::shared_ptr<Image>> resizeImages(const std::vector<std::shared_ptr<Image>>& images, int width, int height, int depth);
         Tensor::pointer convertImagesToTensor(std::vector<std::shared_ptr<Image>> image, const TensorShape& shape, bool temporal);
+        /**
+         * Resize, normalize and convert images to a tensor on the host. Used instead of ImageResizer and
+         * convertImagesToTensor when the main device is the host.
+         */
+        Tensor::pointer convertImagesToTensorHost(std::vector<std::shared_ptr<Image>> images, const TensorShape& shape, bool temporal);
 
         /**
          * Converts a tensor to channel last image ordering and takes care of frame data and spacing
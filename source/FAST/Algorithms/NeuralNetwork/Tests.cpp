@@ -406,6 +406,30 @@ TEST_CASE("Dynamic input shapes", "[fast][dynamicshapes]") {
     network->run();
 }
 
+TEST_CASE("NN host and OpenCL input preprocessing give same result", "[fast][neuralnetwork]") {
+    auto image = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd")
+            ->runAndGetOutputData<Image>();
+    for(bool flip : {false, true}) {
+        std::vector<Tensor::pointer> results;
+        for(bool host : {false, true}) {
+            auto network = NeuralNetwork::New();
+            network->load(join(Config::getTestDataPath(), "NeuralNetworkModels/jugular_vein_segmentation." +
+                    getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+            network->setScaleFactor(1.0f / 255.0f);
+            network->setHorizontalFlipping(flip);
+            if(host)
+                network->setMainDevice(Host::getInstance());
+            network->setInputData(image);
+            results.push_back(network->runAndGetOutputData<Tensor>());
+        }
+        REQUIRE(results[0]->getShape() == results[1]->getShape());
+        auto access0 = results[0]->getAccess(ACCESS_READ);
+        auto access1 = results[1]->getAccess(ACCESS_READ);
+        for(int i = 0; i < results[0]->getShape().getTotalSize(); ++i)
+            REQUIRE(access0->getRawData()[i] == Approx(access1->getRawData()[i]).margin(0.01));
+    }
+}
+
 #include "VertexTensorToSegmentation.hpp"
 #include <FAST/Algorithms/Lambda/RunLambda.hpp>
 #include <FAST/Visualization/LineRenderer/LineRenderer.hpp>
@@ -471,3 +495,73 @@ TEST_CASE("VertexTensorToSegmentation", "[fast][VertexTensorToSegmentation]") {
     tensorToSeg->getRuntime()->print();
 }
  */
+
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+TEST_CASE("ONNXRuntime threading and graph optimization benchmark", "[fast][neuralnetwork][benchmark][visual]") {
+    const auto engines = InferenceEngineManager::getEngineList();
+    if(std::find(engines.begin(), engines.end(), "ONNXRuntime") == engines.end())
+        return;
+    auto image = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd")
+            ->runAndGetOutputData<Image>();
+    const std::string model = join(Config::getTestDataPath(), "NeuralNetworkModels/jugular_vein_segmentation.onnx");
+    const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    const int networks = 4;
+    const int runs = 50;
+
+    std::vector<std::pair<std::string, std::function<void(InferenceEngine::pointer)>>> settings = {
+        {"Default", [](InferenceEngine::pointer engine) {}},
+        {"1 intra-op thread", [](InferenceEngine::pointer engine) { engine->setNumberOfThreads(1); }},
+        {"Cores/networks intra-op threads", [&](InferenceEngine::pointer engine) { engine->setNumberOfThreads(std::max(1, cores/networks)); }},
+        {"Global thread pool", [](InferenceEngine::pointer engine) { engine->setUseGlobalThreadPool(true); }},
+        {"No graph optimization", [](InferenceEngine::pointer engine) { engine->setGraphOptimizationLevel(GraphOptimizationLevel::Disabled); }},
+        {"Basic graph optimization", [](InferenceEngine::pointer engine) { engine->setGraphOptimizationLevel(GraphOptimizationLevel::Basic); }},
+        {"No memory pattern and arena", [](InferenceEngine::pointer engine) { engine->setMemoryPattern(false); engine->setMemoryArena(false); }},
+        {"Cached optimized model", [](InferenceEngine::pointer engine) { engine->setOptimizedModelCaching(true); }},
+    };
+    for(auto&& setting : settings) {
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<NeuralNetwork::pointer> networkList;
+        for(int i = 0; i < networks; ++i) {
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine("ONNXRuntime");
+            network->getInferenceEngine()->setDeviceType(InferenceDeviceType::CPU);
+            setting.second(network->getInferenceEngine());
+            network->load(model);
+            network->setScaleFactor(1.0f / 255.0f);
+            networkList.push_back(network);
+        }
+        const double loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / networks;
+
+        // Latency of a single network running alone
+        networkList[0]->setInputData(image);
+        networkList[0]->runAndGetOutputData(); // Warm-up
+        start = std::chrono::high_resolution_clock::now();
+        for(int i = 0; i < runs; ++i) {
+            networkList[0]->setInputData(image);
+            networkList[0]->runAndGetOutputData();
+        }
+        const double latency = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / runs;
+
+        // Throughput of all networks running simultaneously
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for(auto network : networkList) {
+            threads.emplace_back([network, image, runs]() {
+                for(int i = 0; i < runs; ++i) {
+                    network->setInputData(image);
+                    network->runAndGetOutputData();
+                }
+            });
+        }
+        for(auto& thread : threads)
+            thread.join();
+        const double throughput = networks*runs / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << setting.first << ": load " << loadTime << " ms, latency " << latency << " ms, "
+            << (int)throughput << " images/s with " << networks << " networks" << std::endl;
+    }
+}
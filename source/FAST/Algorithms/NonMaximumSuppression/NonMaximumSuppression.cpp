@@ -1,74 +1,231 @@
 #include "NonMaximumSuppression.hpp"
 #include <FAST/Data/BoundingBox.hpp>
 #include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
 
 namespace fast {
 
-NonMaximumSuppression::NonMaximumSuppression(float threshold) {
+NonMaximumSuppression::NonMaximumSuppression(float threshold, bool perClass) {
 	createInputPort<BoundingBoxSet>(0);
 	createOutputPort<BoundingBoxSet>(0);
     setThreshold(threshold);
+    setPerClass(perClass);
 	createFloatAttribute("threshold", "Threshold", "Threshold", m_threshold);
+	createBooleanAttribute("per-class", "Per class", "Only suppress bounding boxes with the same label", m_perClass);
+	createBooleanAttribute("soft-nms", "Soft NMS", "Decay scores of overlapping bounding boxes instead of removing them", m_softNMS);
+	createFloatAttribute("soft-nms-sigma", "Soft NMS sigma", "Sigma of Gaussian score decay in soft NMS", m_softNMSSigma);
+	createFloatAttribute("score-threshold", "Score threshold", "Remove bounding boxes with a score below this threshold in soft NMS", m_scoreThreshold);
 }
 
 void NonMaximumSuppression::loadAttributes() {
 	setThreshold(getFloatAttribute("threshold"));
+	setPerClass(getBooleanAttribute("per-class"));
+	setSoftNMS(getBooleanAttribute("soft-nms"), getFloatAttribute("soft-nms-sigma"), getFloatAttribute("score-threshold"));
 }
 
 void NonMaximumSuppression::setThreshold(float threshold) {
 	m_threshold = threshold;
+	setModified(true);
+}
+
+float NonMaximumSuppression::getThreshold() const {
+	return m_threshold;
+}
+
+void NonMaximumSuppression::setPerClass(bool perClass) {
+	m_perClass = perClass;
+	setModified(true);
+}
+
+bool NonMaximumSuppression::getPerClass() const {
+	return m_perClass;
+}
+
+void NonMaximumSuppression::setSoftNMS(bool enabled, float sigma, float scoreThreshold) {
+	if(sigma <= 0)
+		throw Exception("Soft NMS sigma must be larger than 0");
+	m_softNMS = enabled;
+	m_softNMSSigma = sigma;
+	m_scoreThreshold = scoreThreshold;
+	setModified(true);
+}
+
+bool NonMaximumSuppression::getSoftNMS() const {
+	return m_softNMS;
+}
+
+namespace {
+struct Box {
+	float x1, y1, x2, y2;
+	float area;
+	uchar label;
+	float score;
+};
+
+inline float intersectionOverUnion(const Box& a, const Box& b) {
+	const float width = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+	const float height = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+	if(width < 0 || height < 0) // There is no overlap
+		return 0.0f;
+	const float intersection = width*height;
+	return intersection / (a.area + b.area - intersection);
+}
 }
 
 void NonMaximumSuppression::execute() {
 	auto input = getInputData<BoundingBoxSet>();
 	auto output = BoundingBoxSet::create();
 
-	auto compare = [](BoundingBox::pointer a, BoundingBox::pointer b) {
-		return a->getScore() < b->getScore(); // if true, they swap place
+	std::vector<Box> boxes;
+	{
+		auto inputAccess = input->getAccess(ACCESS_READ);
+		auto coordinates = inputAccess->getCoordinates();
+		auto labels = inputAccess->getLabels();
+		auto scores = inputAccess->getScores();
+		boxes.reserve(scores.size());
+		// Each bounding box has 4 vertices with 3 coordinates, and a label for each vertex
+		for(int i = 0; i < scores.size(); ++i) {
+			Box box;
+			box.x1 = coordinates[i*12];
+			box.y1 = coordinates[i*12 + 1];
+			box.x2 = coordinates[i*12 + 6];
+			box.y2 = coordinates[i*12 + 7];
+			if(box.x2 <= box.x1 || box.y2 <= box.y1) // Skip invalid bounding boxes
+				continue;
+			box.area = (box.x2 - box.x1)*(box.y2 - box.y1);
+			box.label = labels[i*4];
+			box.score = scores[i];
+			boxes.push_back(box);
+		}
+	}
+	// Sort by decreasing score, the rank of a bounding box is its index after this
+	std::stable_sort(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) {
+		return a.score > b.score;
+	});
+	const int nrOfBoxes = boxes.size();
+
+	// Put bounding boxes in a uniform grid with cells the size of the average bounding box, so that
+	// only bounding boxes in the same cells have to be compared.
+	float cellSize = 0.0f;
+	for(const auto& box : boxes)
+		cellSize += std::max(box.x2 - box.x1, box.y2 - box.y1);
+	cellSize = nrOfBoxes > 0 ? cellSize / nrOfBoxes : 1.0f;
+	auto getCell = [cellSize](float coordinate) {
+		return (int)std::floor(coordinate / cellSize);
 	};
-	std::priority_queue<BoundingBox::pointer, std::vector<BoundingBox::pointer>, decltype(compare)> queue(compare);
-	// Add bounding boxes to the queue
-	auto inputAccess = input->getAccess(ACCESS_READ);
-	auto outputAccess = output->getAccess(ACCESS_READ_WRITE);
-	auto coordinates = inputAccess->getCoordinates();
-	auto labels = inputAccess->getLabels();
-	auto scores = inputAccess->getScores();
-	for(int i = 0; i < coordinates.size(); i += 12) {
-		Vector2f position = Vector2f(coordinates[i], coordinates[i + 1]);
-		Vector2f size = Vector2f(coordinates[i + 6], coordinates[i + 7]) - position;
-		try {
-            auto bbox = BoundingBox::create(position, size, labels[i / 4], scores[i / 12]);
-            queue.push(bbox);
-        } catch(Exception &e) {
+	auto getCellKey = [](int cellX, int cellY) {
+		return (int64_t)(((uint64_t)(uint32_t)cellY << 32) | (uint32_t)cellX);
+	};
+	// Bounding boxes much larger than the average would be inserted into a large number of cells,
+	// instead they are kept in a separate list and compared with all other bounding boxes.
+	const float largeBoxSize = 4*cellSize;
+	auto isLarge = [largeBoxSize](const Box& box) {
+		return std::max(box.x2 - box.x1, box.y2 - box.y1) > largeBoxSize;
+	};
+	std::unordered_map<int64_t, std::vector<int>> grid;
+	std::vector<int> largeBoxes;
+	for(int i = 0; i < nrOfBoxes; ++i) {
+		const auto& box = boxes[i];
+		if(isLarge(box)) {
+			largeBoxes.push_back(i);
+			continue;
+		}
+		for(int y = getCell(box.y1); y <= getCell(box.y2); ++y) {
+			for(int x = getCell(box.x1); x <= getCell(box.x2); ++x)
+				grid[getCellKey(x, y)].push_back(i);
+		}
+	}
 
+	// Find overlapping bounding boxes in parallel. With hard NMS, only overlaps above the threshold with
+	// higher ranked bounding boxes are needed.
+	const float minimumOverlap = m_softNMS ? 0.0f : m_threshold;
+	std::vector<std::vector<std::pair<int, float>>> overlaps(nrOfBoxes);
+#pragma omp parallel for schedule(dynamic, 64)
+	for(int i = 0; i < nrOfBoxes; ++i) {
+		const auto& box = boxes[i];
+		auto compare = [&](int j) {
+			if(j == i || (!m_softNMS && j > i))
+				return;
+			const auto& other = boxes[j];
+			if(m_perClass && other.label != box.label)
+				return;
+			const float iou = intersectionOverUnion(box, other);
+			if(iou > minimumOverlap)
+				overlaps[i].push_back({j, iou});
+		};
+		if(isLarge(box)) {
+			for(int j = 0; j < nrOfBoxes; ++j)
+				compare(j);
+			continue;
 		}
+		for(int y = getCell(box.y1); y <= getCell(box.y2); ++y) {
+			for(int x = getCell(box.x1); x <= getCell(box.x2); ++x) {
+				for(int j : grid.at(getCellKey(x, y))) {
+					// Two boxes can share several cells, only compare them in the cell of the intersection corner
+					if(getCell(std::max(box.x1, boxes[j].x1)) != x || getCell(std::max(box.y1, boxes[j].y1)) != y)
+						continue;
+					compare(j);
+				}
+			}
+		}
+		for(int j : largeBoxes)
+			compare(j);
 	}
 
-	std::unordered_set<BoundingBox::pointer> erased;
-	while(!queue.empty()) {
-		BoundingBox::pointer b_m;
-		do {
-			b_m = queue.top();
+	auto outputAccess = output->getAccess(ACCESS_READ_WRITE);
+	if(!m_softNMS) {
+		// A bounding box is kept if no higher ranked bounding box which is kept overlaps it
+		std::vector<bool> keep(nrOfBoxes, false);
+		for(int i = 0; i < nrOfBoxes; ++i) {
+			keep[i] = std::none_of(overlaps[i].begin(), overlaps[i].end(), [&keep](const std::pair<int, float>& overlap) {
+				return keep[overlap.first];
+			});
+			if(keep[i]) {
+				const auto& box = boxes[i];
+				outputAccess->addBoundingBox(Vector2f(box.x1, box.y1), Vector2f(box.x2 - box.x1, box.y2 - box.y1), box.label, box.score);
+			}
+		}
+	} else {
+		// Repeatedly select the bounding box with the highest score, and decay the scores of its overlapping boxes.
+		// Decayed boxes are added to the queue again, and outdated queue entries are skipped.
+		std::vector<float> scores(nrOfBoxes);
+		std::vector<bool> removed(nrOfBoxes, false);
+		std::priority_queue<std::pair<float, int>> queue;
+		for(int i = 0; i < nrOfBoxes; ++i) {
+			scores[i] = boxes[i].score;
+			if(scores[i] < m_scoreThreshold) {
+				removed[i] = true;
+			} else {
+				queue.push({scores[i], -i}); // Negative index to select highest ranked box when scores are equal
+			}
+		}
+		while(!queue.empty()) {
+			const float score = queue.top().first;
+			const int i = -queue.top().second;
 			queue.pop();
-		} while(erased.count(b_m) > 0 && !queue.empty());
-		if(!b_m)
-			break;
-		
-		outputAccess->addBoundingBox(b_m);
-		auto iterateQueue = queue; // Create new queue for iterating
-
-		// Remove overlapping bounding boxes
-		while(!iterateQueue.empty()) {
-			auto b = iterateQueue.top();
-			iterateQueue.pop();
-
-			if(b_m->intersectionOverUnion(b) > m_threshold) { // If large overlap
-				erased.insert(b);
+			if(removed[i] || score != scores[i])
+				continue;
+			removed[i] = true;
+			const auto& box = boxes[i];
+			outputAccess->addBoundingBox(Vector2f(box.x1, box.y1), Vector2f(box.x2 - box.x1, box.y2 - box.y1), box.label, score);
+			for(const auto& overlap : overlaps[i]) {
+				const int j = overlap.first;
+				if(removed[j])
+					continue;
+				scores[j] *= std::exp(-overlap.second*overlap.second / m_softNMSSigma);
+				if(scores[j] < m_scoreThreshold) {
+					removed[j] = true;
+				} else {
+					queue.push({scores[j], -j});
+				}
 			}
 		}
 	}
+	outputAccess->release();
 
 	addOutputData(0, output);
 }
 
-}
\ No newline at end of file
+}
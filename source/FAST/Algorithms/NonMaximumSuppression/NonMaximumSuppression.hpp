@@ -8,6 +8,12 @@ namespace fast {
  * @brief Non-maximum suppression of bounding box sets
  *
  * Removes overlapping bounding boxes in a BoundingBoxSet if intersection over union is above a provided threshold.
+ * Bounding boxes are processed in order of decreasing score. To handle sets with a very large number of
+ * bounding boxes, e.g. from whole slide image detection, a spatial grid is used so that only nearby bounding
+ * boxes are compared, and the overlaps are calculated in parallel.
+ *
+ * Soft-NMS can be enabled, in which case the scores of overlapping bounding boxes are decayed instead of the
+ * bounding boxes being removed, see Bodla et al. 2017 "Soft-NMS -- Improving Object Detection With One Line of Code".
  *
  * Inputs:
  * - 0: BoundingBoxSet
@@ -23,15 +29,39 @@ class FAST_EXPORT NonMaximumSuppression : public ProcessObject {
         /**
          * @brief Create instance
          * @param threshold Minimum intersection over union to remove overlapping bounding box.
+         * @param perClass Only suppress bounding boxes with the same label
          * @return instance
          */
-        FAST_CONSTRUCTOR(NonMaximumSuppression, float, threshold, = 0.5f);
+        FAST_CONSTRUCTOR(NonMaximumSuppression, float, threshold, = 0.5f, bool, perClass, = false);
 		void setThreshold(float threshold);
-		void loadAttributes();
+		float getThreshold() const;
+		/**
+		 * @brief Only suppress overlapping bounding boxes with the same label
+		 * @param perClass
+		 */
+		void setPerClass(bool perClass);
+		bool getPerClass() const;
+		/**
+		 * @brief Enable Gaussian soft-NMS
+		 *
+		 * Instead of removing overlapping bounding boxes, their score is multiplied with exp(-IoU^2/sigma).
+		 * Bounding boxes with a score below the score threshold are removed.
+		 * The IoU threshold is not used in this mode.
+		 * @param enabled
+		 * @param sigma
+		 * @param scoreThreshold
+		 */
+		void setSoftNMS(bool enabled, float sigma = 0.5f, float scoreThreshold = 0.001f);
+		bool getSoftNMS() const;
+		void loadAttributes() override;
 	protected:
 		void execute() override;
 
 		float m_threshold = 0.5f;
+		bool m_perClass = false;
+		bool m_softNMS = false;
+		float m_softNMSSigma = 0.5f;
+		float m_scoreThreshold = 0.001f;
 };
 
-}
\ No newline at end of file
+}
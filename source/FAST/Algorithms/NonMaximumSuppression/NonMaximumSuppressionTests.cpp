@@ -0,0 +1,80 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/NonMaximumSuppression/NonMaximumSuppression.hpp>
+#include <FAST/Data/BoundingBox.hpp>
+
+using namespace fast;
+
+static BoundingBoxSet::pointer createBoundingBoxes() {
+    auto boxes = BoundingBoxSet::create();
+    auto access = boxes->getAccess(ACCESS_READ_WRITE);
+    access->addBoundingBox(Vector2f(0, 0), Vector2f(10, 10), 1, 0.9f);
+    access->addBoundingBox(Vector2f(1, 1), Vector2f(10, 10), 2, 0.8f); // Overlaps first box with IoU 0.68
+    access->addBoundingBox(Vector2f(2, 0), Vector2f(10, 10), 1, 0.7f); // Overlaps first box with IoU 0.67
+    access->addBoundingBox(Vector2f(50, 50), Vector2f(10, 10), 1, 0.6f);
+    return boxes;
+}
+
+TEST_CASE("Non-maximum suppression", "[fast][NonMaximumSuppression]") {
+    auto nms = NonMaximumSuppression::create(0.5f);
+    nms->setInputData(createBoundingBoxes());
+    auto result = nms->runAndGetOutputData<BoundingBoxSet>();
+    auto access = result->getAccess(ACCESS_READ);
+    auto scores = access->getScores();
+    REQUIRE(scores.size() == 2);
+    CHECK(scores[0] == Approx(0.9f));
+    CHECK(scores[1] == Approx(0.6f));
+}
+
+TEST_CASE("Non-maximum suppression per class", "[fast][NonMaximumSuppression]") {
+    auto nms = NonMaximumSuppression::create(0.5f, true);
+    nms->setInputData(createBoundingBoxes());
+    auto result = nms->runAndGetOutputData<BoundingBoxSet>();
+    auto access = result->getAccess(ACCESS_READ);
+    auto scores = access->getScores();
+    REQUIRE(scores.size() == 3);
+    CHECK(scores[0] == Approx(0.9f));
+    CHECK(scores[1] == Approx(0.8f));
+    CHECK(scores[2] == Approx(0.6f));
+    auto labels = access->getLabels();
+    CHECK(labels[4] == 2);
+}
+
+TEST_CASE("Soft non-maximum suppression", "[fast][NonMaximumSuppression]") {
+    auto nms = NonMaximumSuppression::create();
+    nms->setSoftNMS(true, 0.5f, 0.1f);
+    nms->setInputData(createBoundingBoxes());
+    auto result = nms->runAndGetOutputData<BoundingBoxSet>();
+    auto access = result->getAccess(ACCESS_READ);
+    auto scores = access->getScores();
+    // Overlapping boxes are kept, but with decayed scores
+    REQUIRE(scores.size() == 4);
+    CHECK(scores[0] == Approx(0.9f));
+    CHECK(scores[1] == Approx(0.6f));
+    for(int i = 2; i < 4; ++i) {
+        CHECK(scores[i] < 0.6f);
+        CHECK(scores[i] >= 0.1f);
+    }
+}
+
+TEST_CASE("Non-maximum suppression with bounding boxes much larger than the average", "[fast][NonMaximumSuppression]") {
+    auto boxes = BoundingBoxSet::create();
+    {
+        auto access = boxes->getAccess(ACCESS_READ_WRITE);
+        for(int y = 0; y < 10; ++y) {
+            for(int x = 0; x < 10; ++x)
+                access->addBoundingBox(Vector2f(x*20, y*20), Vector2f(10, 10), 1, 0.8f);
+        }
+        access->addBoundingBox(Vector2f(21, 21), Vector2f(10, 10), 1, 0.3f); // Overlaps a small box with IoU 0.68
+        access->addBoundingBox(Vector2f(0, 0), Vector2f(1000, 1000), 1, 0.9f);
+        access->addBoundingBox(Vector2f(10, 10), Vector2f(1000, 1000), 1, 0.5f); // Overlaps the large box above
+    }
+    auto nms = NonMaximumSuppression::create(0.5f);
+    nms->setInputData(boxes);
+    auto result = nms->runAndGetOutputData<BoundingBoxSet>();
+    auto access = result->getAccess(ACCESS_READ);
+    auto scores = access->getScores();
+    REQUIRE(scores.size() == 101);
+    CHECK(scores[0] == Approx(0.9f));
+    for(int i = 1; i < scores.size(); ++i)
+        CHECK(scores[i] == Approx(0.8f));
+}
@@ -1,7 +1,7 @@
 #include "FAST/Algorithms/SeededRegionGrowing/SeededRegionGrowing.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/SceneGraph.hpp"
-#include <stack>
+#include <atomic>
 #include "FAST/Data/Image.hpp"
 
 namespace fast {
@@ -74,73 +74,131 @@ void SeededRegionGrowing::recompileOpenCLCode(Image::pointer input) {
     mTypeCLCodeCompiledFor = input->getDataType();
 }
 
+void SeededRegionGrowing::setParallel(bool parallel) {
+    mParallel = parallel;
+    mIsModified = true;
+}
+
+bool SeededRegionGrowing::getParallel() const {
+    return mParallel;
+}
+
+namespace {
+/**
+ * A horizontal run of voxels which has to be filled, starting at x and continuing until a voxel
+ * outside the intensity range or an already visited voxel is found.
+ */
+struct Span {
+    int x;
+    int y;
+    int z;
+};
+}
+
 template <class T>
 void SeededRegionGrowing::executeOnHost(T* input, Image::pointer output) {
     ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
     uchar* outputData = (uchar*)outputAccess->get();
+    const int width = output->getWidth();
+    const int height = output->getHeight();
+    const int depth = output->getDepth();
+    const std::size_t size = (std::size_t)width*height*depth;
     // initialize output to all zero
-    memset(outputData, 0, output->getWidth()*output->getHeight()*output->getDepth());
-    std::stack<Vector3i> queue;
-
-    // Add seeds to queue
+    memset(outputData, 0, size);
+
+    // Visited voxels as a bitset. Atomic words are used so that several threads can claim voxels in parallel mode.
+    const std::size_t words = (size + 63) / 64;
+    auto visited = std::make_unique<std::atomic<uint64_t>[]>(words);
+    for(std::size_t i = 0; i < words; ++i)
+        visited[i].store(0, std::memory_order_relaxed);
+    const bool parallel = mParallel;
+    // Mark voxel as visited, returns false if it was already visited
+    auto claim = [&visited, parallel](std::size_t index) {
+        const uint64_t bit = (uint64_t)1 << (index % 64);
+        std::atomic<uint64_t>& word = visited[index / 64];
+        if(parallel)
+            return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+        const uint64_t previous = word.load(std::memory_order_relaxed);
+        if(previous & bit)
+            return false;
+        word.store(previous | bit, std::memory_order_relaxed);
+        return true;
+    };
+    auto isVisited = [&visited](std::size_t index) {
+        return (visited[index / 64].load(std::memory_order_relaxed) >> (index % 64)) & 1;
+    };
+    const float minimum = mMinimumIntensity;
+    const float maximum = mMaximumIntensity;
+    auto isInside = [input, minimum, maximum](std::size_t index) {
+        const float value = input[index];
+        return value >= minimum && value <= maximum;
+    };
+
+    std::vector<Span> frontier;
     for(int i = 0; i < mSeedPoints.size(); i++) {
         Vector3i pos = mSeedPoints[i];
 
         // Check if seed point is in bounds
         if(pos.x() < 0 || pos.y() < 0 || pos.z() < 0 ||
-            pos.x() >= output->getWidth() || pos.y() >= output->getHeight() || pos.z() >= output->getDepth())
+            pos.x() >= width || pos.y() >= height || pos.z() >= depth)
             throw Exception("One of the seed points given to SeededRegionGrowing was out of bounds.");
 
-        queue.push(pos.cast<int>());
+        frontier.push_back({pos.x(), pos.y(), pos.z()});
     }
 
-    std::vector<Vector3i> neighborhood;
-    if(output->getDimensions() == 3) {
-        for(int a = -1; a < 2; a++) {
-            for(int b = -1; b < 2; b++) {
-                for(int c = -1; c < 2; c++) {
-                    if(abs(a) + abs(b) + abs(c) != 1) // connectivity
-                        continue;
-                    neighborhood.push_back(Vector3i(a, b, c));
-                }
+    // Fill a span, and add the runs of unvisited voxels inside the intensity range in the neighboring rows
+    auto fillSpan = [&](const Span& span, std::vector<Span>& next) {
+        const std::size_t rowStart = ((std::size_t)span.z*height + span.y)*width;
+        if(!isInside(rowStart + span.x) || !claim(rowStart + span.x))
+            return;
+        int left = span.x;
+        while(left > 0 && isInside(rowStart + left - 1) && claim(rowStart + left - 1))
+            --left;
+        int right = span.x;
+        while(right < width - 1 && isInside(rowStart + right + 1) && claim(rowStart + right + 1))
+            ++right;
+        memset(&outputData[rowStart + left], 1, right - left + 1);
+
+        // 4-connectivity in 2D and 6-connectivity in 3D
+        const int neighborRows[4][2] = {{span.y - 1, span.z}, {span.y + 1, span.z}, {span.y, span.z - 1}, {span.y, span.z + 1}};
+        for(auto& row : neighborRows) {
+            const int y = row[0];
+            const int z = row[1];
+            if(y < 0 || z < 0 || y >= height || z >= depth)
+                continue;
+            const std::size_t neighborRowStart = ((std::size_t)z*height + y)*width;
+            bool inRun = false;
+            for(int x = left; x <= right; ++x) {
+                const std::size_t index = neighborRowStart + x;
+                const bool fillable = !isVisited(index) && isInside(index);
+                if(fillable && !inRun)
+                    next.push_back({x, y, z});
+                inRun = fillable;
             }
         }
-    } else {
-        for(int a = -1; a < 2; a++) {
-            for(int b = -1; b < 2; b++) {
-                if(abs(a) + abs(b) != 1) // connectivity
-                    continue;
-                neighborhood.push_back(Vector3i(a, b, 0));
+    };
+
+    if(parallel) {
+        // Frontier based: All spans of the current frontier are filled in parallel,
+        // voxels are claimed atomically so that each voxel is only filled once.
+        while(!frontier.empty()) {
+            std::vector<Span> next;
+            #pragma omp parallel
+            {
+                std::vector<Span> threadNext;
+                #pragma omp for schedule(dynamic, 16)
+                for(int i = 0; i < frontier.size(); ++i)
+                    fillSpan(frontier[i], threadNext);
+                #pragma omp critical
+                next.insert(next.end(), threadNext.begin(), threadNext.end());
             }
+            frontier.swap(next);
         }
-    }
-
-    // Process queue
-    while(!queue.empty()) {
-        Vector3i pos = queue.top();
-        queue.pop();
-
-        // Add neighbors to queue
-        for(auto offset : neighborhood) {
-            Vector3i neighbor = pos.cast<int>() + offset;
-            // Check for out of bounds
-            if(neighbor.x() < 0 || neighbor.y() < 0 || neighbor.z() < 0 ||
-                neighbor.x() >= output->getWidth() || neighbor.y() >= output->getHeight() || neighbor.z() >= output->getDepth())
-                continue;
-
-            // Check that voxel is not already segmented
-            if(outputData[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()] == 1)
-                continue;
-
-            // Check condition
-            T value = input[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()];
-            if(value >= mMinimumIntensity && value <= mMaximumIntensity) {
-                // add it to segmentation
-                outputData[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()] = 1;
-
-                // Add to queue
-                queue.push(neighbor);
-            }
+    } else {
+        while(!frontier.empty()) {
+            Span span = frontier.back();
+            frontier.pop_back();
+            fillSpan(span, frontier);
         }
     }
 }
@@ -9,6 +9,10 @@ namespace fast {
 /**
  * @brief Segmentation by seeded region growing
  *
+ * Grows a region from the seed points, adding neighbor voxels with intensity inside the given range.
+ * Neighbors are defined by 4-connectivity in 2D and 6-connectivity in 3D.
+ * The host implementation uses a scanline flood fill.
+ *
  * Inputs:
  * - 0: Image
  *
@@ -36,6 +40,17 @@ class FAST_EXPORT SeededRegionGrowing : public ProcessObject {
         void addSeedPoint(uint x, uint y);
         void addSeedPoint(uint x, uint y, uint z);
         void addSeedPoint(Vector3i position);
+        /**
+         * @brief Grow region in parallel on host
+         *
+         * If enabled, the host implementation fills all spans of the current frontier in parallel using OpenMP,
+         * which is beneficial for large volumes and when using many seed points.
+         * The result is identical to the sequential fill. Default is disabled.
+         *
+         * @param parallel
+         */
+        void setParallel(bool parallel);
+        bool getParallel() const;
     private:
         SeededRegionGrowing();
         void execute();
@@ -46,6 +61,7 @@ class FAST_EXPORT SeededRegionGrowing : public ProcessObject {
 
         float mMinimumIntensity, mMaximumIntensity;
         std::vector<Vector3i> mSeedPoints;
+        bool mParallel = false;
 
         cl::Kernel mKernel;
         unsigned char mDimensionCLCodeCompiledFor;
@@ -3,6 +3,7 @@
 #include "FAST/Importers/ImageFileImporter.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include <cstring>
 
 namespace fast {
 
@@ -94,4 +95,34 @@ TEST_CASE("3D Seeded region growing on Host", "[fast][SeededRegionGrowing]") {
     CHECK(4106484 == sum);
 }
 
+TEST_CASE("Parallel 3D Seeded region growing on Host gives same result as sequential", "[fast][SeededRegionGrowing]") {
+    ImageFileImporter::pointer importer = ImageFileImporter::New();
+    importer->setFilename(Config::getTestDataPath() + "US/Ball/US-3Dt_0.mhd");
+    auto input = importer->runAndGetOutputData<Image>();
+
+    std::vector<Vector3i> seeds = {Vector3i(100, 100, 100), Vector3i(20, 30, 40), Vector3i(80, 60, 90)};
+    auto sequential = SeededRegionGrowing::create(50, 255, seeds);
+    sequential->setMainDevice(Host::getInstance());
+    sequential->setInputData(input);
+    auto sequentialResult = sequential->runAndGetOutputData<Image>();
+
+    auto parallel = SeededRegionGrowing::create(50, 255, seeds);
+    parallel->setMainDevice(Host::getInstance());
+    parallel->setParallel(true);
+    parallel->setInputData(input);
+    auto parallelResult = parallel->runAndGetOutputData<Image>();
+
+    ImageAccess::pointer sequentialAccess = sequentialResult->getImageAccess(ACCESS_READ);
+    ImageAccess::pointer parallelAccess = parallelResult->getImageAccess(ACCESS_READ);
+    const std::size_t size = (std::size_t)input->getWidth()*input->getHeight()*input->getDepth();
+    CHECK(std::memcmp(sequentialAccess->get(), parallelAccess->get(), size) == 0);
+    uchar* data = (uchar*)parallelAccess->get();
+    int sum = 0;
+    for(std::size_t i = 0; i < size; i++) {
+        if(data[i] == 1)
+            sum++;
+    }
+    CHECK(sum >= 4106484);
+}
+
 } // end namespace fast
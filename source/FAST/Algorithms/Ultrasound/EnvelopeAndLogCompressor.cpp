@@ -1,5 +1,7 @@
 #include "EnvelopeAndLogCompressor.hpp"
 #include <FAST/Data/Image.hpp>
+#include <cmath>
+#include <limits>
 
 namespace fast {
 
@@ -12,8 +14,76 @@ EnvelopeAndLogCompressor::EnvelopeAndLogCompressor(bool convertToGrayscale, floa
     setDynamicRange(dynamicRange);
 }
 
+void EnvelopeAndLogCompressor::executeOnHost(Image::pointer input) {
+    if(input->getDataType() != TYPE_FLOAT || input->getNrOfChannels() != 2)
+        throw Exception("EnvelopeAndLogCompressor on host requires IQ data as float image with 2 channels");
+    const int size = input->getNrOfVoxels();
+    auto output = Image::create(input->getSize(), TYPE_FLOAT, 1);
+    float frameMax = -std::numeric_limits<float>::infinity();
+    {
+        // Envelope, log compression and maximum in one pass. 20*log10(|iq|) == 10*log10(I^2 + Q^2)
+        auto inputAccess = input->getImageAccess(ACCESS_READ);
+        auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+        const float* iq = (const float*)inputAccess->get();
+        float* dB = (float*)outputAccess->get();
+        #pragma omp parallel
+        {
+            float threadMax = -std::numeric_limits<float>::infinity();
+            #pragma omp for
+            for(int i = 0; i < size; ++i) {
+                const float I = iq[2*i];
+                const float Q = iq[2*i + 1];
+                const float value = 10.0f*std::log10(I*I + Q*Q);
+                dB[i] = value;
+                threadMax = std::max(threadMax, value);
+            }
+            #pragma omp critical
+            frameMax = std::max(frameMax, threadMax);
+        }
+    }
+
+    if(m_maxInitialize) {
+        m_maxValue = std::max(m_maxValue, frameMax);
+    } else {
+        m_maxValue = frameMax;
+        m_maxInitialize = true;
+    }
+
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    float* dB = (float*)outputAccess->get();
+    const float maxValue = m_maxValue;
+    if(m_convertToGrayscale) {
+        auto normalizedOutput = Image::create(input->getSize(), TYPE_UINT8, 1);
+        {
+            auto normalizedOutputAccess = normalizedOutput->getImageAccess(ACCESS_READ_WRITE);
+            uchar* grayscale = (uchar*)normalizedOutputAccess->get();
+            const float gain = m_gain;
+            const float dynamicRange = m_dynamicRange;
+            #pragma omp parallel for
+            for(int i = 0; i < size; ++i) {
+                float value = dB[i] - maxValue + gain;
+                value = value < -dynamicRange ? -dynamicRange : value; // Reject everything below dynamic range
+                value = value > 0.0f ? 0.0f : value; // Everything above 0 dB should be saturated
+                grayscale[i] = (uchar)std::round(255.0f*(value + dynamicRange)/dynamicRange);
+            }
+        }
+        addOutputData(0, normalizedOutput);
+    } else {
+        // Normalize in place, the dB image is not used for anything else
+        #pragma omp parallel for
+        for(int i = 0; i < size; ++i)
+            dB[i] -= maxValue;
+        outputAccess->release();
+        addOutputData(0, output);
+    }
+}
+
 void EnvelopeAndLogCompressor::execute() {
     auto input = getInputData<Image>();
+    if(getMainDevice()->isHost()) {
+        executeOnHost(input);
+        return;
+    }
     auto output = Image::create(input->getWidth(), input->getHeight(), TYPE_FLOAT, 1);
 
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
@@ -4,6 +4,8 @@
 
 namespace fast {
 
+class Image;
+
 /**
  * @brief Performs normalized envelope detection and log compression on IQ data
  *
@@ -14,6 +16,9 @@ namespace fast {
  * - 0: Image 1 channel float (beamspace data in dB) if convertToGrayscale == false,
  *      or Image 1 channel uint8 (beamspace data in grayscale) if convertToGrayscale == true
  *
+ * If the main device is Host, envelope detection, log compression and the maximum are computed in a single
+ * pass on the CPU, followed by a second pass for normalization.
+ *
  * @ingroup ultrasound
  */
 class FAST_EXPORT EnvelopeAndLogCompressor : public ProcessObject {
@@ -29,6 +34,7 @@ class FAST_EXPORT EnvelopeAndLogCompressor : public ProcessObject {
         void setDynamicRange(float dynamicRange);
     private:
         void execute() override;
+        void executeOnHost(std::shared_ptr<Image> input);
 
         float m_maxValue;
         bool m_maxInitialize = false;
@@ -1,5 +1,6 @@
 #include "ScanConverter.hpp"
 #include <FAST/Data/Image.hpp>
+#include <cmath>
 
 namespace fast {
 
@@ -26,6 +27,106 @@ static void pol2cart(float r, float th, float &x, float &y) {
     y = r * std::sin(th);
 }
 
+void ScanConverter::createSampleTable(int inputWidth, int inputHeight, float newXSpacing, float newYSpacing, float startX, float startY,
+                                      float startDepth, float startAzimuth, float depthSpacing, float azimuthSpacing, bool isPolar) {
+    const std::vector<float> geometry = {(float)m_width, (float)m_height, (float)inputWidth, (float)inputHeight,
+                                         newXSpacing, newYSpacing, startX, startY, startDepth, startAzimuth,
+                                         depthSpacing, azimuthSpacing, isPolar ? 1.0f : 0.0f};
+    if(m_sampleTable.geometry == geometry)
+        return;
+    reportInfo() << "Creating scan conversion sample table for " << m_width << "x" << m_height << " output" << reportEnd();
+    const std::size_t size = (std::size_t)m_width*m_height;
+    m_sampleTable.index.resize(size);
+    m_sampleTable.offsetX.resize(size);
+    m_sampleTable.offsetY.resize(size);
+    m_sampleTable.weightX.resize(size);
+    m_sampleTable.weightY.resize(size);
+    #pragma omp parallel for
+    for(int y = 0; y < m_height; ++y) {
+        for(int x = 0; x < m_width; ++x) {
+            const std::size_t i = x + (std::size_t)y*m_width;
+            // Same as the scanConvert OpenCL kernel
+            const float posX = x*newXSpacing + startX;
+            const float posY = y*newYSpacing + startY;
+            float r = isPolar ? std::sqrt(posX*posX + posY*posY) : posY;
+            float th = isPolar ? std::atan2(posX, posY) : posX;
+            r = ((r - startDepth)/depthSpacing)/inputHeight;
+            th = ((th - startAzimuth)/azimuthSpacing)/inputWidth;
+            if(r < 0.0f || r > 1.0f || th < 0.0f || th > 1.0f) {
+                m_sampleTable.index[i] = -1;
+                m_sampleTable.offsetX[i] = 0;
+                m_sampleTable.offsetY[i] = 0;
+                m_sampleTable.weightX[i] = 0.0f;
+                m_sampleTable.weightY[i] = 0.0f;
+                continue;
+            }
+            // Bilinear interpolation with pixel centers at 0.5, and clamping at the edges
+            const float u = th*inputWidth - 0.5f;
+            const float v = r*inputHeight - 0.5f;
+            const int x0 = (int)std::floor(u);
+            const int y0 = (int)std::floor(v);
+            const int x0c = std::min(std::max(x0, 0), inputWidth - 1);
+            const int x1c = std::min(std::max(x0 + 1, 0), inputWidth - 1);
+            const int y0c = std::min(std::max(y0, 0), inputHeight - 1);
+            const int y1c = std::min(std::max(y0 + 1, 0), inputHeight - 1);
+            m_sampleTable.index[i] = x0c + y0c*inputWidth;
+            m_sampleTable.offsetX[i] = x1c - x0c;
+            m_sampleTable.offsetY[i] = (y1c - y0c)*inputWidth;
+            m_sampleTable.weightX[i] = u - x0;
+            m_sampleTable.weightY[i] = v - y0;
+        }
+    }
+    m_sampleTable.geometry = geometry;
+}
+
+// Convert dB to grayscale, same as the scanConvert OpenCL kernel
+static inline uchar decibelToGrayscale(float dB, float gain, float dynamicRange) {
+    float value = dB + gain;
+    value = value < -dynamicRange ? -dynamicRange : value; // Reject everything below dynamic range
+    value = value > 0.0f ? 0.0f : value; // Everything above 0 dB should be saturated
+    return (uchar)std::round(255.0f*(value + dynamicRange)/dynamicRange);
+}
+
+template <class T>
+static void scanConvertOnHost(const T* input, uchar* output, const int* index, const int* offsetX, const int* offsetY,
+                              const float* weightX, const float* weightY, int width, int height, bool decibel, float gain, float dynamicRange) {
+    #pragma omp parallel for
+    for(int y = 0; y < height; ++y) {
+        const std::size_t rowStart = (std::size_t)y*width;
+        for(std::size_t i = rowStart; i < rowStart + width; ++i) {
+            const int sample = index[i];
+            if(sample < 0) {
+                output[i] = 0;
+                continue;
+            }
+            const float wx = weightX[i];
+            const float wy = weightY[i];
+            const float top = (1.0f - wx)*(float)input[sample] + wx*(float)input[sample + offsetX[i]];
+            const float bottom = (1.0f - wx)*(float)input[sample + offsetY[i]] + wx*(float)input[sample + offsetY[i] + offsetX[i]];
+            const float value = (1.0f - wy)*top + wy*bottom;
+            output[i] = decibel ? decibelToGrayscale(value, gain, dynamicRange) : (uchar)std::round(value);
+        }
+    }
+}
+
+void ScanConverter::executeOnHost(Image::pointer input, Image::pointer output) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    auto outputData = (uchar*)outputAccess->get();
+    if(input->getDataType() == TYPE_FLOAT) {
+        scanConvertOnHost((const float*)inputAccess->get(), outputData, m_sampleTable.index.data(), m_sampleTable.offsetX.data(),
+                          m_sampleTable.offsetY.data(), m_sampleTable.weightX.data(), m_sampleTable.weightY.data(),
+                          m_width, m_height, true, m_gain, m_dynamicRange);
+    } else if(input->getDataType() == TYPE_UINT8) {
+        // Already grayscale..
+        scanConvertOnHost((const uchar*)inputAccess->get(), outputData, m_sampleTable.index.data(), m_sampleTable.offsetX.data(),
+                          m_sampleTable.offsetY.data(), m_sampleTable.weightX.data(), m_sampleTable.weightY.data(),
+                          m_width, m_height, false, m_gain, m_dynamicRange);
+    } else {
+        throw Exception("ScanConverter on host only supports float (dB) and uint8 (grayscale) input");
+    }
+}
+
 void ScanConverter::execute() {
     auto input = getInputData<Image>();
     auto output = Image::create(m_width, m_height, TYPE_UINT8, 1);
@@ -33,8 +134,8 @@ void ScanConverter::execute() {
     float startRadius = m_startDepth;
     float stopRadius = m_endDepth;
     if(m_endDepth - m_startDepth <= 0) {
-        startRadius = std::stof(input->getFrameData("startRadius"));
-        stopRadius = std::stof(input->getFrameData("stopRadius"));
+        startRadius = input->getFrameData<float>("startRadius");
+        stopRadius = input->getFrameData<float>("stopRadius");
     }
     float startTheta;
     float stopTheta;
@@ -48,8 +149,8 @@ void ScanConverter::execute() {
         startTheta = m_leftPos;
         stopTheta = m_rightPos;
     } else {
-        startTheta = std::stof(input->getFrameData("startTheta"));
-        stopTheta = std::stof(input->getFrameData("stopTheta"));
+        startTheta = input->getFrameData<float>("startTheta");
+        stopTheta = input->getFrameData<float>("stopTheta");
         isPolar = input->getFrameData("isPolar") == "true";
     }
 
@@ -70,6 +171,14 @@ void ScanConverter::execute() {
     float newYSpacing = (stopY - startY) / (m_height - 1);
     output->setSpacing(newXSpacing, newYSpacing, 1.0f);
 
+    if(getMainDevice()->isHost()) {
+        createSampleTable(input->getWidth(), input->getHeight(), newXSpacing, newYSpacing, startX, startY, startRadius, startTheta,
+                          (stopRadius-startRadius)/input->getHeight(), (stopTheta-startTheta)/input->getWidth(), isPolar);
+        executeOnHost(input, output);
+        addOutputData(0, output);
+        return;
+    }
+
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     auto inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
     auto outputAccess = output->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <FAST/ProcessObject.hpp>
+#include <vector>
 
 namespace fast {
 
+class Image;
+
 /**
  * @brief Scan convert beamspace image
  *
@@ -13,6 +16,9 @@ namespace fast {
  * Outputs:
  * - 0: Scan converted grayscale image (uint8)
  *
+ * If the main device is Host, scan conversion is done on the CPU. The input pixel positions and bilinear weights of
+ * each output pixel are then precomputed once for each scan geometry, and reused for all frames.
+ *
  * @ingroup ultrasound
  * @sa EnvelopeAndLogCompressor
  * @sa UFFStreamer
@@ -65,6 +71,10 @@ class FAST_EXPORT ScanConverter : public ProcessObject {
         void setDynamicRange(float dynamicRange);
     private:
         void execute() override;
+        // Create table of sample positions for host scan conversion, if geometry has changed
+        void createSampleTable(int inputWidth, int inputHeight, float newXSpacing, float newYSpacing, float startX, float startY,
+                               float startDepth, float startAzimuth, float depthSpacing, float azimuthSpacing, bool isPolar);
+        void executeOnHost(std::shared_ptr<Image> input, std::shared_ptr<Image> output);
 
         int m_width;
         int m_height;
@@ -79,6 +89,17 @@ class FAST_EXPORT ScanConverter : public ProcessObject {
         float m_rightPos;
         float m_depthSpacing;
         float m_lateralSpacing;
+
+        // Precomputed sample positions for scan conversion on host
+        struct SampleTable {
+            std::vector<float> geometry; // Parameters the table was created for
+            std::vector<int> index; // Index of top left input pixel, or -1 if outside of scan
+            std::vector<int> offsetX; // Offset to right input pixel, 0 at edge
+            std::vector<int> offsetY; // Offset to bottom input pixel, 0 at edge
+            std::vector<float> weightX;
+            std::vector<float> weightY;
+        };
+        SampleTable m_sampleTable;
 };
 
 }
\ No newline at end of file
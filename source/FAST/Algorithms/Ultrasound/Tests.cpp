@@ -0,0 +1,112 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Algorithms/Ultrasound/EnvelopeAndLogCompressor.hpp"
+#include "FAST/Algorithms/Ultrasound/ScanConverter.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/DeviceManager.hpp"
+#include <chrono>
+#include <cmath>
+
+using namespace fast;
+
+// Create IQ image with 2 float channels, with varying amplitude along depth
+static Image::pointer createIQImage(int beams, int samples) {
+    std::vector<float> data(beams*samples*2);
+    for(int y = 0; y < samples; ++y) {
+        for(int x = 0; x < beams; ++x) {
+            const float amplitude = 1000.0f*std::exp(-0.005f*y)*(1.0f + (float)((x*31 + y*17) % 97));
+            data[(x + y*beams)*2] = amplitude*std::cos(0.1f*y);
+            data[(x + y*beams)*2 + 1] = amplitude*std::sin(0.1f*y);
+        }
+    }
+    return Image::create(beams, samples, TYPE_FLOAT, 2, data.data());
+}
+
+TEST_CASE("EnvelopeAndLogCompressor on host gives same result as OpenCL", "[fast][EnvelopeAndLogCompressor]") {
+    auto input = createIQImage(64, 256);
+    for(bool grayscale : {false, true}) {
+        auto host = EnvelopeAndLogCompressor::create(grayscale);
+        host->setMainDevice(Host::getInstance());
+        host->connect(input);
+        auto hostOutput = host->runAndGetOutputData<Image>();
+        auto openCL = EnvelopeAndLogCompressor::create(grayscale)->connect(input);
+        auto openCLOutput = openCL->runAndGetOutputData<Image>();
+
+        REQUIRE(hostOutput->getDataType() == openCLOutput->getDataType());
+        REQUIRE(hostOutput->getSize() == openCLOutput->getSize());
+        auto hostAccess = hostOutput->getImageAccess(ACCESS_READ);
+        auto openCLAccess = openCLOutput->getImageAccess(ACCESS_READ);
+        for(int i = 0; i < input->getNrOfVoxels(); ++i) {
+            if(grayscale) {
+                CHECK(std::abs((int)((uchar*)hostAccess->get())[i] - (int)((uchar*)openCLAccess->get())[i]) <= 1);
+            } else {
+                CHECK(((float*)hostAccess->get())[i] == Approx(((float*)openCLAccess->get())[i]).margin(0.01));
+            }
+        }
+    }
+}
+
+TEST_CASE("ScanConverter on host gives same result as OpenCL", "[fast][ScanConverter]") {
+    const int beams = 128;
+    const int samples = 512;
+    std::vector<float> data(beams*samples);
+    for(int i = 0; i < beams*samples; ++i)
+        data[i] = -(float)((i*7 + i/beams) % 70);
+    auto input = Image::create(beams, samples, TYPE_FLOAT, 1, data.data());
+
+    // Sector scan and linear scan
+    for(bool polar : {true, false}) {
+        auto createScanConverter = [polar]() {
+            return polar ? ScanConverter::create(256, 256, 0, 60, 0.01f, 0.1f, -0.6f, 0.6f) :
+                           ScanConverter::create(256, 256, 0, 60, 0.01f, 0.05f, 0, 0, -0.02f, 0.02f);
+        };
+        auto host = createScanConverter();
+        host->setMainDevice(Host::getInstance());
+        host->connect(input);
+        auto hostOutput = host->runAndGetOutputData<Image>();
+        auto openCL = createScanConverter()->connect(input);
+        auto openCLOutput = openCL->runAndGetOutputData<Image>();
+
+        REQUIRE(hostOutput->getDataType() == TYPE_UINT8);
+        REQUIRE(hostOutput->getSize() == openCLOutput->getSize());
+        CHECK(hostOutput->getSpacing() == openCLOutput->getSpacing());
+        auto hostAccess = hostOutput->getImageAccess(ACCESS_READ);
+        auto openCLAccess = openCLOutput->getImageAccess(ACCESS_READ);
+        auto hostData = (uchar*)hostAccess->get();
+        auto openCLData = (uchar*)openCLAccess->get();
+        // Texture sampling on GPUs use fixed point interpolation weights, and pixels exactly on the
+        // scan border may differ, thus only require most pixels to be almost equal.
+        int equal = 0;
+        for(int i = 0; i < 256*256; ++i) {
+            if(std::abs((int)hostData[i] - (int)openCLData[i]) <= 2)
+                ++equal;
+        }
+        CHECK(equal > 0.99*256*256);
+    }
+}
+
+TEST_CASE("Ultrasound envelope and scan conversion on host and OpenCL benchmark", "[fast][ScanConverter][benchmark][visual]") {
+    const int frames = 100;
+    auto input = createIQImage(256, 2048);
+    std::vector<std::pair<std::string, ExecutionDevice::pointer>> devices = {{"host", Host::getInstance()}};
+    auto openCLDevice = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultDevice());
+    if(openCLDevice)
+        devices.push_back({"OpenCL (" + openCLDevice->getName() + ")", openCLDevice});
+    for(auto&& device : devices) {
+        auto envelope = EnvelopeAndLogCompressor::create();
+        envelope->setMainDevice(device.second);
+        auto scanConverter = ScanConverter::create(1024, 1024, 0, 60, 0.0f, 0.1f, -0.6f, 0.6f);
+        scanConverter->setMainDevice(device.second);
+        scanConverter->connect(envelope);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for(int frame = 0; frame < frames; ++frame) {
+            envelope->connect(input);
+            auto output = scanConverter->runAndGetOutputData<Image>();
+            // Make sure the result is available on host, as needed for rendering or storing
+            output->getImageAccess(ACCESS_READ);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Envelope, log compression and scan conversion of 256x2048 IQ to 1024x1024 on " << device.first << ": "
+            << frames/seconds << " FPS" << std::endl;
+    }
+}
@@ -0,0 +1,246 @@
+#include "Compression.hpp"
+#include "Exception.hpp"
+#include <zlib/zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <thread>
+
+namespace fast {
+
+// Largest number of bytes given to zlib at once, as zlib uses 32 bit sizes
+static constexpr std::size_t maxZlibBlockSize = 1 << 30;
+
+namespace {
+// Ends a deflate/inflate stream when going out of scope
+struct DeflateStream {
+    z_stream stream = {};
+    DeflateStream() {
+        if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw Exception("Failed to initialize zlib compression");
+    }
+    ~DeflateStream() { deflateEnd(&stream); }
+};
+struct InflateStream {
+    z_stream stream = {};
+    explicit InflateStream(int windowBits) {
+        if(inflateInit2(&stream, windowBits) != Z_OK)
+            throw Exception("Failed to initialize zlib decompression");
+    }
+    ~InflateStream() { inflateEnd(&stream); }
+};
+}
+
+static uLong computeAdler32(const Bytef* data, std::size_t size) {
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for(std::size_t position = 0; position < size; position += maxZlibBlockSize)
+        adler = adler32(adler, data + position, (uInt)std::min(size - position, maxZlibBlockSize));
+    return adler;
+}
+
+// Deflate one chunk as a raw deflate stream. All chunks except the last end with an empty stored block
+// instead of a final block, so that the compressed chunks can be concatenated to a single deflate stream.
+static void deflateChunk(const Bytef* data, std::size_t size, bool last, std::vector<Bytef>& output) {
+    DeflateStream deflater;
+    z_stream& stream = deflater.stream;
+    output.resize(size/2 + 1024);
+    std::size_t outputSize = 0;
+    std::size_t position = 0;
+    do {
+        const std::size_t inputSize = std::min(size - position, maxZlibBlockSize);
+        stream.next_in = (Bytef*)(data + position);
+        stream.avail_in = (uInt)inputSize;
+        position += inputSize;
+        const int flush = position < size ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+        do {
+            if(output.size() - outputSize < 1024)
+                output.resize(output.size()*2);
+            stream.next_out = output.data() + outputSize;
+            stream.avail_out = (uInt)std::min(output.size() - outputSize, maxZlibBlockSize);
+            const uInt available = stream.avail_out;
+            if(deflate(&stream, flush) == Z_STREAM_ERROR)
+                throw Exception("Error while compressing data with zlib");
+            outputSize += available - stream.avail_out;
+        } while(stream.avail_out == 0);
+    } while(position < size);
+    output.resize(outputSize);
+}
+
+// Inflate one raw deflate chunk which must give exactly outputSize bytes
+static void inflateChunk(const Bytef* data, std::size_t size, Bytef* output, std::size_t outputSize) {
+    InflateStream inflater(-MAX_WBITS);
+    z_stream& stream = inflater.stream;
+    stream.next_in = (Bytef*)data;
+    stream.avail_in = (uInt)size;
+    stream.next_out = output;
+    stream.avail_out = (uInt)outputSize;
+    while(stream.avail_out > 0) {
+        const int result = inflate(&stream, Z_SYNC_FLUSH);
+        if(result == Z_STREAM_END)
+            break;
+        if(result != Z_OK)
+            throw Exception("Error while decompressing zlib chunk: " + std::string(stream.msg ? stream.msg : "unexpected end of data"));
+    }
+    if(stream.avail_out != 0)
+        throw Exception("Compressed zlib chunk is smaller than expected");
+}
+
+std::vector<std::size_t> compressZlibChunks(const void* data, std::size_t size, std::size_t chunkSize, std::ostream& output) {
+    if(chunkSize == 0 || chunkSize > size)
+        chunkSize = std::max<std::size_t>(size, 1);
+    if(chunkSize > maxZlibBlockSize && chunkSize < size)
+        throw Exception("Chunk size for zlib compression can not be larger than " + std::to_string(maxZlibBlockSize) + " bytes");
+    const int chunks = (int)std::max<std::size_t>((size + chunkSize - 1) / chunkSize, 1);
+    const Bytef* input = (const Bytef*)data;
+
+    // zlib header: deflate with 32K window and default compression level
+    const Bytef header[2] = {0x78, 0x9C};
+    output.write((const char*)header, 2);
+    std::vector<std::size_t> offsets = {2};
+    uLong adler = adler32(0L, Z_NULL, 0);
+
+    // Compress a limited number of chunks at a time to limit memory usage
+    const int batchSize = 4*std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<std::vector<Bytef>> compressed(batchSize);
+    std::vector<uLong> adlers(batchSize);
+    for(int batchStart = 0; batchStart < chunks; batchStart += batchSize) {
+        const int batchEnd = std::min(batchStart + batchSize, chunks);
+        bool failed = false;
+        #pragma omp parallel for schedule(dynamic)
+        for(int chunk = batchStart; chunk < batchEnd; ++chunk) {
+            const std::size_t chunkBegin = chunk*chunkSize;
+            const std::size_t chunkLength = std::min(chunkSize, size - chunkBegin);
+            try {
+                deflateChunk(input + chunkBegin, chunkLength, chunk == chunks - 1, compressed[chunk - batchStart]);
+                adlers[chunk - batchStart] = computeAdler32(input + chunkBegin, chunkLength);
+            } catch(...) {
+                #pragma omp critical
+                failed = true;
+            }
+        }
+        if(failed)
+            throw Exception("Error while compressing data with zlib");
+        for(int chunk = batchStart; chunk < batchEnd; ++chunk) {
+            auto& chunkData = compressed[chunk - batchStart];
+            output.write((const char*)chunkData.data(), chunkData.size());
+            offsets.push_back(offsets.back() + chunkData.size());
+            if(chunk == 0) {
+                adler = adlers[0];
+            } else {
+                adler = adler32_combine(adler, adlers[chunk - batchStart], (z_off_t)std::min(chunkSize, size - chunk*chunkSize));
+            }
+            chunkData = std::vector<Bytef>();
+        }
+    }
+
+    // zlib trailer: adler32 checksum of uncompressed data, big endian
+    const Bytef trailer[4] = {(Bytef)(adler >> 24), (Bytef)(adler >> 16), (Bytef)(adler >> 8), (Bytef)adler};
+    output.write((const char*)trailer, 4);
+    if(!output)
+        throw Exception("Error while writing compressed data");
+    return offsets;
+}
+
+void decompressZlibChunks(std::istream& input, const std::vector<std::size_t>& chunkOffsets, std::size_t chunkSize, std::size_t size, std::size_t begin, std::size_t end, void* output) {
+    if(end > size || begin > end)
+        throw Exception("Invalid range " + std::to_string(begin) + "-" + std::to_string(end) + " given to decompressZlibChunks");
+    if(chunkSize == 0 || chunkOffsets.size() != std::max<std::size_t>((size + chunkSize - 1) / chunkSize, 1) + 1)
+        throw Exception("Index of compressed chunks does not match size of data");
+    if(begin == end)
+        return;
+    const int firstChunk = begin / chunkSize;
+    const int lastChunk = (end - 1) / chunkSize;
+    const bool verify = begin == 0 && end == size;
+
+    // Read compressed data of the needed chunks, and the trailer if whole data is decompressed
+    const auto start = input.tellg();
+    const std::size_t readSize = chunkOffsets[lastChunk + 1] - chunkOffsets[firstChunk] + (verify ? 4 : 0);
+    std::vector<Bytef> compressed(readSize);
+    input.seekg(start + (std::streamoff)chunkOffsets[firstChunk]);
+    input.read((char*)compressed.data(), readSize);
+    if((std::size_t)input.gcount() != readSize)
+        throw Exception("Compressed data ended unexpectedly");
+
+    Bytef* result = (Bytef*)output;
+    std::vector<uLong> adlers(lastChunk - firstChunk + 1);
+    bool failed = false;
+    #pragma omp parallel for schedule(dynamic)
+    for(int chunk = firstChunk; chunk <= lastChunk; ++chunk) {
+        const std::size_t chunkBegin = chunk*chunkSize;
+        const std::size_t chunkEnd = std::min(chunkBegin + chunkSize, size);
+        const Bytef* chunkData = compressed.data() + chunkOffsets[chunk] - chunkOffsets[firstChunk];
+        const std::size_t chunkDataSize = chunkOffsets[chunk + 1] - chunkOffsets[chunk];
+        try {
+            if(begin <= chunkBegin && chunkEnd <= end) {
+                Bytef* destination = result + (chunkBegin - begin);
+                inflateChunk(chunkData, chunkDataSize, destination, chunkEnd - chunkBegin);
+                if(verify)
+                    adlers[chunk - firstChunk] = computeAdler32(destination, chunkEnd - chunkBegin);
+            } else {
+                // Chunk is only partly inside the range
+                std::vector<Bytef> buffer(chunkEnd - chunkBegin);
+                inflateChunk(chunkData, chunkDataSize, buffer.data(), buffer.size());
+                const std::size_t copyBegin = std::max(begin, chunkBegin);
+                const std::size_t copyEnd = std::min(end, chunkEnd);
+                std::memcpy(result + (copyBegin - begin), buffer.data() + (copyBegin - chunkBegin), copyEnd - copyBegin);
+            }
+        } catch(...) {
+            #pragma omp critical
+            failed = true;
+        }
+    }
+    if(failed)
+        throw Exception("Error while decompressing zlib chunks");
+
+    if(verify) {
+        uLong adler = adlers[0];
+        for(int chunk = 1; chunk < (int)adlers.size(); ++chunk)
+            adler = adler32_combine(adler, adlers[chunk], (z_off_t)(std::min((chunk + 1)*chunkSize, size) - chunk*chunkSize));
+        const Bytef* trailer = compressed.data() + readSize - 4;
+        const uLong expected = ((uLong)trailer[0] << 24) | ((uLong)trailer[1] << 16) | ((uLong)trailer[2] << 8) | (uLong)trailer[3];
+        if(adler != expected)
+            throw Exception("Checksum of decompressed data does not match zlib trailer");
+    }
+}
+
+void decompressZlib(std::istream& input, std::size_t begin, std::size_t end, void* output) {
+    if(begin > end)
+        throw Exception("Invalid range " + std::to_string(begin) + "-" + std::to_string(end) + " given to decompressZlib");
+    InflateStream inflater(MAX_WBITS);
+    z_stream& stream = inflater.stream;
+    std::vector<Bytef> inputBuffer(1 << 20);
+    std::vector<Bytef> skipBuffer;
+    Bytef* result = (Bytef*)output;
+    std::size_t position = 0;
+    while(position < end) {
+        if(stream.avail_in == 0) {
+            input.read((char*)inputBuffer.data(), inputBuffer.size());
+            stream.next_in = inputBuffer.data();
+            stream.avail_in = (uInt)input.gcount();
+            if(stream.avail_in == 0)
+                throw Exception("Compressed data ended unexpectedly");
+        }
+        if(position < begin) {
+            // Decompress data before the range to a temporary buffer
+            skipBuffer.resize(1 << 20);
+            stream.next_out = skipBuffer.data();
+            stream.avail_out = (uInt)std::min(skipBuffer.size(), begin - position);
+        } else {
+            stream.next_out = result + (position - begin);
+            stream.avail_out = (uInt)std::min(end - position, maxZlibBlockSize);
+        }
+        const uInt available = stream.avail_out;
+        const int status = inflate(&stream, Z_NO_FLUSH);
+        position += available - stream.avail_out;
+        if(status == Z_STREAM_END) {
+            if(position < end)
+                throw Exception("Decompressed data is smaller than expected");
+            break;
+        }
+        if(status != Z_OK && status != Z_BUF_ERROR)
+            throw Exception("Error while decompressing data with zlib: " + std::string(stream.msg ? stream.msg : ""));
+    }
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "FASTExport.hpp"
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace fast {
+
+/**
+ * @brief Compress data with zlib in independent chunks, in parallel
+ *
+ * The output is a standard zlib stream which can be decompressed by any zlib reader, e.g. decompressZlib.
+ * As in pigz, each chunk of chunkSize uncompressed bytes is deflated separately and ends on a byte boundary,
+ * thus the chunks can also be decompressed independently and in parallel with decompressZlibChunks.
+ *
+ * @param data uncompressed data
+ * @param size size of uncompressed data in bytes
+ * @param chunkSize uncompressed size of each chunk in bytes. If 0, the data is compressed as a single chunk.
+ * @param output stream to write compressed data to
+ * @return byte offset of each chunk in the compressed data, followed by the offset of the zlib trailer
+ */
+FAST_EXPORT std::vector<std::size_t> compressZlibChunks(const void* data, std::size_t size, std::size_t chunkSize, std::ostream& output);
+
+/**
+ * @brief Decompress a byte range of data compressed with compressZlibChunks, in parallel
+ *
+ * Only the chunks overlapping the range are read from the input stream and decompressed.
+ * If the whole data is decompressed, the zlib checksum is verified as well.
+ *
+ * @param input stream positioned at the start of the compressed data
+ * @param chunkOffsets offsets returned by compressZlibChunks
+ * @param chunkSize uncompressed size of each chunk in bytes
+ * @param size total uncompressed size in bytes
+ * @param begin first uncompressed byte to get
+ * @param end uncompressed byte after the last byte to get
+ * @param output buffer of at least end-begin bytes
+ */
+FAST_EXPORT void decompressZlibChunks(std::istream& input, const std::vector<std::size_t>& chunkOffsets, std::size_t chunkSize, std::size_t size, std::size_t begin, std::size_t end, void* output);
+
+/**
+ * @brief Decompress a byte range of a standard zlib stream
+ *
+ * The stream is decompressed incrementally, so the compressed data is never loaded into memory at once,
+ * and decompression stops when the end of the range is reached.
+ *
+ * @param input stream positioned at the start of the compressed data
+ * @param begin first uncompressed byte to get
+ * @param end uncompressed byte after the last byte to get
+ * @param output buffer of at least end-begin bytes
+ */
+FAST_EXPORT void decompressZlib(std::istream& input, std::size_t begin, std::size_t end, void* output);
+
+}
@@ -10,6 +10,7 @@
 #include <tiffio.h>
 #include <FAST/Data/Image.hpp>
 #include <jpeglib.h>
+#include <FAST/Data/ImagePyramidTileCache.hpp>
 
 namespace fast {
 
@@ -21,7 +22,7 @@ ImagePyramidAccess::ImagePyramidAccess(
         std::vector<vsi_tile_header>& vsiTiles,
         std::shared_ptr<ImagePyramid> imagePyramid,
         bool write,
-        std::unordered_set<std::string>& initializedPatchList,
+        std::unordered_set<TileID>& initializedPatchList,
         std::mutex& readMutex,
         ImageCompression compressionFormat
         ) : m_initializedPatchList(initializedPatchList), m_readMutex(readMutex) {
@@ -37,6 +38,11 @@ ImagePyramidAccess::ImagePyramidAccess(
     m_compressionFormat = compressionFormat;
 }
 
+void ImagePyramidAccess::setReadHandlePools(std::shared_ptr<FileHandlePool<TIFF*>> tiffReadHandles, std::shared_ptr<FileHandlePool<std::ifstream*>> vsiReadHandles) {
+    m_tiffReadHandles = tiffReadHandles;
+    m_vsiReadHandles = vsiReadHandles;
+}
+
 void ImagePyramidAccess::release() {
 	m_image->accessFinished();
 }
@@ -45,16 +51,8 @@ ImagePyramidAccess::~ImagePyramidAccess() {
 	release();
 }
 
-ImagePyramidPatch ImagePyramidAccess::getPatch(std::string tile) {
-    auto parts = split(tile, "_");
-    if(parts.size() != 3)
-        throw Exception("incorrect tile format");
-
-    int level = std::stoi(parts[0]);
-    int tile_x = std::stoi(parts[1]);
-    int tile_y = std::stoi(parts[2]);
-
-    return getPatch(level, tile_x, tile_y);
+ImagePyramidPatch ImagePyramidAccess::getPatch(TileID tile) {
+    return getPatch(tile.getLevel(), tile.getTileX(), tile.getTileY());
 }
 
 void jpegErrorExit(j_common_ptr cinfo) {
@@ -64,16 +62,38 @@ void jpegErrorExit(j_common_ptr cinfo) {
     throw std::runtime_error( jpegLastErrorMsg );
 }
 
+void ImagePyramidAccess::readVSITileBytes(vsi_tile_header tile, char* buffer) {
+    if(m_vsiReadHandles) {
+        // Each thread seeks and reads with its own stream
+        auto lease = m_vsiReadHandles->acquire();
+        lease.get()->seekg(tile.offset);
+        lease.get()->read(buffer, tile.numbytes);
+    } else {
+        // Reading VSI tiles with a shared stream is not thread safe
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        m_vsiHandle->seekg(tile.offset);
+        m_vsiHandle->read(buffer, tile.numbytes);
+    }
+}
+
+void ImagePyramidAccess::setTIFFDirectory(TIFF* tiff, int level) {
+    // Changing directory re-reads the directory from file, thus skip it if handle is already at the correct level
+    if(m_image->isOMETIFF()) {
+        // The current directory number is not reliable after TIFFSetSubDirectory, thus compare offsets for all levels
+        if(TIFFCurrentDirOffset(tiff) != m_levels[level].offset)
+            TIFFSetSubDirectory(tiff, m_levels[level].offset);
+    } else if(TIFFCurrentDirectory(tiff) != level) {
+        // Tiles written to the current directory are lost if it is not written to file before changing directory
+        if(tiff == m_tiffHandle && m_image->m_tiffDirectoryModified)
+            checkpointTIFFDirectory();
+        TIFFSetDirectory(tiff, level);
+    }
+}
+
 void ImagePyramidAccess::readVSITileToBuffer(vsi_tile_header tile, uchar* data) {
     if(m_compressionFormat == ImageCompression::JPEG) {
         auto buffer = make_uninitialized_unique<char[]>(tile.numbytes);
-
-        // Reading VSI tiles is not thread safe
-        {
-            std::lock_guard<std::mutex> lock(m_readMutex);
-            m_vsiHandle->seekg(tile.offset);
-            m_vsiHandle->read(buffer.get(), tile.numbytes);
-        }
+        readVSITileBytes(tile, buffer.get());
         jpeg_decompress_struct cinfo;
         jpeg_error_mgr jerr; //error handling
         jpeg_source_mgr src_mem;
@@ -101,25 +121,69 @@ void ImagePyramidAccess::readVSITileToBuffer(vsi_tile_header tile, uchar* data)
             throw Exception("JPEG error: " + std::string(e.what())); // or return an error code
         }
     } else if(m_compressionFormat == ImageCompression::RAW) { // Uncompressed
-        // Reading VSI tiles is not thread safe
-        {
-            auto buffer = make_uninitialized_unique<char[]>(tile.numbytes);
-            std::lock_guard<std::mutex> lock(m_readMutex);
-            m_vsiHandle->seekg(tile.offset);
-            m_vsiHandle->read(buffer.get(), tile.numbytes);
-            // Data is stored as BGR, convert it to RGB
-            // TODO could optimize this by doing it on the GPU instead..
-            for(int i = 0; i < tile.numbytes/3; ++i) {
-                data[i*3 + 0] = buffer[i*3+2];
-                data[i*3 + 1] = buffer[i*3+1];
-                data[i*3 + 2] = buffer[i*3+0];
-            }
+        auto buffer = make_uninitialized_unique<char[]>(tile.numbytes);
+        readVSITileBytes(tile, buffer.get());
+        // Data is stored as BGR, convert it to RGB
+        // TODO could optimize this by doing it on the GPU instead..
+        for(int i = 0; i < tile.numbytes/3; ++i) {
+            data[i*3 + 0] = buffer[i*3+2];
+            data[i*3 + 1] = buffer[i*3+1];
+            data[i*3 + 2] = buffer[i*3+0];
         }
     } else {
         throw Exception("Unknown image compression format in ImagePyramidAccess::readVSITileToBuffer: " + std::to_string((int)m_compressionFormat));
     }
 }
 
+std::shared_ptr<uchar[]> ImagePyramidAccess::getTileData(int level, int tileX, int tileY) {
+    const int tileWidth = m_image->getLevelTileWidth(level);
+    const int tileHeight = m_image->getLevelTileHeight(level);
+    const std::size_t bytes = (std::size_t)tileWidth*tileHeight*m_image->getNrOfChannels();
+    // Only cache tiles of read-only pyramids. A pyramid which is not fully initialized may still be written to.
+    const bool useCache = !m_write && m_image->isPyramidFullyInitialized();
+    const ImagePyramidTileCache::TileKey key = {m_image->getTileCacheID(), level, tileX, tileY};
+    auto cache = ImagePyramidTileCache::getInstance();
+    if(useCache) {
+        auto data = cache->get(key);
+        if(data)
+            return data;
+    }
+
+    std::shared_ptr<uchar[]> data(new uchar[bytes]);
+    if(m_tiffHandle != nullptr) {
+        // Use a handle from the read handle pool if available, so that multiple threads can read tiles in parallel.
+        // Otherwise, all threads share the same handle which is protected by the read mutex.
+        TIFF* tiff = m_tiffHandle;
+        std::unique_lock<std::mutex> lock(m_readMutex, std::defer_lock);
+        std::unique_ptr<FileHandlePool<TIFF*>::Lease> lease;
+        if(m_tiffReadHandles) {
+            lease = std::make_unique<FileHandlePool<TIFF*>::Lease>(m_tiffReadHandles->acquire());
+            tiff = lease->get();
+        } else {
+            lock.lock();
+        }
+        setTIFFDirectory(tiff, level);
+        // From TIFFReadTile documentation: Return the data for the tile containing the specified coordinates.
+        // In TIFF all tiles have the same size, thus they are padded..
+        TIFFReadTile(tiff, (void *) data.get(), tileX*tileWidth, tileY*tileHeight, 0, 0);
+    } else {
+        bool found = false;
+        for(const auto& tile : m_vsiTiles) {
+            if(tile.level == level && tile.coord[0] == tileX && tile.coord[1] == tileY) {
+                readVSITileToBuffer(tile, data.get());
+                found = true;
+                break;
+            }
+        }
+        if(!found) // Some tiles may be missing (edge case)
+            return nullptr;
+    }
+
+    if(useCache)
+        cache->put(key, data, bytes);
+    return data;
+}
+
 std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int y, int width, int height) {
     const int levelWidth = m_image->getLevelWidth(level);
     const int levelHeight = m_image->getLevelHeight(level);
@@ -127,89 +191,44 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int
     const int tileWidth = m_image->getLevelTileWidth(level);
     const int tileHeight = m_image->getLevelTileHeight(level);
     auto data = std::make_unique<uchar[]>(width*height*channels);
-    if(m_tiffHandle != nullptr) {
-        // Read all tiles within region, then crop
-        if(!isPatchInitialized(level, x, y)) {
+    if(m_tiffHandle != nullptr || !m_vsiTiles.empty()) {
+        if(m_tiffHandle != nullptr && !isPatchInitialized(level, x, y)) {
             // Tile has not be initialized, fill with zeros and return..
             // TODO Do not try render these patches..
             std::memset(data.get(), 0, width*height*channels);
             return data;
         }
-        std::lock_guard<std::mutex> lock(m_readMutex);
-        if(m_image->isOMETIFF()) {
-            if(level == 0) {
-                TIFFSetDirectory(m_tiffHandle, level);
-            } else {
-                TIFFSetSubDirectory(m_tiffHandle, m_levels[level].offset);
-            }
-        } else {
-            TIFFSetDirectory(m_tiffHandle, level);
-        }
-        if(width == tileWidth && height == tileHeight && x % tileWidth == 0 && y % tileHeight == 0) {
-            // From TIFFReadTile documentation: Return the data for the tile containing the specified coordinates.
-            int bytesRead = TIFFReadTile(m_tiffHandle, (void *) data.get(), x, y, 0, 0);
-        } else if((width < tileWidth || height < tileHeight) && x % tileWidth == 0 && y % tileHeight == 0) {
-            auto tileData = std::make_unique<uchar[]>(tileWidth*tileHeight*channels);
-            {
-                // From TIFFReadTile documentation: Return the data for the tile containing the specified coordinates.
-                // In TIFF all tiles have the same size, thus they are padded..
-                int bytesRead = TIFFReadTile(m_tiffHandle, (void *) tileData.get(), x, y, 0, 0);
-            }
-            // Remove extra
-            for(int dy = 0; dy < height; ++dy) {
-                for(int dx = 0; dx < width; ++dx) {
-		    for(int channel = 0; channel < channels; ++channel) {
-                        data[(dx + dy*width)*channels + channel] = tileData[(dx + dy*tileWidth)*channels + channel];
-		    }
-                }
-            }
-        } else {
-            // Create buffer to contain all tiles
-            int totalTilesX = std::ceil((float)width / tileWidth);
-            int totalTilesY = std::ceil((float)height / tileHeight);
-            if(x % tileWidth != 0) totalTilesX += 1;
-            if(y % tileHeight != 0) totalTilesY += 1;
-            const int targetNumberOfTiles = totalTilesX*totalTilesY;
-            auto fullTileBuffer = make_uninitialized_unique<uchar[]>(tileWidth*tileHeight*targetNumberOfTiles*channels);
-            // Does the buffer need to be initialized/padded?
-            if(x+width >= levelWidth || x+height >= levelHeight) { // Some tiles are outside, fill it
-                if(channels > 1) {
-                    std::memset(fullTileBuffer.get(), 255, tileWidth*tileHeight*targetNumberOfTiles*channels);
-                } else {
-                    std::memset(fullTileBuffer.get(), 0, tileWidth*tileHeight*targetNumberOfTiles*channels);
-                }
-            }
-            // Fill the full tile buffer
-            const int firstTileX = x / tileWidth;
-            const int firstTileY = y / tileHeight;
-            const int fullTileBufferWidth = totalTilesX*tileWidth;
-            for(int i = 0; i < totalTilesX; ++i) {
-                for(int j = 0; j < totalTilesY; ++j) {
-                    auto tileData = std::make_unique<uchar[]>(tileWidth*tileHeight*channels);
-                    int tileX = i*tileWidth;
-                    int tileY = j*tileHeight;
-                    int bytesRead = TIFFReadTile(m_tiffHandle, (void *) tileData.get(), firstTileX*tileWidth+tileX, firstTileY*tileHeight+tileY, 0, 0);
-                    // Stitch tile into full buffer
-                    for(int cy = 0; cy < tileHeight; ++cy) {
-                        for(int cx = 0; cx < tileWidth; ++cx) {
-                            for(int channel = 0; channel < channels; ++channel) {
-                                fullTileBuffer[(tileX + cx + (tileY + cy)*fullTileBufferWidth)*channels + channel] = tileData[(cx + cy*tileWidth)*channels + channel];
-                            }
-                        }
-                    }
-                }
-            }
-            // Crop the full buffer to data[]
-            const int offsetX = x - firstTileX*tileWidth;
-            const int offsetY = y - firstTileY*tileHeight;
-            for(int cy = offsetY; cy < offsetY + height; ++cy) {
-                for(int cx = offsetX; cx < offsetX + width; ++cx) {
-                    for(int channel = 0; channel < channels; ++channel) {
-                        data[(cx - offsetX + (cy - offsetY) * width)*channels + channel] = fullTileBuffer[(cx + cy * fullTileBufferWidth)*channels + channel];
+        // Copy the part of each tile within the region, tiles are decoded only once thanks to the tile cache
+        const uchar paddingValue = channels > 1 ? 255 : 0;
+        const int firstTileX = x / tileWidth;
+        const int firstTileY = y / tileHeight;
+        const int lastTileX = (x + width - 1) / tileWidth;
+        const int lastTileY = (y + height - 1) / tileHeight;
+        int tilesFound = 0;
+        for(int tileY = firstTileY; tileY <= lastTileY; ++tileY) {
+            for(int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+                std::shared_ptr<uchar[]> tileData;
+                if(tileX < m_image->getLevelTilesX(level) && tileY < m_image->getLevelTilesY(level))
+                    tileData = getTileData(level, tileX, tileY);
+                if(tileData)
+                    tilesFound += 1;
+                const int startX = std::max(x, tileX*tileWidth);
+                const int endX = std::min(x + width, (tileX + 1)*tileWidth);
+                const int startY = std::max(y, tileY*tileHeight);
+                const int endY = std::min(y + height, (tileY + 1)*tileHeight);
+                const int rowBytes = (endX - startX)*channels;
+                for(int cy = startY; cy < endY; ++cy) {
+                    uchar* destination = &data[((cy - y)*width + startX - x)*channels];
+                    if(tileData) {
+                        std::memcpy(destination, &tileData[((cy - tileY*tileHeight)*tileWidth + startX - tileX*tileWidth)*channels], rowBytes);
+                    } else {
+                        std::memset(destination, paddingValue, rowBytes);
                     }
                 }
             }
         }
+        if(tilesFound == 0 && m_tiffHandle == nullptr)
+            throw Exception("Could not find any tiles for getPatchData in VSI");
     } else if(m_fileHandle != nullptr) {
         int scale = (float)m_image->getFullWidth()/levelWidth;
 #ifndef WIN32
@@ -221,81 +240,6 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int
         }
 #endif
         openslide_read_region(m_fileHandle, (uint32_t*)data.get(), x * scale, y * scale, level, width, height);
-    } else if(!m_vsiTiles.empty()) {
-        if(width == tileWidth && height == tileHeight && x % tileWidth == 0 && y % tileHeight == 0) {
-            vsi_tile_header tile;
-            bool found = false;
-            for(int i = 0; i < m_vsiTiles.size(); ++i) {
-                vsi_tile_header currentTile = m_vsiTiles[i];
-                if(currentTile.level != level)
-                    continue;
-                if(currentTile.coord[0] != x / m_image->getLevelTileWidth(level) || currentTile.coord[1] != y / m_image->getLevelTileHeight(level))
-                    continue;
-                tile = currentTile;
-                found = true;
-                break;
-            }
-            if(!found)
-                throw Exception("Could not find tile for getPathcData in VSI");
-
-            readVSITileToBuffer(tile, data.get());
-        } else {
-            std::vector<vsi_tile_header> tilesToRead;
-            int firstTileX = x / m_image->getLevelTileWidth(level);
-            int firstTileY = y / m_image->getLevelTileHeight(level);
-            int lastTileX = std::ceil((float)(x + width) / m_image->getLevelTileWidth(level));
-            int lastTileY = std::ceil((float)(y + height) / m_image->getLevelTileHeight(level));
-            // How many tiles we are supposed to have
-            const int targetNumberOfTiles = (lastTileX-firstTileX)*(lastTileY-firstTileY);
-            for(int i = 0; i < m_vsiTiles.size(); ++i) {
-                vsi_tile_header currentTile = m_vsiTiles[i];
-                if(currentTile.level != level)
-                    continue;
-                if(
-                        !((currentTile.coord[0] >= firstTileX && currentTile.coord[0] < lastTileX) &&
-                        (currentTile.coord[1] >= firstTileY && currentTile.coord[1] < lastTileY)))
-                    continue;
-                tilesToRead.push_back(currentTile);
-            }
-            if(tilesToRead.empty())
-                throw Exception("Tiles to ready empty");
-
-            auto fullTileBuffer = make_uninitialized_unique<uchar[]>(tileWidth*tileHeight*targetNumberOfTiles*channels);
-            if(tilesToRead.size() != targetNumberOfTiles) { // Some tiles are missing.. (edge case) fill with some blank value
-                if(channels > 1) {
-                    std::memset(fullTileBuffer.get(), 255, tileWidth*tileHeight*targetNumberOfTiles*channels);
-                } else {
-                    std::memset(fullTileBuffer.get(), 0, tileWidth*tileHeight*targetNumberOfTiles*channels);
-                }
-            }
-            const auto fullTileBufferWidth = (lastTileX-firstTileX)*tileWidth;
-            // Read tile to buffer
-            auto tileBuffer = make_uninitialized_unique<uchar[]>(tileWidth*tileHeight*channels); // assume full tiles of same size for all
-            for(auto tile : tilesToRead) {
-                const int tileX = (tile.coord[0]-firstTileX)*tileWidth;
-                const int tileY = (tile.coord[1]-firstTileY)*tileHeight;
-                readVSITileToBuffer(tile, tileBuffer.get());
-                // Stitch tile into full buffer
-                for(int cy = 0; cy < tileHeight; ++cy) {
-                    for(int cx = 0; cx < tileWidth; ++cx) {
-                        for(int channel = 0; channel < channels; ++channel) {
-                            fullTileBuffer[(tileX + cx + (tileY + cy)*fullTileBufferWidth)*channels + channel] = tileBuffer[(cx + cy*tileWidth)*channels + channel];
-                        }
-                    }
-                }
-            }
-
-            // Crop the full buffer to data[]
-            const int offsetX = x - firstTileX*tileWidth;
-            const int offsetY = y - firstTileY*tileHeight;
-            for(int cy = offsetY; cy < offsetY + height; ++cy) {
-                for(int cx = offsetX; cx < offsetX + width; ++cx) {
-                    for(int channel = 0; channel < channels; ++channel) {
-                        data[(cx - offsetX + (cy - offsetY) * width)*channels + channel] = fullTileBuffer[(cx + cy * fullTileBufferWidth)*channels + channel];
-                    }
-                }
-            }
-        }
     } else {
         auto levelData = m_levels[level];
         for(int cy = y; cy < std::min(y + height, levelHeight); ++cy) {
@@ -427,6 +371,74 @@ std::shared_ptr<Image> ImagePyramidAccess::getPatchAsImage(int level, int tileX,
     }
 }
 
+/**
+ * Downsample a tile by a factor of 2, and write it to the given quadrant of a tile on the next level.
+ * Average is used for RGB(A) images, and max for single channel images (e.g. segmentations).
+ */
+static void downsampleTile(const uchar* previousData, int previousTileWidth, uchar* newData, int tileWidth, int tileHeight, int offsetX, int offsetY, int channels) {
+    if(channels >= 3) {
+        // Use average if RGB(A) image
+        for(int dy = 0; dy < tileHeight/2; ++dy) {
+            for(int dx = 0; dx < tileWidth/2; ++dx) {
+                for(int c = 0; c < channels; ++c) {
+                    newData[c + channels*(dx + offsetX * tileWidth / 2 + (dy + offsetY * tileHeight / 2) * tileWidth)] =
+                        (uchar)round((float)(
+                            previousData[c + channels*(dx * 2 + dy * 2 * previousTileWidth)] +
+                            previousData[c + channels*(dx * 2 + 1 + dy * 2 * previousTileWidth)] +
+                            previousData[c + channels*(dx * 2 + 1 + (dy * 2 + 1) * previousTileWidth)] +
+                            previousData[c + channels*(dx * 2 + (dy * 2 + 1) * previousTileWidth)]
+                            ) / 4);
+                }
+            }
+        }
+    } else {
+        // Use majority vote if single channel image.
+        for(int dy = 0; dy < tileHeight/2; ++dy) {
+            for(int dx = 0; dx < tileWidth/2; ++dx) {
+                /*
+                // This is more correct, but 100 times slower than just doing max.
+                std::vector<uchar> list = {
+                        previousData[dx*2 + dy*2*previousTileWidth],
+                        previousData[dx*2 + 1 + dy*2*previousTileWidth],
+                        previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
+                        previousData[dx*2 + (dy*2+1)*previousTileWidth]
+                };
+                std::sort(list.begin(), list.end());
+                if(list[0] == list[1]) { // If there is more than of element 0, it should be placed as element 1
+                    newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[0];
+                } else { // If not, it means that there is more than 1 of element 1, OR all 4 values are different and its no matter which is picked.
+                    newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[2];
+                }*/
+
+                // Just do max? 0.006 milliseconds
+                uchar list[4] = {
+                        previousData[dx*2 + dy*2*previousTileWidth],
+                        previousData[dx*2 + 1 + dy*2*previousTileWidth],
+                        previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
+                        previousData[dx*2 + (dy*2+1)*previousTileWidth]
+                };
+                newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = std::max(std::max(std::max(list[0], list[1]), list[2]), list[3]);
+            }
+        }
+    }
+}
+
+TileID ImagePyramidAccess::getTileID(int level, int x, int y) {
+    return TileID(level, x / m_image->getLevelTileWidth(level), y / m_image->getLevelTileHeight(level));
+}
+
+void ImagePyramidAccess::writeTIFFTile(int level, int x, int y, uchar* data) {
+    setTIFFDirectory(m_tiffHandle, level);
+    TIFFWriteTile(m_tiffHandle, (void *) data, x, y, 0, 0);
+    m_image->m_tiffDirectoryModified = true;
+    m_initializedPatchList.insert(getTileID(level, x, y));
+}
+
+void ImagePyramidAccess::checkpointTIFFDirectory() {
+    TIFFCheckpointDirectory(m_tiffHandle);
+    m_image->m_tiffDirectoryModified = false;
+}
+
 void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch) {
     if(m_tiffHandle == nullptr)
         throw Exception("setPatch only available for TIFF backend ImagePyramids");
@@ -454,15 +466,17 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
     // Write tile to this level
     auto patchAccess = patch->getImageAccess(ACCESS_READ);
     auto data = (uchar*)patchAccess->get();
-    uint32_t tile_id;
+    const bool deferred = m_image->getDeferredLevelBuilding() && level == 0;
     {
         std::lock_guard<std::mutex> lock(m_readMutex);
-        TIFFSetDirectory(m_tiffHandle, level);
-        TIFFWriteTile(m_tiffHandle, (void *) data, x, y, 0, 0);
-        TIFFCheckpointDirectory(m_tiffHandle);
-        tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
+        writeTIFFTile(level, x, y, data);
+        // When deferred, the directory is written to file when changing directory or building the pyramid levels
+        if(deferred) {
+            m_image->m_deferredTiles.insert({x / m_image->getLevelTileWidth(level), y / m_image->getLevelTileHeight(level)});
+        } else {
+            checkpointTIFFDirectory();
+        }
     }
-    m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(tile_id));
 
     // Add patch to list of dirty patches, so the renderer can update it if needed
     int levelWidth = m_image->getLevelWidth(level);
@@ -472,6 +486,8 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
     int patchIdX = std::floor(((float)x / levelWidth) * tilesX);
     int patchIdY = std::floor(((float)y / levelHeight) * tilesY);
     m_image->setDirtyPatch(level, patchIdX, patchIdY);
+    if(deferred)
+        return;
 
     // Propagate upwards
     auto previousData = std::make_unique<uchar[]>(patch->getNrOfVoxels()*patch->getNrOfChannels());
@@ -479,7 +495,6 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
     const auto channels = m_image->getNrOfChannels();
     while(level < m_image->getNrOfLevels()-1) {
         const auto previousTileWidth = m_image->getLevelTileWidth(level);
-        const auto previousTileHeight = m_image->getLevelTileHeight(level);
         ++level;
         x /= 2;
         y /= 2;
@@ -494,58 +509,11 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
         auto newData = getPatchData(level, x, y, tileWidth, tileHeight);
 
         // Downsample tile from previous level and add it to existing tile
-        if(m_image->getNrOfChannels() >= 3) {
-            const int channels = m_image->getNrOfChannels();
-            // Use average if RGB(A) image
-            for(int dy = 0; dy < tileHeight/2; ++dy) {
-                for(int dx = 0; dx < tileWidth/2; ++dx) {
-                    for(int c = 0; c < channels; ++c) {
-                        newData[c + channels*(dx + offsetX * tileWidth / 2 + (dy + offsetY * tileHeight / 2) * tileWidth)] =
-                            (uchar)round((float)(
-                                previousData[c + channels*(dx * 2 + dy * 2 * previousTileWidth)] +
-                                previousData[c + channels*(dx * 2 + 1 + dy * 2 * previousTileWidth)] +
-                                previousData[c + channels*(dx * 2 + 1 + (dy * 2 + 1) * previousTileWidth)] +
-                                previousData[c + channels*(dx * 2 + (dy * 2 + 1) * previousTileWidth)]
-                                ) / 4);
-                    }
-                }
-            }
-        } else {
-            // Use majority vote if single channel image.
-            for(int dy = 0; dy < tileHeight/2; ++dy) {
-                for(int dx = 0; dx < tileWidth/2; ++dx) {
-                    /*
-                    // This is more correct, but 100 times slower than just doing max.
-                    std::vector<uchar> list = {
-                            previousData[dx*2 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
-                            previousData[dx*2 + (dy*2+1)*previousTileWidth]
-                    };
-                    std::sort(list.begin(), list.end());
-                    if(list[0] == list[1]) { // If there is more than of element 0, it should be placed as element 1
-                        newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[0];
-                    } else { // If not, it means that there is more than 1 of element 1, OR all 4 values are different and its no matter which is picked.
-                        newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[2];
-                    }*/
-
-                    // Just do max? 0.006 milliseconds
-                    uchar list[4] = {
-                            previousData[dx*2 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
-                            previousData[dx*2 + (dy*2+1)*previousTileWidth]
-                    };
-                    newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = std::max(std::max(std::max(list[0], list[1]), list[2]), list[3]);
-                }
-            }
-        }
+        downsampleTile(previousData.get(), previousTileWidth, newData.get(), tileWidth, tileHeight, offsetX, offsetY, channels);
         {
             std::lock_guard<std::mutex> lock(m_readMutex);
-            TIFFSetDirectory(m_tiffHandle, level);
-            TIFFWriteTile(m_tiffHandle, (void *) newData.get(), x, y, 0, 0);
-            TIFFCheckpointDirectory(m_tiffHandle);
-            tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
+            writeTIFFTile(level, x, y, newData.get());
+            checkpointTIFFDirectory();
         }
         previousData = std::move(newData);
 
@@ -556,17 +524,81 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
         int patchIdX = std::floor(((float)x / levelWidth) * tilesX);
         int patchIdY = std::floor(((float)y / levelHeight) * tilesY);
         m_image->setDirtyPatch(level, patchIdX, patchIdY);
-        m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(tile_id));
     }
 }
 
+void ImagePyramidAccess::buildPyramidLevels() {
+    if(m_tiffHandle == nullptr)
+        throw Exception("buildPyramidLevels only available for TIFF backend ImagePyramids");
+    if(!m_write)
+        throw Exception("buildPyramidLevels requires an ImagePyramidAccess with ACCESS_READ_WRITE");
+
+    std::set<std::pair<int, int>> tiles;
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        tiles.swap(m_image->m_deferredTiles);
+        // Write the deferred level 0 tiles to file before they are read back below
+        if(m_image->m_tiffDirectoryModified)
+            checkpointTIFFDirectory();
+    }
+    const int channels = m_image->getNrOfChannels();
+    // Tiles are read and written in batches, so that directories are changed and written to file once per batch
+    // instead of once per tile, while bounding the memory usage.
+    const int batchSize = 64;
+    for(int level = 1; level < m_image->getNrOfLevels() && !tiles.empty(); ++level) {
+        const int previousTileWidth = m_image->getLevelTileWidth(level-1);
+        const int tileWidth = m_image->getLevelTileWidth(level);
+        const int tileHeight = m_image->getLevelTileHeight(level);
+        std::set<std::pair<int, int>> parentTiles;
+        for(const auto& tile : tiles)
+            parentTiles.insert({tile.first / 2, tile.second / 2});
+        const std::vector<std::pair<int, int>> parentList(parentTiles.begin(), parentTiles.end());
+        for(int start = 0; start < parentList.size(); start += batchSize) {
+            const int count = std::min(batchSize, (int)parentList.size() - start);
+            // Read the modified tiles of the previous level, then the existing tiles of this level
+            std::vector<std::shared_ptr<uchar[]>> previousData(count*4);
+            for(int i = 0; i < count; ++i) {
+                for(int quadrant = 0; quadrant < 4; ++quadrant) {
+                    const std::pair<int, int> tile = {parentList[start + i].first*2 + quadrant % 2, parentList[start + i].second*2 + quadrant / 2};
+                    if(tiles.count(tile) > 0)
+                        previousData[i*4 + quadrant] = getTileData(level-1, tile.first, tile.second);
+                }
+            }
+            std::vector<std::unique_ptr<uchar[]>> newData(count);
+            for(int i = 0; i < count; ++i)
+                newData[i] = getPatchData(level, parentList[start + i].first*tileWidth, parentList[start + i].second*tileHeight, tileWidth, tileHeight);
+
+            #pragma omp parallel for
+            for(int i = 0; i < count; ++i) {
+                for(int quadrant = 0; quadrant < 4; ++quadrant) {
+                    if(previousData[i*4 + quadrant])
+                        downsampleTile(previousData[i*4 + quadrant].get(), previousTileWidth, newData[i].get(), tileWidth, tileHeight, quadrant % 2, quadrant / 2, channels);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_readMutex);
+                for(int i = 0; i < count; ++i)
+                    writeTIFFTile(level, parentList[start + i].first*tileWidth, parentList[start + i].second*tileHeight, newData[i].get());
+                checkpointTIFFDirectory();
+            }
+            for(int i = 0; i < count; ++i)
+                m_image->setDirtyPatch(level, parentList[start + i].first, parentList[start + i].second);
+        }
+        tiles = std::move(parentTiles);
+    }
+
+    // Make sure all tiles written are stored in the file
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    if(m_image->m_tiffDirectoryModified)
+        checkpointTIFFDirectory();
+}
+
 bool ImagePyramidAccess::isPatchInitialized(uint level, uint x, uint y) {
     if(m_image->isPyramidFullyInitialized())
         return true;
     std::lock_guard<std::mutex> lock(m_readMutex);
-    TIFFSetDirectory(m_tiffHandle, level);
-    auto tile = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-    return m_initializedPatchList.count(std::to_string(level) + "-" + std::to_string(tile)) > 0;
+    return m_initializedPatchList.count(getTileID(level, x, y)) > 0;
 }
 
 }
@@ -4,6 +4,9 @@
 #include <FAST/Data/DataTypes.hpp>
 #include <unordered_set>
 #include <fstream>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
 
 // Forward declare
 typedef struct _openslide openslide_t;
@@ -46,6 +49,57 @@ public:
 	int offsetY;
 };
 
+/**
+ * @brief Identifier of a tile in an image pyramid
+ *
+ * Level, tile x and tile y index packed into a single 64 bit integer, which is cheap to copy, compare and hash.
+ * 8 bits are used for the level and 28 bits for each of the tile indices.
+ *
+ * @ingroup wsi
+ */
+class FAST_EXPORT TileID {
+public:
+    TileID() = default;
+    TileID(int level, int tileX, int tileY) :
+        m_value(((uint64_t)level << 56) | (((uint64_t)tileX & m_indexMask) << 28) | ((uint64_t)tileY & m_indexMask)) {};
+    int getLevel() const { return (int)(m_value >> 56); };
+    int getTileX() const { return (int)((m_value >> 28) & m_indexMask); };
+    int getTileY() const { return (int)(m_value & m_indexMask); };
+    uint64_t getValue() const { return m_value; };
+    /**
+     * @brief String representation on the form level_x_y
+     */
+    std::string toString() const {
+        return std::to_string(getLevel()) + "_" + std::to_string(getTileX()) + "_" + std::to_string(getTileY());
+    };
+    bool operator==(const TileID& other) const { return m_value == other.m_value; };
+    bool operator!=(const TileID& other) const { return m_value != other.m_value; };
+    bool operator<(const TileID& other) const { return m_value < other.m_value; };
+private:
+    static constexpr uint64_t m_indexMask = (1 << 28) - 1;
+    uint64_t m_value = 0;
+};
+
+}
+
+#ifndef SWIG
+namespace std {
+template <>
+struct hash<fast::TileID> {
+    std::size_t operator()(const fast::TileID& tile) const {
+        // Mix the bits, so that all of level, x and y affect the bucket index
+        uint64_t value = tile.getValue();
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        return (std::size_t)value;
+    }
+};
+}
+#endif
+
+namespace fast {
+
 class FAST_EXPORT ImagePyramidLevel {
 public:
 	int width;
@@ -64,14 +118,112 @@ public:
 #endif
 };
 
+#ifndef SWIG
+/**
+ * @brief A pool of read-only handles to the same file
+ *
+ * Used to read tiles of an image pyramid with multiple threads in parallel, without
+ * a global mutex. Handles are opened on demand, up to a maximum number. If all handles are in use,
+ * acquire() blocks until one is released.
+ *
+ * @tparam Handle file handle type, e.g. TIFF*
+ */
+template <class Handle>
+class FileHandlePool {
+    public:
+        /**
+         * @brief RAII object which returns the handle to the pool when destroyed
+         */
+        class Lease {
+            public:
+                Lease(FileHandlePool* pool, Handle handle) : m_pool(pool), m_handle(handle) {};
+                Lease(Lease&& other) noexcept : m_pool(other.m_pool), m_handle(other.m_handle) { other.m_pool = nullptr; };
+                Lease(const Lease&) = delete;
+                Handle get() const { return m_handle; };
+                ~Lease() { if(m_pool != nullptr) m_pool->release(m_handle); };
+            private:
+                FileHandlePool* m_pool;
+                Handle m_handle;
+        };
+        FileHandlePool(std::function<Handle()> open, std::function<void(Handle)> close, int maximumHandles) :
+            m_open(std::move(open)), m_close(std::move(close)), m_maximumHandles(std::max(1, maximumHandles)) {};
+        Lease acquire() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_free.empty() && m_handles >= m_maximumHandles)
+                m_released.wait(lock);
+            if(!m_free.empty()) {
+                Handle handle = m_free.back();
+                m_free.pop_back();
+                return Lease(this, handle);
+            }
+            ++m_handles;
+            lock.unlock();
+            Handle handle;
+            try {
+                handle = m_open();
+            } catch(...) {
+                lock.lock();
+                --m_handles;
+                m_released.notify_one();
+                throw;
+            }
+            return Lease(this, handle);
+        };
+        int getNumberOfHandles() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_handles;
+        };
+        ~FileHandlePool() {
+            for(auto handle : m_free)
+                m_close(handle);
+        };
+    private:
+        void release(Handle handle) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_free.push_back(handle);
+            }
+            m_released.notify_one();
+        };
+        std::function<Handle()> m_open;
+        std::function<void(Handle)> m_close;
+        int m_maximumHandles;
+        int m_handles = 0;
+        std::vector<Handle> m_free;
+        std::mutex m_mutex;
+        std::condition_variable m_released;
+};
+#endif
+
 class FAST_EXPORT ImagePyramidAccess : Object {
 public:
 	typedef std::unique_ptr<ImagePyramidAccess> pointer;
-	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, TIFF* tiffHandle, std::ifstream* stream, std::vector<vsi_tile_header>& vsiTiles, std::shared_ptr<ImagePyramid> imagePyramid, bool writeAccess, std::unordered_set<std::string>& initializedPatchList, std::mutex& readMutex, ImageCompression compressionFormat);
+	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, TIFF* tiffHandle, std::ifstream* stream, std::vector<vsi_tile_header>& vsiTiles, std::shared_ptr<ImagePyramid> imagePyramid, bool writeAccess, std::unordered_set<TileID>& initializedPatchList, std::mutex& readMutex, ImageCompression compressionFormat);
+#ifndef SWIG
+	/**
+	 * Set pools of read-only file handles. If set, these are used to read tiles in parallel instead of the
+	 * single shared file handle which is protected by the read mutex.
+	 */
+	void setReadHandlePools(std::shared_ptr<FileHandlePool<TIFF*>> tiffReadHandles, std::shared_ptr<FileHandlePool<std::ifstream*>> vsiReadHandles);
+#endif
+	/**
+	 * @brief Write a patch to the image pyramid, and update the corresponding tiles on the coarser levels
+	 *
+	 * If deferred level building is enabled on the image pyramid, and level is 0, only the level 0 tile is
+	 * written. The coarser levels are then updated when buildPyramidLevels is called.
+	 */
 	void setPatch(int level, int x, int y, std::shared_ptr<Image> patch);
+	/**
+	 * @brief Build the coarser levels from all level 0 tiles written since the last call in deferred mode
+	 *
+	 * Tiles are processed level by level in batches, with the downsampling done in parallel.
+	 * Afterwards, all tiles are written to file.
+	 * See ImagePyramid::setDeferredLevelBuilding.
+	 */
+	void buildPyramidLevels();
 	bool isPatchInitialized(uint level, uint x, uint y);
 	std::unique_ptr<uchar[]> getPatchData(int level, int x, int y, int width, int height);
-	ImagePyramidPatch getPatch(std::string tile);
+	ImagePyramidPatch getPatch(TileID tile);
 	ImagePyramidPatch getPatch(int level, int patchX, int patchY);
 	std::shared_ptr<Image> getLevelAsImage(int level);
 	std::shared_ptr<Image> getPatchAsImage(int level, int offsetX, int offsetY, int width, int height, bool convertToRGB = true);
@@ -84,12 +236,30 @@ private:
 	bool m_write;
 	openslide_t* m_fileHandle = nullptr;
 	TIFF* m_tiffHandle = nullptr;
-    std::unordered_set<std::string>& m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
+    std::unordered_set<TileID>& m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
     std::mutex& m_readMutex;
     std::ifstream* m_vsiHandle;
     ImageCompression m_compressionFormat;
     std::vector<vsi_tile_header> m_vsiTiles;
+#ifndef SWIG
+    std::shared_ptr<FileHandlePool<TIFF*>> m_tiffReadHandles;
+    std::shared_ptr<FileHandlePool<std::ifstream*>> m_vsiReadHandles;
+#endif
     void readVSITileToBuffer(vsi_tile_header tile, uchar* data);
+    void readVSITileBytes(vsi_tile_header tile, char* buffer);
+    void setTIFFDirectory(TIFF* tiff, int level);
+    // Get ID of the tile containing pixel x, y of the given level
+    TileID getTileID(int level, int x, int y);
+    // Write a tile to the shared TIFF handle, read mutex must be locked
+    void writeTIFFTile(int level, int x, int y, uchar* data);
+    // Write current directory of the shared TIFF handle to file, read mutex must be locked
+    void checkpointTIFFDirectory();
+    /**
+     * Get decoded data of a tile of a TIFF or VSI pyramid, using the ImagePyramidTileCache.
+     * Returns nullptr if tile is missing.
+     */
+    std::shared_ptr<uchar[]> getTileData(int level, int tileX, int tileY);
 };
 
-}
\ No newline at end of file
+}
+
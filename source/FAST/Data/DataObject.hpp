@@ -2,6 +2,7 @@
 
 #include "FAST/Object.hpp"
 #include "FAST/ExecutionDevice.hpp"
+#include "FAST/Data/FrameData.hpp"
 #include <map>
 #include <set>
 #include <condition_variable>
@@ -46,12 +47,35 @@ class FAST_EXPORT  DataObject : public Object {
         void clearLastFrame();
         std::set<std::string> getLastFrame();
         void setFrameData(std::string name, std::string value);
+        void setFrameData(std::string name, int value);
+        void setFrameData(std::string name, float value);
+        void setFrameData(std::string name, const Matrix4f& value);
         void setFrameData(std::map<std::string, std::string> frameData);
         std::string getFrameData(std::string name);
+        /**
+         * @brief Get frame data value converted to a given type
+         * @tparam T int, float or Matrix4f
+         * @param name
+         * @return value
+         */
         template <class T>
         T getFrameData(std::string name);
         bool hasFrameData(std::string name) const;
         std::map<std::string, std::string> getFrameData();
+#ifndef SWIG
+        /**
+         * @brief Get all frame data of this object as a typed store
+         */
+        const FrameData& getFrameDataContainer() const;
+        /**
+         * @brief Replace all frame data of this object. The entries are shared, not copied.
+         */
+        void setFrameDataContainer(const FrameData& frameData);
+        /**
+         * @brief Add frame data, overwriting existing entries with the same name
+         */
+        void addFrameData(const FrameData& frameData);
+#endif
         void accessFinished();
     protected:
         virtual void free(ExecutionDevice::pointer device) = 0;
@@ -79,7 +103,7 @@ class FAST_EXPORT  DataObject : public Object {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::set<std::string> m_lastFrame;
 
@@ -90,5 +114,7 @@ template <>
 int DataObject::getFrameData(std::string name);
 template <>
 float DataObject::getFrameData(std::string name);
+template <>
+Matrix4f DataObject::getFrameData(std::string name);
 
 }
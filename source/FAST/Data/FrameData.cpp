@@ -0,0 +1,252 @@
+#include "FrameData.hpp"
+#include <FAST/Utility.hpp>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace fast {
+
+namespace {
+// Process-wide table of interned key names
+struct KeyTable {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, uint32_t> keys;
+    std::vector<std::string> names;
+};
+
+KeyTable& getKeyTable() {
+    // Never deleted, since data objects may be destroyed after static objects at program exit
+    static KeyTable* table = new KeyTable();
+    return *table;
+}
+
+std::string floatToString(float value) {
+    std::ostringstream stream;
+    stream.precision(std::numeric_limits<float>::max_digits10);
+    stream << value;
+    return stream.str();
+}
+
+bool compareKey(const std::pair<uint32_t, FrameData::Value>& entry, uint32_t key) {
+    return entry.first < key;
+}
+}
+
+uint32_t FrameData::getKey(const std::string& name) {
+    auto& table = getKeyTable();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.keys.find(name);
+        if(it != table.keys.end())
+            return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.keys.find(name);
+    if(it != table.keys.end())
+        return it->second;
+    const uint32_t key = table.names.size();
+    table.names.push_back(name);
+    table.keys[name] = key;
+    return key;
+}
+
+bool FrameData::findKey(const std::string& name, uint32_t& key) {
+    auto& table = getKeyTable();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.keys.find(name);
+    if(it == table.keys.end())
+        return false;
+    key = it->second;
+    return true;
+}
+
+uint32_t FrameData::getExistingKey(const std::string& name) {
+    uint32_t key;
+    if(!findKey(name, key))
+        throw Exception("Frame data " + name + " does not exist.");
+    return key;
+}
+
+std::string FrameData::getKeyName(uint32_t key) {
+    auto& table = getKeyTable();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    if(key >= table.names.size())
+        throw Exception("Frame data key " + std::to_string(key) + " does not exist.");
+    return table.names[key];
+}
+
+FrameData::Entries& FrameData::modify() {
+    if(!m_entries) {
+        m_entries = std::make_shared<Entries>();
+    } else if(m_entries.use_count() > 1) {
+        m_entries = std::make_shared<Entries>(*m_entries);
+    }
+    // The entries are owned by this store only at this point
+    return const_cast<Entries&>(*m_entries);
+}
+
+void FrameData::set(uint32_t key, Value value) {
+    auto& entries = modify();
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, compareKey);
+    if(it != entries.end() && it->first == key) {
+        it->second = std::move(value);
+    } else {
+        entries.insert(it, {key, std::move(value)});
+    }
+}
+
+void FrameData::set(const std::string& name, Value value) {
+    set(getKey(name), std::move(value));
+}
+
+bool FrameData::has(uint32_t key) const {
+    if(!m_entries)
+        return false;
+    auto it = std::lower_bound(m_entries->begin(), m_entries->end(), key, compareKey);
+    return it != m_entries->end() && it->first == key;
+}
+
+bool FrameData::has(const std::string& name) const {
+    uint32_t key;
+    if(empty() || !findKey(name, key))
+        return false;
+    return has(key);
+}
+
+void FrameData::remove(const std::string& name) {
+    uint32_t key;
+    if(!findKey(name, key) || !has(key))
+        return;
+    auto& entries = modify();
+    entries.erase(std::lower_bound(entries.begin(), entries.end(), key, compareKey));
+}
+
+const FrameData::Value& FrameData::get(uint32_t key) const {
+    if(m_entries) {
+        auto it = std::lower_bound(m_entries->begin(), m_entries->end(), key, compareKey);
+        if(it != m_entries->end() && it->first == key)
+            return it->second;
+    }
+    throw Exception("Frame data " + getKeyName(key) + " does not exist.");
+}
+
+std::string FrameData::getString(uint32_t key) const {
+    const Value& value = get(key);
+    if(auto intValue = std::get_if<int>(&value))
+        return std::to_string(*intValue);
+    if(auto floatValue = std::get_if<float>(&value))
+        return floatToString(*floatValue);
+    if(auto matrixValue = std::get_if<Matrix4f>(&value)) {
+        std::string result;
+        for(int i = 0; i < 16; ++i)
+            result += floatToString(matrixValue->data()[i]) + " ";
+        return result;
+    }
+    return std::get<std::string>(value);
+}
+
+std::string FrameData::getString(const std::string& name) const {
+    return getString(getExistingKey(name));
+}
+
+int FrameData::getInt(uint32_t key) const {
+    const Value& value = get(key);
+    if(auto intValue = std::get_if<int>(&value))
+        return *intValue;
+    if(auto floatValue = std::get_if<float>(&value))
+        return (int)*floatValue;
+    if(auto stringValue = std::get_if<std::string>(&value))
+        return std::stoi(*stringValue);
+    throw Exception("Frame data " + getKeyName(key) + " is a matrix and can't be converted to int.");
+}
+
+int FrameData::getInt(const std::string& name) const {
+    return getInt(getExistingKey(name));
+}
+
+float FrameData::getFloat(uint32_t key) const {
+    const Value& value = get(key);
+    if(auto floatValue = std::get_if<float>(&value))
+        return *floatValue;
+    if(auto intValue = std::get_if<int>(&value))
+        return (float)*intValue;
+    if(auto stringValue = std::get_if<std::string>(&value))
+        return std::stof(*stringValue);
+    throw Exception("Frame data " + getKeyName(key) + " is a matrix and can't be converted to float.");
+}
+
+float FrameData::getFloat(const std::string& name) const {
+    return getFloat(getExistingKey(name));
+}
+
+Matrix4f FrameData::getMatrix(uint32_t key) const {
+    const Value& value = get(key);
+    if(auto matrixValue = std::get_if<Matrix4f>(&value))
+        return *matrixValue;
+    if(auto stringValue = std::get_if<std::string>(&value)) {
+        auto parts = split(*stringValue);
+        if(parts.size() != 16)
+            throw Exception("Frame data " + getKeyName(key) + " does not contain 16 values and can't be converted to a matrix.");
+        Matrix4f matrix;
+        for(int i = 0; i < 16; ++i)
+            matrix.data()[i] = std::stof(parts[i]);
+        return matrix;
+    }
+    throw Exception("Frame data " + getKeyName(key) + " is a number and can't be converted to a matrix.");
+}
+
+Matrix4f FrameData::getMatrix(const std::string& name) const {
+    return getMatrix(getExistingKey(name));
+}
+
+void FrameData::merge(const FrameData& other) {
+    if(other.empty() || m_entries == other.m_entries)
+        return;
+    if(empty()) {
+        m_entries = other.m_entries;
+        return;
+    }
+    // If all keys in this store exist in the other store, the result is equal to the other store
+    bool subset = true;
+    auto otherIt = other.m_entries->begin();
+    for(auto& entry : *m_entries) {
+        while(otherIt != other.m_entries->end() && otherIt->first < entry.first)
+            ++otherIt;
+        if(otherIt == other.m_entries->end() || otherIt->first != entry.first) {
+            subset = false;
+            break;
+        }
+    }
+    if(subset) {
+        m_entries = other.m_entries;
+        return;
+    }
+    for(auto& entry : *other.m_entries)
+        set(entry.first, entry.second);
+}
+
+std::map<std::string, std::string> FrameData::toMap() const {
+    std::map<std::string, std::string> result;
+    if(!m_entries)
+        return result;
+    for(auto& entry : *m_entries)
+        result[getKeyName(entry.first)] = getString(entry.first);
+    return result;
+}
+
+std::size_t FrameData::size() const {
+    return m_entries ? m_entries->size() : 0;
+}
+
+bool FrameData::empty() const {
+    return size() == 0;
+}
+
+void FrameData::clear() {
+    m_entries.reset();
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+#include <map>
+#include <variant>
+#include <vector>
+
+namespace fast {
+
+/**
+ * @brief Typed key-value store for the frame data of a DataObject
+ *
+ * Frame data is transferred from the input to the output of process objects, e.g. the position of a patch
+ * from PatchGenerator to PatchStitcher. Values are stored as int, float, string or 4x4 matrix.
+ * Key names are interned to integer IDs, and entries are kept in a small vector sorted by key ID.
+ *
+ * The entries are shared between copies, and only copied when a shared store is modified (copy-on-write).
+ * Thus propagating frame data from input to output data is only a reference count increment.
+ *
+ * Any value can be read as a string, and string values are parsed when read as numbers or matrices.
+ * This keeps the string based frame data API of DataObject working.
+ *
+ * @ingroup data
+ */
+class FAST_EXPORT FrameData {
+    public:
+        typedef std::variant<int, float, std::string, Matrix4f> Value;
+        /**
+         * @brief Get integer ID of a key name. The same name always gives the same ID.
+         * @param name
+         * @return key ID
+         */
+        static uint32_t getKey(const std::string& name);
+        static std::string getKeyName(uint32_t key);
+
+        void set(uint32_t key, Value value);
+        void set(const std::string& name, Value value);
+        bool has(uint32_t key) const;
+        bool has(const std::string& name) const;
+        void remove(const std::string& name);
+        /**
+         * @brief Get value as a string. Numbers are converted with enough digits to not lose precision.
+         */
+        std::string getString(uint32_t key) const;
+        std::string getString(const std::string& name) const;
+        int getInt(uint32_t key) const;
+        int getInt(const std::string& name) const;
+        float getFloat(uint32_t key) const;
+        float getFloat(const std::string& name) const;
+        /**
+         * @brief Get value as a matrix. A string value must have 16 numbers separated by spaces, in column-major order.
+         */
+        Matrix4f getMatrix(uint32_t key) const;
+        Matrix4f getMatrix(const std::string& name) const;
+        /**
+         * @brief Add all entries of another store, overwriting entries with the same key
+         *
+         * If this store is empty, or all keys of this store also exist in the other store, the
+         * entries of the other store are shared instead of copied.
+         * @param other
+         */
+        void merge(const FrameData& other);
+        /**
+         * @brief Get all entries with values converted to strings
+         */
+        std::map<std::string, std::string> toMap() const;
+        std::size_t size() const;
+        bool empty() const;
+        void clear();
+    private:
+        typedef std::vector<std::pair<uint32_t, Value>> Entries;
+        // Look up ID of a key name without adding it
+        static bool findKey(const std::string& name, uint32_t& key);
+        static uint32_t getExistingKey(const std::string& name);
+        const Value& get(uint32_t key) const;
+        // Get entries for modification, copy them first if they are shared
+        Entries& modify();
+        std::shared_ptr<const Entries> m_entries;
+};
+
+}
@@ -126,7 +126,13 @@ void Image::transferCLImageToHost(OpenCLDevice::pointer device) {
         device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
         CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
                 0, tempData.get());
-        mHostData = adaptImageDataToHostData(std::move(tempData), CL_RGBA, mWidth*mHeight*mDepth,mType,mChannels);
+        auto hostData = adaptImageDataToHostData(std::move(tempData), CL_RGBA, mWidth*mHeight*mDepth,mType,mChannels);
+        if(mHostHasData) {
+            // Write to the existing host memory, as it may be shared with another library, e.g. numpy
+            std::memcpy(mHostData.get(), hostData.get(), getSizeOfDataType(mType, mChannels)*mWidth*mHeight*mDepth);
+        } else {
+            mHostData = std::move(hostData);
+        }
     } else {
         if(!mHostHasData) {
             // Must allocate memory for host data
@@ -437,6 +443,12 @@ Image::Image() {
     mIsInitialized = false;
 }
 
+std::shared_ptr<void> Image::getSharedHostData() {
+    // Access makes sure host data is up to date
+    auto access = getImageAccess(ACCESS_READ);
+    return mHostData;
+}
+
 ImageAccess::pointer Image::getImageAccess(accessType type) {
     if(!isInitialized())
         throw Exception("Image has not been initialized.");
@@ -510,6 +522,20 @@ Image::Image(
     copyData(DeviceManager::getInstance()->getDefaultDevice(), data);
 }
 
+Image::Image(
+        VectorXui size,
+        DataType type,
+        unsigned int nrOfChannels,
+        std::shared_ptr<void> data) : Image() {
+    if(!data)
+        throw Exception("Data given to Image was null");
+    init(size, type, nrOfChannels);
+    // Data is shared, no need to copy it
+    mHostData = std::move(data);
+    mHostHasData = true;
+    mHostDataIsUpToDate = true;
+}
+
 
 Image::Image(
         unsigned int width,
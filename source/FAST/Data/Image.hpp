@@ -137,6 +137,16 @@ class FAST_EXPORT Image : public SpatialDataObject {
          * @param data
          */
         FAST_CONSTRUCTOR(Image, VectorXui, size,, DataType, type,, uint, nrOfChannels,, const void* const, data,);
+        /**
+         * Create a 2D/3D image on host which uses the provided data without copying it.
+         * The data is kept alive as long as the image exists.
+         *
+         * @param size
+         * @param type
+         * @param nrOfChannels
+         * @param data
+         */
+        FAST_CONSTRUCTOR(Image, VectorXui, size,, DataType, type,, uint, nrOfChannels,, std::shared_ptr<void>, data,);
 #endif
         /**
          * Copies 2D data to default device
@@ -236,6 +246,16 @@ class FAST_EXPORT Image : public SpatialDataObject {
         OpenCLImageAccess::pointer getOpenCLImageAccess(accessType type, OpenCLDevice::pointer);
         OpenCLBufferAccess::pointer getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer);
         ImageAccess::pointer getImageAccess(accessType type);
+#ifndef SWIG
+        /**
+         * @brief Get up to date host data, shared with this image
+         *
+         * The returned pointer keeps the data valid even if the image is deleted, or moves its host data.
+         * This is used to give other libraries, e.g. numpy, access to the data without copying it.
+         * Changes made through this pointer are not tracked, use getImageAccess to modify the image.
+         */
+        std::shared_ptr<void> getSharedHostData();
+#endif
         OpenGLTextureAccess::pointer getOpenGLTextureAccess(accessType type, OpenCLDevice::pointer, bool compress = false, bool getOwnership = false);
 
         ~Image();
@@ -323,8 +343,8 @@ class FAST_EXPORT Image : public SpatialDataObject {
         std::unordered_map<OpenCLDevice::pointer, cl::Buffer*> mCLBuffers;
         std::unordered_map<OpenCLDevice::pointer, bool> mCLBuffersIsUpToDate;
 
-        // Host data
-        unique_pixel_ptr mHostData;
+        // Host data. Shared, as the data may be owned by another library, or viewed by it (see getSharedHostData)
+        std::shared_ptr<void> mHostData;
         bool mHostHasData;
         bool mHostDataIsUpToDate;
 
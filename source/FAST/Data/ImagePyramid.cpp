@@ -8,7 +8,9 @@
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Image.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
+#include <FAST/Data/ImagePyramidTileCache.hpp>
 #include <utility>
+#include <atomic>
 #ifdef WIN32
 #include <winbase.h>
 #else
@@ -236,6 +238,12 @@ void ImagePyramid::free(ExecutionDevice::pointer device) {
 }
 
 void ImagePyramid::freeAll() {
+    ImagePyramidTileCache::getInstance()->remove(m_tileCacheID);
+    {
+        std::lock_guard<std::mutex> lock(m_readHandlesMutex);
+        m_tiffReadHandles.reset();
+        m_vsiReadHandles.reset();
+    }
     if(m_fileHandle != nullptr) {
         m_levels.clear();
         openslide_close(m_fileHandle);
@@ -285,6 +293,8 @@ ImagePyramidAccess::pointer ImagePyramid::getAccess(accessType type) {
 
     if(type == ACCESS_READ_WRITE) {
     	blockIfBeingAccessed();
+        // Tiles may change, thus cached tiles are no longer valid
+        ImagePyramidTileCache::getInstance()->remove(m_tileCacheID);
         std::unique_lock<std::mutex> lock(mDataIsBeingWrittenToMutex);
         mDataIsBeingWrittenTo = true;
     }
@@ -298,30 +308,156 @@ ImagePyramidAccess::pointer ImagePyramid::getAccess(accessType type) {
         std::unique_lock<std::mutex> lock(mDataIsBeingAccessedMutex);
         mDataIsBeingAccessed = true;
     }
-    return std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, m_tiffHandle, m_vsiFileHandle, m_vsiTiles, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE, m_initializedPatchList, m_readMutex, m_compressionFormat);
+    auto access = std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, m_tiffHandle, m_vsiFileHandle, m_vsiTiles, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE, m_initializedPatchList, m_readMutex, m_compressionFormat);
+    if(type == ACCESS_READ && !m_tempFile && !m_filePath.empty() && m_maximumNumberOfReadHandles > 1) {
+        // Imported pyramids are read-only, thus multiple handles to the same file can be used to read in parallel
+        std::lock_guard<std::mutex> lock(m_readHandlesMutex);
+        if(m_tiffHandle != nullptr && !m_tiffReadHandles) {
+            const std::string path = m_filePath;
+            m_tiffReadHandles = std::make_shared<FileHandlePool<TIFF*>>(
+                [path]() {
+                    TIFF* tiff = TIFFOpen(path.c_str(), "rm");
+                    if(tiff == nullptr)
+                        throw Exception("Unable to open TIFF file " + path + " for reading");
+                    return tiff;
+                },
+                [](TIFF* tiff) { TIFFClose(tiff); },
+                m_maximumNumberOfReadHandles
+            );
+        } else if(!m_vsiTiles.empty() && !m_vsiReadHandles) {
+            const std::string path = m_filePath;
+            m_vsiReadHandles = std::make_shared<FileHandlePool<std::ifstream*>>(
+                [path]() {
+                    auto stream = new std::ifstream(path, std::ios::in | std::ios::binary);
+                    if(!stream->is_open()) {
+                        delete stream;
+                        throw Exception("Unable to open file " + path + " for reading");
+                    }
+                    return stream;
+                },
+                [](std::ifstream* stream) { delete stream; },
+                m_maximumNumberOfReadHandles
+            );
+        }
+        access->setReadHandlePools(m_tiffReadHandles, m_vsiReadHandles);
+    }
+    return access;
 }
 
-void ImagePyramid::setDirtyPatch(int level, int patchIdX, int patchIdY) {
-	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	const std::string tileString =
-		std::to_string(level) + "_" + std::to_string(patchIdX) + "_" + std::to_string(patchIdY);
-	m_dirtyPatches.insert(tileString);
+void ImagePyramid::setFilePath(std::string path) {
+    m_filePath = path;
+}
+
+std::string ImagePyramid::getFilePath() const {
+    return m_filePath;
+}
+
+void ImagePyramid::setMaximumNumberOfReadHandles(int handles) {
+    if(handles <= 0)
+        throw Exception("Maximum number of read handles in ImagePyramid must be larger than 0");
+    std::lock_guard<std::mutex> lock(m_readHandlesMutex);
+    m_maximumNumberOfReadHandles = handles;
+    // Existing accesses keep their pools alive until they are released
+    m_tiffReadHandles.reset();
+    m_vsiReadHandles.reset();
+}
+
+int ImagePyramid::getMaximumNumberOfReadHandles() const {
+    return m_maximumNumberOfReadHandles;
+}
+
+void ImagePyramid::setDeferredLevelBuilding(bool deferred) {
+    m_deferredLevelBuilding = deferred;
 }
 
-std::unordered_set<std::string> ImagePyramid::getDirtyPatches() {
+bool ImagePyramid::getDeferredLevelBuilding() const {
+    return m_deferredLevelBuilding;
+}
+
+uint64_t ImagePyramid::generateTileCacheID() {
+    static std::atomic<uint64_t> counter = {0};
+    return ++counter;
+}
+
+uint64_t ImagePyramid::getTileCacheID() const {
+    return m_tileCacheID;
+}
+
+bool ImagePyramid::getDirtyPatchBit(TileID tile, std::size_t& word, uint64_t& bit) {
+    const int level = tile.getLevel();
+    if(level >= m_levels.size() || tile.getTileX() >= m_levels[level].tilesX || tile.getTileY() >= m_levels[level].tilesY)
+        return false;
+    const std::size_t index = (std::size_t)tile.getTileY()*m_levels[level].tilesX + tile.getTileX();
+    word = index / 64;
+    bit = (uint64_t)1 << (index % 64);
+    return true;
+}
+
+void ImagePyramid::setDirtyPatch(int level, int patchIdX, int patchIdY) {
+	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
+	std::size_t word;
+	uint64_t bit;
+	if(!getDirtyPatchBit(TileID(level, patchIdX, patchIdY), word, bit))
+		return;
+	if(m_dirtyPatches.size() != m_levels.size())
+		m_dirtyPatches.resize(m_levels.size());
+	auto& bits = m_dirtyPatches[level];
+	if(bits.empty())
+		bits.resize(((std::size_t)m_levels[level].tilesX*m_levels[level].tilesY + 63) / 64, 0);
+	if((bits[word] & bit) == 0) {
+		bits[word] |= bit;
+		m_dirtyPatchCount++;
+	}
+}
+
+std::vector<TileID> ImagePyramid::getDirtyPatches() {
 	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	return m_dirtyPatches;
+	std::vector<TileID> patches;
+	patches.reserve(m_dirtyPatchCount);
+	for(int level = 0; level < m_dirtyPatches.size() && patches.size() < m_dirtyPatchCount; ++level) {
+		const auto& bits = m_dirtyPatches[level];
+		for(std::size_t word = 0; word < bits.size(); ++word) {
+			// Only visit set bits
+			uint64_t remaining = bits[word];
+			while(remaining != 0) {
+				int bit = 0;
+				while(((remaining >> bit) & 1) == 0)
+					++bit;
+				remaining &= remaining - 1;
+				const std::size_t index = word*64 + bit;
+				patches.push_back(TileID(level, index % m_levels[level].tilesX, index / m_levels[level].tilesX));
+			}
+		}
+	}
+	return patches;
 }
 
-bool ImagePyramid::isDirtyPatch(const std::string& tileID) {
+bool ImagePyramid::isDirtyPatch(TileID tile) {
 	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	return m_dirtyPatches.count(tileID);
+	std::size_t word;
+	uint64_t bit;
+	if(m_dirtyPatchCount == 0 || tile.getLevel() >= m_dirtyPatches.size() || m_dirtyPatches[tile.getLevel()].empty())
+		return false;
+	if(!getDirtyPatchBit(tile, word, bit))
+		return false;
+	return (m_dirtyPatches[tile.getLevel()][word] & bit) != 0;
 }
 
-void ImagePyramid::clearDirtyPatches(std::set<std::string> patches) {
+void ImagePyramid::clearDirtyPatches(const std::vector<TileID>& patches) {
 	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	for(auto&& patch : patches)
-		m_dirtyPatches.erase(patch);
+	for(auto&& patch : patches) {
+		std::size_t word;
+		uint64_t bit;
+		if(patch.getLevel() >= m_dirtyPatches.size() || m_dirtyPatches[patch.getLevel()].empty())
+			continue;
+		if(!getDirtyPatchBit(patch, word, bit))
+			continue;
+		auto& bits = m_dirtyPatches[patch.getLevel()];
+		if(bits[word] & bit) {
+			bits[word] &= ~bit;
+			m_dirtyPatchCount--;
+		}
+	}
 }
 
 void ImagePyramid::setSpacing(Vector3f spacing) {
@@ -388,6 +524,8 @@ bool ImagePyramid::usesTIFF() const {
 }
 
 std::string ImagePyramid::getTIFFPath() const {
+    if(m_tiffPath.empty() && usesTIFF())
+        return m_filePath;
     return m_tiffPath;
 }
 
@@ -4,6 +4,7 @@
 #include <FAST/Data/Access/Access.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
 #include <set>
+#include <thread>
 
 
 namespace fast {
@@ -21,6 +22,7 @@ class Image;
  */
 class FAST_EXPORT ImagePyramid : public SpatialDataObject {
     FAST_DATA_OBJECT(ImagePyramid)
+    friend class ImagePyramidAccess;
     public:
         FAST_CONSTRUCTOR(ImagePyramid, int, width,, int, height,, int, channels,, int, patchWidth, = 256, int, patchHeight, = 256);
         FAST_CONSTRUCTOR(ImagePyramid, openslide_t*, fileHandle,, std::vector<ImagePyramidLevel>, levels,);
@@ -53,14 +55,52 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         bool isPyramidFullyInitialized() const;
         bool usesOpenSlide() const;
         std::string getTIFFPath() const;
+        /**
+         * @brief Set path of the file this image pyramid was imported from
+         *
+         * The path is used to open additional read-only file handles, which enables multiple threads to
+         * read tiles from TIFF and VSI files in parallel. Set by the importers.
+         * @param path
+         */
+        void setFilePath(std::string path);
+        std::string getFilePath() const;
+        /**
+         * @brief Set maximum number of file handles used to read tiles in parallel
+         *
+         * Only used for TIFF and VSI image pyramids which have a file path set, see setFilePath.
+         * Setting this to 1 disables parallel reading, all threads will then share a single file handle.
+         * Default is the number of hardware threads.
+         * @param handles
+         */
+        void setMaximumNumberOfReadHandles(int handles);
+        int getMaximumNumberOfReadHandles() const;
+        /**
+         * @brief Defer building of the coarser levels when writing patches
+         *
+         * By default, ImagePyramidAccess::setPatch on level 0 updates the corresponding tile on every coarser level
+         * immediately. When deferred level building is enabled, only the level 0 tile is written, and the coarser
+         * levels are built in bulk when ImagePyramidAccess::buildPyramidLevels is called.
+         * This is much faster when writing many patches, e.g. with PatchStitcher.
+         * Only used for TIFF image pyramids. Default is false.
+         * @param deferred
+         */
+        void setDeferredLevelBuilding(bool deferred);
+        bool getDeferredLevelBuilding() const;
+        /**
+         * @brief Unique ID of this image pyramid in the ImagePyramidTileCache
+         */
+        uint64_t getTileCacheID() const;
         void setSpacing(Vector3f spacing);
         Vector3f getSpacing() const;
         ImagePyramidAccess::pointer getAccess(accessType type);
-        std::unordered_set<std::string> getDirtyPatches();
-        bool isDirtyPatch(const std::string& tileID);
+        /**
+         * @brief Get all tiles which have been modified and not yet cleared with clearDirtyPatches
+         */
+        std::vector<TileID> getDirtyPatches();
+        bool isDirtyPatch(TileID tile);
         bool isOMETIFF() const;
         void setDirtyPatch(int level, int patchIdX, int patchIdY);
-        void clearDirtyPatches(std::set<std::string> patches);
+        void clearDirtyPatches(const std::vector<TileID>& patches);
         void free(ExecutionDevice::pointer device) override;
         void freeAll() override;
         ~ImagePyramid();
@@ -85,11 +125,16 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
          */
         bool m_pyramidFullyInitialized;
 
-        std::unordered_set<std::string> m_dirtyPatches;
+        // Dirty tiles as one bitset per level, allocated when first tile of a level is set dirty.
+        // Protected by m_dirtyPatchMutex.
+        std::vector<std::vector<uint64_t>> m_dirtyPatches;
+        std::size_t m_dirtyPatchCount = 0;
         static int m_counter;
         std::mutex m_dirtyPatchMutex;
+        // Get position of a tile in the dirty bitset of its level, returns false if tile is outside the pyramid
+        bool getDirtyPatchBit(TileID tile, std::size_t& word, uint64_t& bit);
         Vector3f m_spacing = Vector3f::Ones();
-        std::unordered_set<std::string> m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
+        std::unordered_set<TileID> m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
 
         // VSI stuff
         std::ifstream* m_vsiFileHandle;
@@ -98,6 +143,22 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
 
         // A mutex needed to control multi-threaded reading of VSI and TIFF files
         std::mutex m_readMutex;
+
+        // Pools of read-only file handles for reading tiles in parallel
+        std::string m_filePath;
+        int m_maximumNumberOfReadHandles = std::max(1, (int)std::thread::hardware_concurrency());
+        std::mutex m_readHandlesMutex;
+        std::shared_ptr<FileHandlePool<TIFF*>> m_tiffReadHandles;
+        std::shared_ptr<FileHandlePool<std::ifstream*>> m_vsiReadHandles;
+
+        // Level 0 tiles written since the coarser levels were last built, used for deferred level building
+        bool m_deferredLevelBuilding = false;
+        std::set<std::pair<int, int>> m_deferredTiles;
+        // Whether the current TIFF directory has tiles which are not yet written to file, protected by m_readMutex
+        bool m_tiffDirectoryModified = false;
+
+        static uint64_t generateTileCacheID();
+        uint64_t m_tileCacheID = generateTileCacheID();
 };
 
 }
@@ -0,0 +1,97 @@
+#include "ImagePyramidTileCache.hpp"
+
+namespace fast {
+
+ImagePyramidTileCache* ImagePyramidTileCache::getInstance() {
+    // Never deleted, since image pyramids may be destroyed after static objects at program exit
+    static ImagePyramidTileCache* instance = new ImagePyramidTileCache();
+    return instance;
+}
+
+std::shared_ptr<uchar[]> ImagePyramidTileCache::get(const TileKey& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_lookup.find(key);
+    if(it == m_lookup.end()) {
+        m_statistics.misses += 1;
+        return nullptr;
+    }
+    m_statistics.hits += 1;
+    // Move to front, as it is now the most recently used
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->data;
+}
+
+void ImagePyramidTileCache::put(const TileKey& key, std::shared_ptr<uchar[]> data, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(bytes > m_maximumBytes)
+        return;
+    auto it = m_lookup.find(key);
+    if(it != m_lookup.end()) {
+        // Another thread may have read the same tile simultaneously
+        m_statistics.bytes -= it->second->bytes;
+        m_entries.erase(it->second);
+        m_lookup.erase(it);
+    }
+    m_entries.push_front({key, std::move(data), bytes});
+    m_lookup[key] = m_entries.begin();
+    m_statistics.bytes += bytes;
+    evict();
+}
+
+void ImagePyramidTileCache::evict() {
+    while(m_statistics.bytes > m_maximumBytes && !m_entries.empty()) {
+        auto& entry = m_entries.back();
+        m_statistics.bytes -= entry.bytes;
+        m_statistics.evictions += 1;
+        m_lookup.erase(entry.key);
+        m_entries.pop_back();
+    }
+}
+
+void ImagePyramidTileCache::remove(uint64_t pyramidID) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto it = m_entries.begin(); it != m_entries.end();) {
+        if(it->key.pyramidID == pyramidID) {
+            m_statistics.bytes -= it->bytes;
+            m_lookup.erase(it->key);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ImagePyramidTileCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lookup.clear();
+    m_statistics.bytes = 0;
+}
+
+void ImagePyramidTileCache::setMaximumSize(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumBytes = bytes;
+    evict();
+}
+
+std::size_t ImagePyramidTileCache::getMaximumSize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumBytes;
+}
+
+ImagePyramidTileCache::Statistics ImagePyramidTileCache::getStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Statistics statistics = m_statistics;
+    statistics.tiles = m_entries.size();
+    statistics.maximumBytes = m_maximumBytes;
+    return statistics;
+}
+
+void ImagePyramidTileCache::resetStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.hits = 0;
+    m_statistics.misses = 0;
+    m_statistics.evictions = 0;
+}
+
+}
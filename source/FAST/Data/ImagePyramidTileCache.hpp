@@ -0,0 +1,95 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+namespace fast {
+
+/**
+ * @brief Process-wide cache of decoded image pyramid tiles
+ *
+ * Reading and decoding (e.g. JPEG) a tile from a whole slide image is expensive, and neighbouring patches
+ * from PatchGenerator and ImagePyramidRenderer often need the same tiles.
+ * ImagePyramidAccess therefore stores decoded tiles from read-only TIFF and VSI image pyramids in this cache,
+ * which is shared by all threads and process objects.
+ * When the total size of the cached tiles exceeds the maximum size, the least recently used tiles are evicted.
+ *
+ * @ingroup wsi
+ */
+class FAST_EXPORT ImagePyramidTileCache : public Object {
+    public:
+        struct TileKey {
+            uint64_t pyramidID;
+            int level;
+            int tileX;
+            int tileY;
+            bool operator==(const TileKey& other) const {
+                return pyramidID == other.pyramidID && level == other.level && tileX == other.tileX && tileY == other.tileY;
+            }
+        };
+        struct Statistics {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            std::size_t tiles = 0;
+            std::size_t bytes = 0;
+            std::size_t maximumBytes = 0;
+        };
+        static ImagePyramidTileCache* getInstance();
+        /**
+         * @brief Get a tile from the cache
+         * @return tile data, or nullptr if tile is not in the cache
+         */
+        std::shared_ptr<uchar[]> get(const TileKey& key);
+        /**
+         * @brief Add a tile to the cache, evicting the least recently used tiles if needed.
+         * @param key
+         * @param data decoded tile data
+         * @param bytes size of tile data in bytes
+         */
+        void put(const TileKey& key, std::shared_ptr<uchar[]> data, std::size_t bytes);
+        /**
+         * @brief Remove all tiles of a given image pyramid
+         * @param pyramidID
+         */
+        void remove(uint64_t pyramidID);
+        void clear();
+        /**
+         * @brief Set maximum total size of cached tiles in bytes. Setting this to 0 disables the cache.
+         * Default is 512 MB.
+         * @param bytes
+         */
+        void setMaximumSize(std::size_t bytes);
+        std::size_t getMaximumSize();
+        Statistics getStatistics();
+        void resetStatistics();
+        std::string getNameOfClass() const { return "ImagePyramidTileCache"; };
+    private:
+        ImagePyramidTileCache() = default;
+        void evict();
+        struct TileKeyHash {
+            std::size_t operator()(const TileKey& key) const {
+                std::size_t hash = std::hash<uint64_t>()(key.pyramidID);
+                hash = hash*31 + std::hash<int>()(key.level);
+                hash = hash*31 + std::hash<int>()(key.tileX);
+                hash = hash*31 + std::hash<int>()(key.tileY);
+                return hash;
+            }
+        };
+        struct Entry {
+            TileKey key;
+            std::shared_ptr<uchar[]> data;
+            std::size_t bytes;
+        };
+        // Most recently used tiles first
+        std::list<Entry> m_entries;
+        std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash> m_lookup;
+        std::size_t m_maximumBytes = 512*1024*1024;
+        Statistics m_statistics;
+        std::mutex m_mutex;
+};
+
+}
@@ -1,10 +1,11 @@
 #include "Tensor.hpp"
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Access/OpenCLBufferAccess.hpp>
+#include <cstring>
 
 namespace fast {
 
-void Tensor::init(std::unique_ptr<float[]> data, TensorShape shape) {
+void Tensor::init(std::shared_ptr<float[]> data, TensorShape shape) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
@@ -24,6 +25,12 @@ Tensor::Tensor(std::unique_ptr<float[]> data, TensorShape shape) {
     init(std::move(data), shape);
 }
 
+Tensor::Tensor(std::shared_ptr<float[]> data, TensorShape shape) {
+    if(!data)
+        throw Exception("Data given to Tensor was null");
+    init(std::move(data), shape);
+}
+
 Tensor::Tensor(const float* const data, TensorShape shape) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
@@ -265,6 +272,38 @@ void Tensor::deleteDimension(int i) {
     }
 }
 
+Tensor::pointer Tensor::getSubTensor(int index) {
+    if(m_shape.getDimensions() < 2)
+        throw Exception("Tensor must have at least 2 dimensions to get a sub tensor");
+    if(index < 0 || index >= m_shape[0])
+        throw Exception("Index " + std::to_string(index) + " out of bounds in getSubTensor");
+    TensorShape shape;
+    for(int i = 1; i < m_shape.getDimensions(); ++i)
+        shape.addDimension(m_shape[i]);
+    const std::size_t offset = (std::size_t)index*shape.getTotalSize();
+
+    // Make sure data on host is up to date
+    auto access = getAccess(ACCESS_READ);
+    if(access->getRawData() != m_data.get()) {
+        // Data is not stored in m_data (e.g. TensorFlowTensor), have to copy
+        return Tensor::create(access->getRawData() + offset, shape);
+    }
+    // Share ownership of the data, but point to the given index
+    return Tensor::create(std::shared_ptr<float[]>(m_data, m_data.get() + offset), shape);
+}
+
+std::shared_ptr<float[]> Tensor::getSharedHostData() {
+    auto access = getAccess(ACCESS_READ);
+    if(access->getRawData() != m_data.get()) {
+        // Data is not stored in m_data (e.g. TensorFlowTensor), have to copy
+        const std::size_t size = m_shape.getTotalSize();
+        std::shared_ptr<float[]> data = make_uninitialized_unique<float[]>(size);
+        std::memcpy(data.get(), access->getRawData(), size*sizeof(float));
+        return data;
+    }
+    return m_data;
+}
+
 DataBoundingBox Tensor::getTransformedBoundingBox() const {
     auto T = SceneGraph::getEigenTransformFromNode(getSceneGraphNode());
 
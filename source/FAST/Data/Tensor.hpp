@@ -29,6 +29,13 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
          * @param shape
          */
         FAST_CONSTRUCTOR(Tensor, std::unique_ptr<float[]>, data,, TensorShape, shape,)
+        /**
+         * Create a tensor which shares the provided data without copying it.
+         * The data is kept alive as long as the tensor exists.
+         * @param data
+         * @param shape
+         */
+        FAST_CONSTRUCTOR(Tensor, std::shared_ptr<float[]>, data,, TensorShape, shape,)
         /**
          * Create a 1D tensor with the provided data. Its shape will be equal to its length
          * @param data
@@ -59,13 +66,31 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         virtual void setSpacing(VectorXf spacing);
         virtual VectorXf getSpacing() const;
         virtual void deleteDimension(int dimension);
+        /**
+         * @brief Get the tensor at the given index of the first dimension, e.g. one sample of a batch.
+         *
+         * The returned tensor is a view which shares the data of this tensor, thus no data is copied,
+         * and modifying the data of the returned tensor will modify the data of this tensor.
+         * @param index
+         * @return tensor with the first dimension removed
+         */
+        virtual Tensor::pointer getSubTensor(int index);
+#ifndef SWIG
+        /**
+         * @brief Get up to date host data, shared with this tensor
+         *
+         * The returned pointer keeps the data valid even if the tensor is deleted.
+         * This is used to give other libraries, e.g. numpy, access to the data without copying it.
+         */
+        virtual std::shared_ptr<float[]> getSharedHostData();
+#endif
 
         virtual DataBoundingBox getTransformedBoundingBox() const override;
         virtual DataBoundingBox getBoundingBox() const override;
 		virtual ~Tensor();
 
     protected:
-        void init(std::unique_ptr<float[]> data, TensorShape shape);
+        void init(std::shared_ptr<float[]> data, TensorShape shape);
         Tensor() = default;
         virtual bool isInitialized();
         virtual void transferCLBufferFromHost(OpenCLDevice::pointer device);
@@ -76,7 +101,8 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         void updateHostData();
         virtual float* getHostDataPointer();
 
-        std::unique_ptr<float[]> m_data;
+        // Shared, as the data may be owned by other tensors or an inference engine as well (see getSubTensor)
+        std::shared_ptr<float[]> m_data;
         std::unordered_map<std::shared_ptr<OpenCLDevice>, cl::Buffer*> mCLBuffers;
         std::unordered_map<std::shared_ptr<OpenCLDevice>, bool> mCLBuffersIsUpToDate;
         TensorShape m_shape;
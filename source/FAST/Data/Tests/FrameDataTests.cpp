@@ -0,0 +1,76 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/FrameData.hpp"
+#include "FAST/Data/Image.hpp"
+
+namespace fast {
+
+TEST_CASE("Typed frame data can be read as strings and strings as typed values", "[fast][FrameData]") {
+    FrameData frameData;
+    frameData.set("patchid-x", 3);
+    frameData.set("patch-spacing-x", 0.25f);
+    frameData.set("patch-width", std::string("512"));
+    CHECK(frameData.size() == 3);
+    CHECK(frameData.getInt("patchid-x") == 3);
+    CHECK(frameData.getString("patchid-x") == "3");
+    CHECK(frameData.getFloat("patch-spacing-x") == 0.25f);
+    CHECK(std::stof(frameData.getString("patch-spacing-x")) == 0.25f);
+    CHECK(frameData.getInt("patch-width") == 512);
+    CHECK(frameData.getFloat("patch-width") == 512.0f);
+    CHECK(frameData.getKey("patchid-x") == FrameData::getKey("patchid-x"));
+    CHECK(FrameData::getKeyName(FrameData::getKey("patchid-x")) == "patchid-x");
+    CHECK_FALSE(frameData.has("this-frame-data-does-not-exist"));
+    CHECK_THROWS(frameData.getInt("this-frame-data-does-not-exist"));
+
+    frameData.remove("patch-width");
+    CHECK_FALSE(frameData.has("patch-width"));
+    CHECK(frameData.size() == 2);
+}
+
+TEST_CASE("Frame data matrix survives string round trip", "[fast][FrameData]") {
+    Matrix4f matrix;
+    for(int i = 0; i < 16; ++i)
+        matrix.data()[i] = (float)i / 3.0f;
+    FrameData frameData;
+    frameData.set("original-transform", matrix);
+    FrameData fromString;
+    fromString.set("original-transform", frameData.getString("original-transform"));
+    CHECK(fromString.getMatrix("original-transform") == matrix);
+    CHECK_THROWS(frameData.getInt("original-transform"));
+}
+
+TEST_CASE("Frame data is shared until modified", "[fast][FrameData]") {
+    FrameData input;
+    input.set("patchid-x", 1);
+    input.set("patchid-y", 2);
+
+    FrameData output;
+    output.merge(input);
+    FrameData copy = output;
+    copy.set("patchid-x", 10);
+    CHECK(input.getInt("patchid-x") == 1);
+    CHECK(output.getInt("patchid-x") == 1);
+    CHECK(copy.getInt("patchid-x") == 10);
+
+    FrameData other;
+    other.set("progress", 0.5f);
+    output.merge(other);
+    CHECK(output.size() == 3);
+    CHECK(input.size() == 2);
+    CHECK(output.getFloat("progress") == 0.5f);
+}
+
+TEST_CASE("Typed frame data on data objects", "[fast][FrameData]") {
+    auto image = Image::create(8, 8, TYPE_UINT8, 1);
+    image->setFrameData("patchid-x", 4);
+    image->setFrameData("isPolar", "true");
+    CHECK(image->getFrameData<int>("patchid-x") == 4);
+    CHECK(image->getFrameData("patchid-x") == "4");
+    CHECK(image->getFrameData("isPolar") == "true");
+    CHECK(image->getFrameData().size() == 2);
+
+    auto image2 = Image::create(8, 8, TYPE_UINT8, 1);
+    image2->setFrameDataContainer(image->getFrameDataContainer());
+    CHECK(image2->getFrameData<int>("patchid-x") == 4);
+}
+
+}
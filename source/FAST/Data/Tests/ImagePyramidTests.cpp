@@ -0,0 +1,266 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Data/ImagePyramid.hpp>
+#include <FAST/Data/Image.hpp>
+#include <FAST/Data/ImagePyramidTileCache.hpp>
+#include <FAST/Exporters/TIFFImagePyramidExporter.hpp>
+#include <FAST/Importers/TIFFImagePyramidImporter.hpp>
+#include <tiffio.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+using namespace fast;
+
+static ImagePyramid::pointer createTIFFImagePyramid(std::string filename, int size) {
+    auto data = std::make_unique<uchar[]>(size*size*3);
+    for(int i = 0; i < size*size*3; ++i)
+        data[i] = (uchar)(i % 251);
+    auto image = Image::create(size, size, TYPE_UINT8, 3, data.get());
+    auto exporter = TIFFImagePyramidExporter::create(filename);
+    exporter->setInputData(image);
+    exporter->run();
+
+    auto importer = TIFFImagePyramidImporter::create(filename);
+    return importer->runAndGetOutputData<ImagePyramid>();
+}
+
+// Read all tiles of level 0 using the given number of threads, returns number of patches read per second
+static double readAllTiles(ImagePyramid::pointer pyramid, int threads, std::vector<std::unique_ptr<uchar[]>>& result) {
+    const int tilesX = pyramid->getLevelTilesX(0);
+    const int tilesY = pyramid->getLevelTilesY(0);
+    const int tileWidth = pyramid->getLevelTileWidth(0);
+    const int tileHeight = pyramid->getLevelTileHeight(0);
+    result.clear();
+    result.resize(tilesX*tilesY);
+    std::atomic_int nextTile = {0};
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            // Each thread has its own access object, as in a multi-threaded pipeline
+            auto access = pyramid->getAccess(ACCESS_READ);
+            for(int tile = nextTile++; tile < tilesX*tilesY; tile = nextTile++) {
+                const int x = (tile % tilesX)*tileWidth;
+                const int y = (tile / tilesX)*tileHeight;
+                result[tile] = access->getPatchData(0, x, y, tileWidth, tileHeight);
+            }
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+    return tilesX*tilesY / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+TEST_CASE("Read TIFF image pyramid tiles in parallel", "[fast][ImagePyramid][wsi]") {
+    auto pyramid = createTIFFImagePyramid("image-pyramid-parallel-read-test.tiff", 2048);
+    CHECK(pyramid->getFilePath() == "image-pyramid-parallel-read-test.tiff");
+    CHECK(pyramid->getTIFFPath() == "image-pyramid-parallel-read-test.tiff");
+    const int size = pyramid->getLevelTileWidth(0)*pyramid->getLevelTileHeight(0)*3;
+    // Disable tile cache to make sure all tiles are read from file
+    auto cache = ImagePyramidTileCache::getInstance();
+    const auto cacheSize = cache->getMaximumSize();
+    cache->setMaximumSize(0);
+
+    std::vector<std::unique_ptr<uchar[]>> sequential;
+    pyramid->setMaximumNumberOfReadHandles(1);
+    readAllTiles(pyramid, 1, sequential);
+
+    std::vector<std::unique_ptr<uchar[]>> parallel;
+    pyramid->setMaximumNumberOfReadHandles(4);
+    readAllTiles(pyramid, 8, parallel);
+
+    REQUIRE(sequential.size() == parallel.size());
+    for(int tile = 0; tile < sequential.size(); ++tile)
+        CHECK(std::memcmp(sequential[tile].get(), parallel[tile].get(), size) == 0);
+    cache->setMaximumSize(cacheSize);
+}
+
+// Write a 2 level OME-TIFF, where level 1 is stored as a SubIFD of level 0. Each level is filled with its own value.
+static void writeOMETIFF(std::string filename, int size, uchar level0Value, uchar level1Value) {
+    TIFF* tiff = TIFFOpen(filename.c_str(), "w8");
+    const int tileSize = 256;
+    for(int level = 0; level < 2; ++level) {
+        const int levelSize = size >> level;
+        if(level == 0) {
+            uint64_t subIFDOffsets[1] = {0}; // Filled in by libtiff when the next directory is written
+            TIFFSetField(tiff, TIFFTAG_SUBIFD, 1, subIFDOffsets);
+            TIFFSetField(tiff, TIFFTAG_IMAGEDESCRIPTION, "<?xml version=\"1.0\"?><OME></OME>");
+        } else {
+            TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+        }
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, levelSize);
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, levelSize);
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, tileSize);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, tileSize);
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+        std::vector<uchar> tile(tileSize*tileSize*3, level == 0 ? level0Value : level1Value);
+        for(int y = 0; y < levelSize; y += tileSize) {
+            for(int x = 0; x < levelSize; x += tileSize)
+                TIFFWriteTile(tiff, tile.data(), x, y, 0, 0);
+        }
+        TIFFWriteDirectory(tiff);
+    }
+    TIFFClose(tiff);
+}
+
+TEST_CASE("Read OME-TIFF level 0 after level 1 with the same read handle", "[fast][ImagePyramid][wsi]") {
+    writeOMETIFF("image-pyramid-ome-test.ome.tiff", 1024, 10, 200);
+    auto pyramid = TIFFImagePyramidImporter::create("image-pyramid-ome-test.ome.tiff")->runAndGetOutputData<ImagePyramid>();
+    REQUIRE(pyramid->getNrOfLevels() == 2);
+    auto cache = ImagePyramidTileCache::getInstance();
+    const auto cacheSize = cache->getMaximumSize();
+    cache->setMaximumSize(0);
+    pyramid->setMaximumNumberOfReadHandles(1);
+    {
+        auto access = pyramid->getAccess(ACCESS_READ);
+        for(int level : {1, 0, 1, 0}) {
+            INFO("Level " << level);
+            auto data = access->getPatchData(level, 0, 0, 256, 256);
+            CHECK(data[0] == (level == 0 ? 10 : 200));
+            CHECK(data[256*256*3 - 1] == (level == 0 ? 10 : 200));
+        }
+    }
+    cache->setMaximumSize(cacheSize);
+}
+
+TEST_CASE("Parallel TIFF image pyramid tile reading benchmark", "[fast][ImagePyramid][wsi][benchmark][visual]") {
+    auto pyramid = createTIFFImagePyramid("image-pyramid-parallel-read-benchmark.tiff", 8192);
+    auto cache = ImagePyramidTileCache::getInstance();
+    const auto cacheSize = cache->getMaximumSize();
+    cache->setMaximumSize(0);
+    std::vector<std::unique_ptr<uchar[]>> result;
+    const int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        pyramid->setMaximumNumberOfReadHandles(1);
+        const double mutexThroughput = readAllTiles(pyramid, threads, result);
+        pyramid->setMaximumNumberOfReadHandles(threads);
+        const double poolThroughput = readAllTiles(pyramid, threads, result);
+        std::cout << threads << " threads: " << (int)mutexThroughput << " patches/s with single handle, "
+            << (int)poolThroughput << " patches/s with " << threads << " handles" << std::endl;
+    }
+    cache->setMaximumSize(cacheSize);
+}
+
+TEST_CASE("Image pyramid tile cache evicts least recently used tiles", "[fast][ImagePyramidTileCache]") {
+    auto cache = ImagePyramidTileCache::getInstance();
+    const auto previousMaximumSize = cache->getMaximumSize();
+    cache->clear();
+    cache->resetStatistics();
+    cache->setMaximumSize(300);
+
+    const uint64_t pyramid = std::numeric_limits<uint64_t>::max();
+    cache->put({pyramid, 0, 0, 0}, std::shared_ptr<uchar[]>(new uchar[100]), 100);
+    cache->put({pyramid, 0, 1, 0}, std::shared_ptr<uchar[]>(new uchar[100]), 100);
+    cache->put({pyramid, 0, 2, 0}, std::shared_ptr<uchar[]>(new uchar[100]), 100);
+    // Use first tile, so that second tile is the least recently used
+    CHECK(cache->get({pyramid, 0, 0, 0}) != nullptr);
+    cache->put({pyramid, 1, 0, 0}, std::shared_ptr<uchar[]>(new uchar[100]), 100);
+    CHECK(cache->get({pyramid, 0, 1, 0}) == nullptr);
+    CHECK(cache->get({pyramid, 0, 0, 0}) != nullptr);
+    CHECK(cache->get({pyramid, 1, 0, 0}) != nullptr);
+
+    auto statistics = cache->getStatistics();
+    CHECK(statistics.hits == 3);
+    CHECK(statistics.misses == 1);
+    CHECK(statistics.evictions == 1);
+    CHECK(statistics.tiles == 3);
+    CHECK(statistics.bytes == 300);
+
+    cache->remove(pyramid);
+    CHECK(cache->getStatistics().tiles == 0);
+    CHECK(cache->getStatistics().bytes == 0);
+    cache->setMaximumSize(previousMaximumSize);
+}
+
+TEST_CASE("Overlapping patches reuse cached tiles", "[fast][ImagePyramidTileCache][wsi]") {
+    auto pyramid = createTIFFImagePyramid("image-pyramid-tile-cache-test.tiff", 1024);
+    auto cache = ImagePyramidTileCache::getInstance();
+    const auto cacheSize = cache->getMaximumSize();
+    cache->clear();
+    cache->resetStatistics();
+    const int tileWidth = pyramid->getLevelTileWidth(0);
+    const int tileHeight = pyramid->getLevelTileHeight(0);
+
+    auto access = pyramid->getAccess(ACCESS_READ);
+    // Patch spanning 4 tiles
+    auto patch1 = access->getPatchData(0, tileWidth/2, tileHeight/2, tileWidth, tileHeight);
+    CHECK(cache->getStatistics().misses == 4);
+    CHECK(cache->getStatistics().hits == 0);
+    // Overlapping patch
+    auto patch2 = access->getPatchData(0, tileWidth/2, tileHeight/2, tileWidth, tileHeight);
+    CHECK(cache->getStatistics().misses == 4);
+    CHECK(cache->getStatistics().hits == 4);
+    CHECK(std::memcmp(patch1.get(), patch2.get(), tileWidth*tileHeight*3) == 0);
+
+    // Cached data is the same as data read without the cache
+    cache->setMaximumSize(0);
+    auto patch3 = access->getPatchData(0, tileWidth/2, tileHeight/2, tileWidth, tileHeight);
+    CHECK(std::memcmp(patch1.get(), patch3.get(), tileWidth*tileHeight*3) == 0);
+    cache->setMaximumSize(cacheSize);
+}
+
+TEST_CASE("Deferred pyramid level building gives same result as immediate", "[fast][ImagePyramid][wsi]") {
+    const int size = 16384;
+    const int tileSize = 256;
+    const int tiles = 12;
+    auto immediate = ImagePyramid::create(size, size, 1, tileSize, tileSize);
+    auto deferred = ImagePyramid::create(size, size, 1, tileSize, tileSize);
+    deferred->setDeferredLevelBuilding(true);
+    REQUIRE(immediate->getNrOfLevels() >= 3);
+
+    auto data = std::make_unique<uchar[]>(tileSize*tileSize);
+    for(int tileY = 0; tileY < tiles; ++tileY) {
+        for(int tileX = 0; tileX < tiles; ++tileX) {
+            for(int i = 0; i < tileSize*tileSize; ++i)
+                data[i] = (uchar)((i*7 + tileX*13 + tileY*31) % 256);
+            auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 1, data.get());
+            immediate->getAccess(ACCESS_READ_WRITE)->setPatch(0, tileX*tileSize, tileY*tileSize, patch);
+            deferred->getAccess(ACCESS_READ_WRITE)->setPatch(0, tileX*tileSize, tileY*tileSize, patch);
+        }
+    }
+    deferred->getAccess(ACCESS_READ_WRITE)->buildPyramidLevels();
+
+    auto immediateAccess = immediate->getAccess(ACCESS_READ);
+    auto deferredAccess = deferred->getAccess(ACCESS_READ);
+    for(int level = 0; level < immediate->getNrOfLevels(); ++level) {
+        const int levelTiles = std::max(1, tiles >> level);
+        for(int tileY = 0; tileY < levelTiles; ++tileY) {
+            for(int tileX = 0; tileX < levelTiles; ++tileX) {
+                CHECK(deferredAccess->isPatchInitialized(level, tileX*tileSize, tileY*tileSize));
+                auto expected = immediateAccess->getPatchData(level, tileX*tileSize, tileY*tileSize, tileSize, tileSize);
+                auto result = deferredAccess->getPatchData(level, tileX*tileSize, tileY*tileSize, tileSize, tileSize);
+                CHECK(std::memcmp(expected.get(), result.get(), tileSize*tileSize) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Image pyramid dirty tile tracking", "[fast][ImagePyramid][wsi]") {
+    auto pyramid = ImagePyramid::create(4096, 4096, 1, 256, 256);
+    CHECK(pyramid->getDirtyPatches().empty());
+    pyramid->setDirtyPatch(0, 3, 5);
+    pyramid->setDirtyPatch(0, 3, 5);
+    pyramid->setDirtyPatch(1, 7, 0);
+    // Tiles outside the pyramid are ignored
+    pyramid->setDirtyPatch(0, 100, 0);
+
+    auto dirty = pyramid->getDirtyPatches();
+    REQUIRE(dirty.size() == 2);
+    CHECK(dirty[0] == TileID(0, 3, 5));
+    CHECK(dirty[1] == TileID(1, 7, 0));
+    CHECK(dirty[1].getLevel() == 1);
+    CHECK(dirty[1].getTileX() == 7);
+    CHECK(dirty[1].getTileY() == 0);
+    CHECK(pyramid->isDirtyPatch(TileID(0, 3, 5)));
+    CHECK_FALSE(pyramid->isDirtyPatch(TileID(0, 5, 3)));
+
+    pyramid->clearDirtyPatches({TileID(0, 3, 5)});
+    CHECK_FALSE(pyramid->isDirtyPatch(TileID(0, 3, 5)));
+    CHECK(pyramid->getDirtyPatches().size() == 1);
+}
@@ -0,0 +1,28 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Data/Tensor.hpp>
+
+using namespace fast;
+
+TEST_CASE("Sub tensor shares data with tensor", "[fast][Tensor]") {
+    auto data = make_uninitialized_unique<float[]>(3*2*4);
+    for(int i = 0; i < 3*2*4; ++i)
+        data[i] = i;
+    auto tensor = Tensor::create(std::move(data), TensorShape({3, 2, 4}));
+
+    auto subTensor = tensor->getSubTensor(1);
+    CHECK(subTensor->getShape() == TensorShape({2, 4}));
+    {
+        auto access = tensor->getAccess(ACCESS_READ);
+        auto subAccess = subTensor->getAccess(ACCESS_READ);
+        CHECK(subAccess->getRawData() == access->getRawData() + 2*4);
+        for(int i = 0; i < 2*4; ++i)
+            CHECK(subAccess->getRawData()[i] == 2*4 + i);
+    }
+
+    // Data is kept alive by the sub tensor
+    tensor.reset();
+    auto access = subTensor->getAccess(ACCESS_READ);
+    CHECK(access->getRawData()[0] == 2*4);
+
+    CHECK_THROWS(subTensor->getSubTensor(2));
+}
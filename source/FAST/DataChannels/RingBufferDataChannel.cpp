@@ -0,0 +1,154 @@
+#include "RingBufferDataChannel.hpp"
+#include <thread>
+
+namespace fast {
+
+void RingBufferDataChannel::addFrame(DataObject::pointer data) {
+    // Decrement semaphore by one, wait if buffer is full
+    m_emptyCount->wait();
+
+    // If stop is signaled, throw an exception to stop the entire computation thread
+    if(m_stopped.load(std::memory_order_acquire))
+        throw ThreadStopped(m_errorMessage);
+
+    // Claim a position in the buffer. The semaphore guarantees that there is room for it.
+    uint64_t position;
+    if(m_singleProducerSingleConsumer) {
+        position = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(position + 1, std::memory_order_relaxed);
+    } else {
+        position = m_tail.fetch_add(1, std::memory_order_relaxed);
+    }
+    Slot& slot = m_slots[position & (m_bufferSize - 1)];
+    // With multiple consumers, the consumer of the previous round may not have finished with this slot yet
+    while(slot.sequence.load(std::memory_order_acquire) != position)
+        std::this_thread::yield();
+    if(m_singleProducerSingleConsumer) {
+        slot.data = std::move(data);
+    } else {
+        // Another consumer may read this slot in getFrame at the same time
+        std::atomic_store(&slot.data, std::move(data));
+    }
+    slot.sequence.store(position + 1, std::memory_order_release);
+
+    // Increment semaphore by one, signal any waiting due to empty buffer
+    m_fillCount->signal();
+}
+
+DataObject::pointer RingBufferDataChannel::getNextDataFrame() {
+    // Decrement semaphore by one, and wait if buffer is empty
+    m_fillCount->wait();
+
+    // If stop is signaled, throw an exception to stop the entire computation thread
+    if(m_stopped.load(std::memory_order_acquire))
+        throw ThreadStopped(m_errorMessage);
+
+    uint64_t position;
+    if(m_singleProducerSingleConsumer) {
+        position = m_head.load(std::memory_order_relaxed);
+        m_head.store(position + 1, std::memory_order_relaxed);
+    } else {
+        position = m_head.fetch_add(1, std::memory_order_relaxed);
+    }
+    Slot& slot = m_slots[position & (m_bufferSize - 1)];
+    // With multiple producers, the producer of this position may not have finished writing yet
+    while(slot.sequence.load(std::memory_order_acquire) != position + 1)
+        std::this_thread::yield();
+    DataObject::pointer data;
+    if(m_singleProducerSingleConsumer) {
+        data = std::move(slot.data);
+        slot.data.reset();
+    } else {
+        // Another consumer may read this slot in getFrame at the same time
+        data = std::atomic_exchange(&slot.data, DataObject::pointer());
+    }
+    // Mark slot as free for the producer of the next round
+    slot.sequence.store(position + m_bufferSize, std::memory_order_release);
+
+    // Increment semaphore by one and signal any waiting for next frame due to full buffer
+    m_emptyCount->signal();
+
+    return data;
+}
+
+int RingBufferDataChannel::getSize() {
+    // Only count frames which are published, starting at the head. Positions which are claimed by a producer,
+    // but not yet written, can not be retrieved by getFrame and are thus not counted.
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    uint64_t size = 0;
+    while(size < m_bufferSize && m_slots[(head + size) & (m_bufferSize - 1)].sequence.load(std::memory_order_acquire) == head + size + 1)
+        ++size;
+    return (int)size;
+}
+
+void RingBufferDataChannel::setMaximumNumberOfFrames(uint frames) {
+    if(m_slots != nullptr && getSize() > 0)
+        throw Exception("Have to call setMaximumNumberOfFrames before executing pipeline");
+    if(frames == 0)
+        throw Exception("Maximum number of frames in RingBufferDataChannel must be larger than 0");
+    mMaximumNumberOfFrames = frames;
+    m_bufferSize = 1;
+    while(m_bufferSize < frames)
+        m_bufferSize *= 2;
+    delete[] m_slots;
+    m_slots = new Slot[m_bufferSize];
+    for(uint64_t i = 0; i < m_bufferSize; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    m_head.store(0);
+    m_tail.store(0);
+    m_fillCount = std::make_unique<LightweightSemaphore>(0);
+    m_emptyCount = std::make_unique<LightweightSemaphore>(mMaximumNumberOfFrames);
+}
+
+int RingBufferDataChannel::getMaximumNumberOfFrames() const {
+    return mMaximumNumberOfFrames;
+}
+
+void RingBufferDataChannel::stop(std::string errorMessage) {
+    DataChannel::stop(errorMessage);
+    m_stopped.store(true, std::memory_order_release);
+    Reporter::info() << "SIGNALING SEMAPHORES in RingBufferDataChannel" << Reporter::end();
+
+    // Since getNextFrame or addFrame might be waiting for data, we need to signal the semaphore to stop them blocking
+    m_fillCount->signal();
+    m_emptyCount->signal();
+}
+
+bool RingBufferDataChannel::hasCurrentData() {
+    const uint64_t position = m_head.load(std::memory_order_acquire);
+    return m_slots[position & (m_bufferSize - 1)].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+DataObject::pointer RingBufferDataChannel::getFrame() {
+    while(true) {
+        const uint64_t position = m_head.load(std::memory_order_acquire);
+        Slot& slot = m_slots[position & (m_bufferSize - 1)];
+        if(slot.sequence.load(std::memory_order_acquire) != position + 1)
+            throw Exception("No frames available in getFrame");
+        if(m_singleProducerSingleConsumer)
+            return slot.data;
+        // With multiple consumers, the frame may be taken, and the slot reused, while reading it.
+        // The data belongs to this position only if the sequence is unchanged after reading.
+        DataObject::pointer data = std::atomic_load(&slot.data);
+        if(data && slot.sequence.load() == position + 1)
+            return data;
+    }
+}
+
+void RingBufferDataChannel::setSingleProducerSingleConsumer(bool spsc) {
+    m_singleProducerSingleConsumer = spsc;
+}
+
+bool RingBufferDataChannel::getSingleProducerSingleConsumer() const {
+    return m_singleProducerSingleConsumer;
+}
+
+RingBufferDataChannel::RingBufferDataChannel() {
+    setMaximumNumberOfFrames(50);
+}
+
+RingBufferDataChannel::~RingBufferDataChannel() {
+    delete[] m_slots;
+}
+
+}
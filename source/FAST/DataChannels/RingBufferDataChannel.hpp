@@ -0,0 +1,87 @@
+#pragma once
+
+#include <FAST/DataChannels/DataChannel.hpp>
+#include <FAST/Semaphore.hpp>
+#include <atomic>
+
+namespace fast {
+
+/**
+ * @brief A bounded, lock-free ring buffer data channel
+ *
+ * This data channel has the same semantics as the QueuedDataChannel, but frames are stored in
+ * a fixed size ring buffer instead of a mutex protected queue.
+ * Producers and consumers claim slots in the ring buffer with atomic operations, and only
+ * block (using a lightweight semaphore which spins before sleeping) when the buffer is full or empty.
+ *
+ * By default multiple producers and multiple consumers (MPMC) are supported.
+ * If only one thread adds frames and one thread gets frames, which is the case
+ * for streamers, setSingleProducerSingleConsumer(true) enables a faster path without atomic read-modify-write operations.
+ *
+ * Use Streamer::setLockFreeDataChannel to use this data channel on the output of a streamer.
+ */
+class FAST_EXPORT RingBufferDataChannel : public DataChannel {
+    FAST_OBJECT(RingBufferDataChannel)
+    public:
+        /**
+         * Add frame to the data channel. This call may block
+         * if the buffer is full.
+         */
+        void addFrame(DataObject::pointer data) override;
+
+        /**
+         * @return the number of frames stored in this DataChannel
+         */
+        int getSize() override;
+
+        /**
+         * Set the maximum nr of frames that can be stored in this data channel
+         */
+        void setMaximumNumberOfFrames(uint frames) override;
+
+        int getMaximumNumberOfFrames() const override;
+
+        /**
+         * @brief This will unblock if this DataChannel is currently blocking. Used to stop a pipeline.
+         * @param Error message to supply.
+         */
+        void stop(std::string errorMessage) override;
+
+        bool hasCurrentData() override;
+
+        /**
+         * Get current frame, throws if current frame is not available.
+         * Must be called from the consumer thread.
+         */
+        DataObject::pointer getFrame() override;
+
+        /**
+         * @brief Enable single producer single consumer (SPSC) mode.
+         * Only enable this if exactly one thread adds frames, and one thread gets frames.
+         * @param spsc
+         */
+        void setSingleProducerSingleConsumer(bool spsc);
+        bool getSingleProducerSingleConsumer() const;
+        ~RingBufferDataChannel() override;
+    protected:
+        struct Slot {
+            // Sequence number of this slot, used to know if it is free (sequence == position) or filled (sequence == position+1)
+            std::atomic<uint64_t> sequence;
+            std::shared_ptr<DataObject> data;
+        };
+        Slot* m_slots = nullptr;
+        uint64_t m_bufferSize = 0; // Power of two
+        uint mMaximumNumberOfFrames;
+        bool m_singleProducerSingleConsumer = false;
+        // Keep head and tail on separate cache lines to avoid false sharing between producer and consumer
+        alignas(64) std::atomic<uint64_t> m_head = {0};
+        alignas(64) std::atomic<uint64_t> m_tail = {0};
+        alignas(64) std::atomic_bool m_stopped = {false};
+        std::unique_ptr<LightweightSemaphore> m_fillCount;
+        std::unique_ptr<LightweightSemaphore> m_emptyCount;
+
+        DataObject::pointer getNextDataFrame() override;
+        RingBufferDataChannel();
+};
+
+}
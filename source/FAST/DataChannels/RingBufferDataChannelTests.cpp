@@ -0,0 +1,177 @@
+#include <FAST/Testing.hpp>
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
+#include <FAST/DataChannels/QueuedDataChannel.hpp>
+#include <FAST/Tests/DummyObjects.hpp>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+using namespace fast;
+
+TEST_CASE("RingBufferDataChannel SPSC keeps order", "[fast][RingBufferDataChannel]") {
+    auto channel = RingBufferDataChannel::New();
+    channel->setSingleProducerSingleConsumer(true);
+    channel->setMaximumNumberOfFrames(4);
+    const int frames = 1000;
+    std::thread producer([&]() {
+        for(int i = 0; i < frames; ++i) {
+            auto data = DummyDataObject::New();
+            data->create(i);
+            channel->addFrame(data);
+        }
+    });
+    for(int i = 0; i < frames; ++i) {
+        auto data = channel->getNextFrame<DummyDataObject>();
+        CHECK(data->getID() == i);
+    }
+    producer.join();
+    CHECK(channel->getSize() == 0);
+    CHECK_THROWS(channel->getFrame());
+}
+
+TEST_CASE("RingBufferDataChannel MPMC delivers every frame once", "[fast][RingBufferDataChannel]") {
+    auto channel = RingBufferDataChannel::New();
+    channel->setMaximumNumberOfFrames(8);
+    const int producers = 4;
+    const int consumers = 4;
+    const int framesPerProducer = 500;
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for(int i = 0; i < framesPerProducer; ++i) {
+                auto data = DummyDataObject::New();
+                data->create(p*framesPerProducer + i);
+                channel->addFrame(data);
+            }
+        });
+    }
+    std::vector<std::vector<int>> received(consumers);
+    for(int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            for(int i = 0; i < producers*framesPerProducer/consumers; ++i)
+                received[c].push_back(channel->getNextFrame<DummyDataObject>()->getID());
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    std::vector<int> all;
+    for(auto& list : received)
+        all.insert(all.end(), list.begin(), list.end());
+    std::sort(all.begin(), all.end());
+    REQUIRE(all.size() == producers*framesPerProducer);
+    for(int i = 0; i < all.size(); ++i)
+        CHECK(all[i] == i);
+}
+
+TEST_CASE("RingBufferDataChannel getFrame succeeds when hasCurrentData while producer is adding frames", "[fast][RingBufferDataChannel]") {
+    for(bool spsc : {true, false}) {
+        INFO("SPSC: " << spsc);
+        auto channel = RingBufferDataChannel::New();
+        channel->setSingleProducerSingleConsumer(spsc);
+        channel->setMaximumNumberOfFrames(4);
+        const int frames = 20000;
+        std::thread producer([&]() {
+            for(int i = 0; i < frames; ++i) {
+                auto data = DummyDataObject::New();
+                data->create(i);
+                channel->addFrame(data);
+            }
+        });
+        // Poll like ProcessObject does, a frame reported as available must be retrievable
+        int failures = 0;
+        for(int frame = 0; frame < frames;) {
+            if(!channel->hasCurrentData())
+                continue;
+            try {
+                if(std::dynamic_pointer_cast<DummyDataObject>(channel->getFrame())->getID() != frame)
+                    ++failures;
+            } catch(Exception& e) {
+                ++failures;
+            }
+            channel->getNextFrame();
+            ++frame;
+        }
+        producer.join();
+        CHECK(failures == 0);
+    }
+}
+
+TEST_CASE("RingBufferDataChannel stop unblocks consumer", "[fast][RingBufferDataChannel]") {
+    auto channel = RingBufferDataChannel::New();
+    std::thread stopper([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        channel->stop("");
+    });
+    CHECK_THROWS_AS(channel->getNextFrame(), ThreadStopped);
+    stopper.join();
+}
+
+template <class Channel>
+static void benchmarkDataChannel(std::shared_ptr<Channel> channel, std::string name) {
+    const int frames = 100000;
+    std::vector<DataObject::pointer> objects;
+    for(int i = 0; i < frames; ++i)
+        objects.push_back(DummyDataObject::New());
+
+    // Throughput
+    auto start = std::chrono::high_resolution_clock::now();
+    std::thread producer([&]() {
+        for(int i = 0; i < frames; ++i)
+            channel->addFrame(objects[i]);
+    });
+    for(int i = 0; i < frames; ++i)
+        channel->getNextFrame();
+    producer.join();
+    double throughputTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // Wake-up latency: Time from a frame is added until a waiting consumer gets it
+    const int latencyFrames = 1000;
+    std::atomic<int64_t> addedTime;
+    double latencySum = 0;
+    std::thread latencyProducer([&]() {
+        for(int i = 0; i < latencyFrames; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            addedTime = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+            channel->addFrame(objects[i]);
+        }
+    });
+    for(int i = 0; i < latencyFrames; ++i) {
+        channel->getNextFrame();
+        latencySum += std::chrono::high_resolution_clock::now().time_since_epoch().count() - addedTime;
+    }
+    latencyProducer.join();
+    double latency = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::duration((int64_t)(latencySum / latencyFrames))).count();
+
+    std::cout << name << ": " << (int)(frames / throughputTime) << " frames/s, average wake-up latency " << latency << " us" << std::endl;
+}
+
+TEST_CASE("RingBufferDataChannel vs QueuedDataChannel benchmark", "[fast][RingBufferDataChannel][benchmark][visual]") {
+    benchmarkDataChannel(QueuedDataChannel::New(), "QueuedDataChannel");
+    auto mpmc = RingBufferDataChannel::New();
+    benchmarkDataChannel(mpmc, "RingBufferDataChannel (MPMC)");
+    auto spsc = RingBufferDataChannel::New();
+    spsc->setSingleProducerSingleConsumer(true);
+    benchmarkDataChannel(spsc, "RingBufferDataChannel (SPSC)");
+}
+
+TEST_CASE("Streamer with lock-free data channel", "[fast][RingBufferDataChannel]") {
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+    streamer->setLockFreeDataChannel(true);
+
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(streamer->getOutputPort());
+    auto port = po->getOutputPort();
+
+    bool lastFrame = false;
+    int timestep = 0;
+    while(!lastFrame) {
+        po->update(timestep);
+        auto data = port->getNextFrame<DummyDataObject>();
+        lastFrame = data->isLastFrame();
+        CHECK(data->getID() == timestep);
+        timestep++;
+    }
+    CHECK(timestep == 20);
+}
@@ -5,6 +5,7 @@
 #include <FAST/Algorithms/ImagePatch/PatchGenerator.hpp>
 #include <FAST/Exporters/ImageExporter.hpp>
 #include <utility>
+#include <sstream>
 
 namespace fast {
 
@@ -45,16 +46,27 @@ void ImagePyramidPatchExporter::execute() {
     }
 }
 
+template <typename T>
+std::string to_string_with_precision(const T a_value, const int n = 6)
+{
+    std::ostringstream out;
+    out.precision(n);
+    out << std::fixed << a_value;
+    return std::move(out).str();
+}
+
 void ImagePyramidPatchExporter::exportPatch(std::shared_ptr<Image> patch) {
     auto level = patch->getFrameData("patch-level");
-    auto patchX = std::stoi(patch->getFrameData("patchid-x"));
-    auto patchY = std::stoi(patch->getFrameData("patchid-y"));
-    auto patchWidth = std::stoi(patch->getFrameData("patch-width"));
-    auto patchHeight = std::stoi(patch->getFrameData("patch-height"));
-    auto patchOverlapX = std::stoi(patch->getFrameData("patch-overlap-x"));
-    auto patchOverlapY = std::stoi(patch->getFrameData("patch-overlap-y"));
-    auto spacingX = patch->getFrameData("patch-spacing-x");
-    auto spacingY = patch->getFrameData("patch-spacing-y");
+    auto patchX = patch->getFrameData<int>("patchid-x");
+    auto patchY = patch->getFrameData<int>("patchid-y");
+    auto patchWidth = patch->getFrameData<int>("patch-width");
+    auto patchHeight = patch->getFrameData<int>("patch-height");
+    auto patchOverlapX = patch->getFrameData<int>("patch-overlap-x");
+    auto patchOverlapY = patch->getFrameData<int>("patch-overlap-y");
+    // Image patch spacing of a WSI can be very small, and std::to_string can round the numbers,
+    // therefore use fixed notation with a high precision in the filename
+    auto spacingX = to_string_with_precision(patch->getFrameData<float>("patch-spacing-x"), 32);
+    auto spacingY = to_string_with_precision(patch->getFrameData<float>("patch-spacing-y"), 32);
     auto totalWidth = patch->getFrameData("original-width");
     auto totalHeight = patch->getFrameData("original-height");
     // Calculate offset
@@ -1,7 +1,7 @@
 #include "MetaImageExporter.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Compression.hpp"
 #include <fstream>
-#include <zlib/zlib.h>
 
 namespace fast {
 
@@ -16,46 +16,22 @@ MetaImageExporter::MetaImageExporter(std::string filename, bool compress) : File
     setCompression(compress);
 }
 
-template <class T>
-inline std::size_t writeToRawFile(std::string filename, T * data, unsigned int numberOfElements, bool useCompression) {
-    // TODO use mapped_file_sink form boost instead
-    FILE* file = fopen(filename.c_str(), "wb");
-    if(file == NULL) {
+static std::size_t writeToRawFile(std::string filename, const void* data, std::size_t size, bool useCompression, std::size_t chunkSize, std::vector<std::size_t>& chunkOffsets) {
+    std::ofstream file(filename, std::ofstream::binary | std::ofstream::out);
+    if(!file.is_open()) {
         throw Exception("Could not open file " + filename + " for writing");
     }
     std::size_t returnSize;
     if(useCompression) {
-        // Have to allocate enough memory for compression: 1.1*DATA_SIZE_IN_BYTES + 12
-        std::size_t sizeDataCompressed = compressBound(sizeof(T)*numberOfElements);
-        std::size_t sizeDataOriginal = sizeof(T)*numberOfElements;
-        Bytef* writeData = (Bytef*)malloc(sizeDataCompressed);
-        int z_result = compress(
-                (Bytef*)writeData,
-                (uLongf*)&sizeDataCompressed,
-                (Bytef*)data,
-                sizeDataOriginal
-        );
-        switch(z_result) {
-        case Z_OK:
-            break;
-        case Z_MEM_ERROR:
-            throw Exception("Out of memory while compressing raw file");
-            break;
-        case Z_BUF_ERROR:
-            throw Exception("Output buffer was not large enough while compressing raw file");
-            break;
-        }
-        // sizeDataCompressed was changed after compress call
-        fwrite(writeData, sizeDataCompressed, 1, file);
-        returnSize = sizeDataCompressed;
-        fclose(file);
-        free(writeData);
+        chunkOffsets = compressZlibChunks(data, size, chunkSize, file);
+        // Size includes the 4 byte zlib trailer after the last chunk
+        returnSize = chunkOffsets.back() + 4;
     } else {
-        returnSize = sizeof(T)*numberOfElements;
-        fwrite(data, sizeof(T), numberOfElements, file);
-        fclose(file);
+        returnSize = size;
+        file.write((const char*)data, size);
     }
-
+    if(!file)
+        throw Exception("Error while writing to file " + filename);
 
     return returnSize;
 }
@@ -112,38 +88,42 @@ void MetaImageExporter::execute() {
         extension = ".zraw";
     }
     std::string rawFilename = m_filename.substr(0,m_filename.length()-4) + extension;
-    const unsigned int numberOfElements = input->getWidth()*input->getHeight()*
+    const std::size_t numberOfElements = (std::size_t)input->getWidth()*input->getHeight()*
             input->getDepth()*input->getNrOfChannels();
 
-    ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
-    void* data = access->get();
-    std::size_t compressedSize;
     switch(input->getDataType()) {
     case TYPE_FLOAT:
         mhdFile << "ElementType = MET_FLOAT\n";
-        compressedSize = writeToRawFile<float>(rawFilename,(float*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_UINT8:
         mhdFile << "ElementType = MET_UCHAR\n";
-        compressedSize = writeToRawFile<uchar>(rawFilename,(uchar*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_INT8:
         mhdFile << "ElementType = MET_CHAR\n";
-        compressedSize = writeToRawFile<char>(rawFilename,(char*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_UINT16:
         mhdFile << "ElementType = MET_USHORT\n";
-        compressedSize = writeToRawFile<ushort>(rawFilename,(ushort*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_INT16:
         mhdFile << "ElementType = MET_SHORT\n";
-        compressedSize = writeToRawFile<short>(rawFilename,(short*)data,numberOfElements,mUseCompression);
         break;
     }
+    ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
+    std::vector<std::size_t> chunkOffsets;
+    const std::size_t compressedSize = writeToRawFile(rawFilename, access->get(),
+            numberOfElements*getSizeOfDataType(input->getDataType(), 1), mUseCompression, mCompressionChunkSize, chunkOffsets);
 
     if(mUseCompression) {
         mhdFile << "CompressedData = True" << "\n";
         mhdFile << "CompressedDataSize = " << compressedSize << "\n";
+        if(chunkOffsets.size() > 2) {
+            // Index of independently compressed chunks, used by MetaImageImporter to decompress in parallel
+            mhdFile << "CompressedDataChunkSize = " << mCompressionChunkSize << "\n";
+            mhdFile << "CompressedDataChunkOffsets =";
+            for(auto offset : chunkOffsets)
+                mhdFile << " " << offset;
+            mhdFile << "\n";
+        }
     }
 
     // Add metadata
@@ -181,6 +161,11 @@ void MetaImageExporter::setCompression(bool compress) {
     mIsModified = true;
 }
 
+void MetaImageExporter::setCompressionChunkSize(std::size_t bytes) {
+    mCompressionChunkSize = bytes;
+    mIsModified = true;
+}
+
 void MetaImageExporter::setMetadata(std::string key, std::string value) {
     mMetadata[key] = value;
 }
@@ -11,6 +11,9 @@ namespace fast {
  * This exporter writes 2D and 3D images using the MetaImage format which are pairs of .mhd text files and .raw files
  * containing raw pixel data.
  * Supports compression (.zraw) using the zlib library.
+ * The data is compressed in parallel in independent chunks, and an index of the chunks is stored in the .mhd file,
+ * so that MetaImageImporter can decompress in parallel and read parts of the image.
+ * The .zraw file is still a standard zlib stream which can be read by other MetaImage readers.
  * All meta data in the Image is stored in the .mhd text file.
  *
  * <h3>Input ports</h3>
@@ -38,6 +41,12 @@ class FAST_EXPORT MetaImageExporter : public FileExporter {
          * Deprecated
          */
         void disableCompression();
+        /**
+         * Set uncompressed size of each independently compressed chunk. Default is 1 MB.
+         * If 0, the image is compressed as a single chunk, which can only be decompressed on a single thread.
+         * @param bytes
+         */
+        void setCompressionChunkSize(std::size_t bytes);
         /**
          * Add additional meta data to the mhd file.
          * This can also be added to the input image object.
@@ -52,6 +61,7 @@ class FAST_EXPORT MetaImageExporter : public FileExporter {
 
         std::map<std::string, std::string> mMetadata;
         bool mUseCompression;
+        std::size_t mCompressionChunkSize = 1024*1024;
 };
 
 } // end namespace fast
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "VTKMeshFileExporter.hpp"
 #include "MetaImageExporter.hpp"
 #include <FAST/Utility.hpp>
+#include <FAST/ThreadPool.hpp>
+#include <algorithm>
 
 namespace fast {
 
@@ -34,6 +36,74 @@ uint64_t StreamToFileExporter::getFrameCounter() const {
     return m_frameCounter;
 }
 
+void StreamToFileExporter::writeFrame(DataObject::pointer data, const std::string& filename) {
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t bytes = 0;
+    if(auto imageInput = std::dynamic_pointer_cast<Image>(data)) {
+        auto exporter = MetaImageExporter::New();
+        exporter->enableCompression();
+        exporter->setFilename(filename + ".mhd");
+        exporter->setInputData(data);
+        exporter->update();
+        bytes = (uint64_t)imageInput->getNrOfVoxels()*getSizeOfDataType(imageInput->getDataType(), imageInput->getNrOfChannels());
+    } else if(auto meshInput = std::dynamic_pointer_cast<Mesh>(data)) {
+        auto exporter = VTKMeshFileExporter::New();
+        exporter->setFilename(filename + ".vtk");
+        exporter->setInputData(data);
+        exporter->update();
+    } else {
+        throw Exception("StreamToFileExporter can only handle Image and Mesh data objects");
+    }
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_statistics.framesWritten += 1;
+    m_statistics.bytesWritten += bytes;
+    m_statistics.writeSeconds += duration.count();
+}
+
+void StreamToFileExporter::writeNextFrame() {
+    QueuedFrame frame;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        // Frame may have been dropped from the queue
+        if(m_queue.empty())
+            return;
+        frame = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_framesBeingWritten += 1;
+    }
+    m_queueChanged.notify_all();
+    std::exception_ptr error;
+    try {
+        writeFrame(frame.data, frame.filename);
+    } catch(...) {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_framesBeingWritten -= 1;
+        // Keep first error, it is rethrown on the pipeline thread
+        if(error && !m_writeError)
+            m_writeError = error;
+    }
+    m_queueChanged.notify_all();
+}
+
+void StreamToFileExporter::waitForWriters() {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_queueChanged.wait(lock, [this]() { return m_queue.empty() && m_framesBeingWritten == 0; });
+}
+
+void StreamToFileExporter::flush() {
+    waitForWriters();
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if(m_writeError) {
+        auto error = m_writeError;
+        m_writeError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
 void StreamToFileExporter::execute() {
     // Get data object
     auto input = getInputData<DataObject>();
@@ -59,28 +129,113 @@ void StreamToFileExporter::execute() {
         throw Exception("Maximum nr of frames (" + std::to_string(m_frameLimit) + ") reached in StreamToFileExporter");
 
     std::string currentFileName = join(m_path, m_currentFolder, m_filename + "_" + std::to_string(m_frameCounter));
-    if(auto imageInput = std::dynamic_pointer_cast<Image>(input)) {
-        auto exporter = MetaImageExporter::New();
-        exporter->enableCompression();
-        exporter->setFilename(currentFileName + ".mhd");
-        exporter->setInputData(input);
-        exporter->update();
-    } else if(auto meshInput = std::dynamic_pointer_cast<Mesh>(input)) {
-        auto exporter = VTKMeshFileExporter::New();
-        exporter->setFilename(currentFileName + ".vtk");
-        exporter->setInputData(input);
-        exporter->update();
-    } else {
+    if(!m_asynchronous) {
+        writeFrame(input, currentFileName);
+        m_frameCounter += 1;
+        addOutputData(0, input);
+        return;
+    }
+
+    if(!std::dynamic_pointer_cast<Image>(input) && !std::dynamic_pointer_cast<Mesh>(input))
         throw Exception("StreamToFileExporter can only handle Image and Mesh data objects");
+    if(!m_writerPool || m_writerPool->getNumberOfThreads() != m_writerThreads) {
+        waitForWriters();
+        m_writerPool = std::make_unique<ThreadPool>(m_writerThreads);
     }
+    const bool lastFrame = input->isLastFrame();
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        if(m_writeError) {
+            auto error = m_writeError;
+            m_writeError = nullptr;
+            std::rethrow_exception(error);
+        }
+        if(m_queue.size() >= m_maximumQueueSize) {
+            if(m_queuePolicy == WriteQueuePolicy::DropNewest && !lastFrame) {
+                m_statistics.framesDropped += 1;
+                lock.unlock();
+                addOutputData(0, input);
+                return;
+            } else if(m_queuePolicy == WriteQueuePolicy::DropOldest) {
+                m_queue.pop_front();
+                m_statistics.framesDropped += 1;
+            } else {
+                m_queueChanged.wait(lock, [this]() { return m_queue.size() < m_maximumQueueSize; });
+            }
+        }
+        m_queue.push_back({input, currentFileName});
+        m_statistics.framesQueued += 1;
+        m_statistics.peakQueueSize = std::max(m_statistics.peakQueueSize, m_queue.size());
+    }
+    m_writerPool->submit([this]() { writeNextFrame(); });
     m_frameCounter += 1;
+    if(lastFrame)
+        flush();
     addOutputData(0, input);
 }
 
 void StreamToFileExporter::reset() {
+    waitForWriters();
     m_frameCounter = 0;
     m_currentFolder = "";
     m_hasStarted = false;
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_statistics = Statistics();
+        error = m_writeError;
+        m_writeError = nullptr;
+    }
+    if(error)
+        std::rethrow_exception(error);
+}
+
+void StreamToFileExporter::setAsynchronous(bool asynchronous) {
+    if(!asynchronous)
+        flush();
+    m_asynchronous = asynchronous;
+}
+
+bool StreamToFileExporter::getAsynchronous() const {
+    return m_asynchronous;
+}
+
+void StreamToFileExporter::setNumberOfWriterThreads(int threads) {
+    if(threads < 1)
+        throw Exception("Number of writer threads in StreamToFileExporter must be at least 1");
+    m_writerThreads = threads;
+}
+
+void StreamToFileExporter::setMaximumQueueSize(int size) {
+    if(size < 1)
+        throw Exception("Maximum queue size in StreamToFileExporter must be at least 1");
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_maximumQueueSize = size;
+}
+
+void StreamToFileExporter::setQueuePolicy(WriteQueuePolicy policy) {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_queuePolicy = policy;
+}
+
+StreamToFileExporter::Statistics StreamToFileExporter::getStatistics() {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    Statistics statistics = m_statistics;
+    statistics.queueSize = m_queue.size();
+    if(m_hasStarted) {
+        const float duration = getRecordingDuration();
+        if(duration > 0.0f) {
+            statistics.framesPerSecond = statistics.framesWritten / duration;
+            statistics.megabytesPerSecond = (statistics.bytesWritten / (1024.0f*1024.0f)) / duration;
+        }
+    }
+    return statistics;
+}
+
+StreamToFileExporter::~StreamToFileExporter() {
+    // Write remaining frames before the writer threads are stopped
+    waitForWriters();
+    m_writerPool.reset();
 }
 
 StreamToFileExporter::StreamToFileExporter() {
@@ -2,12 +2,33 @@
 
 #include <FAST/ProcessObject.hpp>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
 
 namespace fast {
 
+class ThreadPool;
+
+/**
+ * @brief What StreamToFileExporter should do with a new frame when its write queue is full
+ */
+enum class WriteQueuePolicy {
+    Block, // Wait until a writer thread has taken a frame from the queue
+    DropNewest, // Skip the new frame
+    DropOldest // Remove the oldest frame in the queue which has not started writing yet
+};
+
 /**
  * @brief Write a stream of Mesh or Image data as a sequence of files.
  *
+ * By default each frame is written on the pipeline thread.
+ * In asynchronous mode, frames are put in a bounded queue and written by a pool of writer threads, so that
+ * a slow disk or compression doesn't stall the pipeline. When the queue is full, the WriteQueuePolicy decides whether
+ * to wait or drop frames. The last frame of a stream is never dropped.
+ * All queued frames are written before execute returns for the last frame of a stream, and when reset is called.
+ *
  * <h3>Input ports</h3>
  * - 0: Image or Mesh
  *
@@ -36,11 +57,58 @@ class FAST_EXPORT StreamToFileExporter : public ProcessObject {
         uint64_t getFrameCounter() const;
         std::string getCurrentDestinationFolder() const;
         float getRecordingDuration() const;
+        /**
+         * @brief Write all queued frames and start a new recording.
+         * Rethrows any exception which occurred when writing a frame asynchronously.
+         */
         void reset();
         bool isEnabled();
+        /**
+         * @brief Write frames in separate writer threads instead of on the pipeline thread. Default is false.
+         * @param asynchronous
+         */
+        void setAsynchronous(bool asynchronous);
+        bool getAsynchronous() const;
+        /**
+         * @brief Set number of writer threads used in asynchronous mode. Default is 2.
+         * @param threads
+         */
+        void setNumberOfWriterThreads(int threads);
+        /**
+         * @brief Set maximum number of frames waiting to be written in asynchronous mode. Default is 32.
+         * @param size
+         */
+        void setMaximumQueueSize(int size);
+        /**
+         * @brief Set what to do when the write queue is full. Default is WriteQueuePolicy::Block.
+         * @param policy
+         */
+        void setQueuePolicy(WriteQueuePolicy policy);
+        /**
+         * @brief Block until all queued frames are written.
+         * Rethrows any exception which occurred when writing a frame asynchronously.
+         */
+        void flush();
+        struct Statistics {
+            uint64_t framesQueued = 0; // Frames added to the write queue, always 0 when not asynchronous
+            uint64_t framesWritten = 0;
+            uint64_t framesDropped = 0;
+            std::size_t queueSize = 0; // Frames currently waiting to be written
+            std::size_t peakQueueSize = 0;
+            uint64_t bytesWritten = 0; // Uncompressed size of the written images
+            double writeSeconds = 0.0; // Time spent writing, summed over all writer threads
+            float framesPerSecond = 0.0f; // Written frames per second of recording duration
+            float megabytesPerSecond = 0.0f; // Written megabytes per second of recording duration
+        };
+        Statistics getStatistics();
+        ~StreamToFileExporter() override;
     private:
         StreamToFileExporter();
         void execute() override;
+        void writeNextFrame();
+        void writeFrame(DataObject::pointer data, const std::string& filename);
+        // Wait until queue is empty and no frames are being written
+        void waitForWriters();
 
         std::string m_path = "";
         std::string m_folder;
@@ -51,6 +119,22 @@ class FAST_EXPORT StreamToFileExporter : public ProcessObject {
         std::chrono::high_resolution_clock::time_point m_recordingStartTime;
         bool m_enabled = true;
         bool m_hasStarted = false;
+
+        struct QueuedFrame {
+            DataObject::pointer data;
+            std::string filename;
+        };
+        bool m_asynchronous = false;
+        int m_writerThreads = 2;
+        std::size_t m_maximumQueueSize = 32;
+        WriteQueuePolicy m_queuePolicy = WriteQueuePolicy::Block;
+        std::deque<QueuedFrame> m_queue;
+        int m_framesBeingWritten = 0;
+        std::exception_ptr m_writeError;
+        Statistics m_statistics;
+        std::mutex m_queueMutex;
+        std::condition_variable m_queueChanged;
+        std::unique_ptr<ThreadPool> m_writerPool;
 };
 
 }
\ No newline at end of file
@@ -36,6 +36,10 @@ void TIFFImagePyramidExporter::execute() {
 
     if(imagePyramid->usesTIFF()) {
         // If image pyramid is using TIFF backend. It is already stored on disk, we just need to copy it..
+        if(imagePyramid->getDeferredLevelBuilding()) {
+            // Make sure all levels are built and written to file first
+            imagePyramid->getAccess(ACCESS_READ_WRITE)->buildPyramidLevels();
+        }
         if(fileExists(m_filename)) {
             // If destination file already exists, we have to remove the existing file, or copy will not run.
             QFile::remove(m_filename.c_str());
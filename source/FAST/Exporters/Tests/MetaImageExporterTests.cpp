@@ -3,6 +3,7 @@
 #include "FAST/Importers/MetaImageImporter.hpp"
 #include "FAST/Data/Image.hpp"
 #include "FAST/Tests/DataComparison.hpp"
+#include <cstring>
 
 using namespace fast;
 
@@ -335,3 +336,38 @@ TEST_CASE("Write a compressed 3D image with the MetaImageExporter", "[fast][Meta
         }
     }
 }
+
+TEST_CASE("Write a compressed 3D image in chunks with the MetaImageExporter and read slice range", "[fast][MetaImageExporter]") {
+    const int width = 64;
+    const int height = 48;
+    const int depth = 40;
+    const int sliceSize = width*height*2;
+    auto data = std::make_unique<ushort[]>(sliceSize*depth);
+    for(int i = 0; i < sliceSize*depth; ++i)
+        data[i] = (ushort)((i*7) % 1000);
+    auto image = Image::create(width, height, depth, TYPE_UINT16, 2, data.get());
+    image->setSpacing(Vector3f(1.0f, 1.0f, 2.0f));
+
+    // Chunks are not aligned with slices
+    for(std::size_t chunkSize : {std::size_t(0), std::size_t(5000)}) {
+        INFO("Chunk size: " << chunkSize);
+        auto exporter = MetaImageExporter::create("MetaImageExporterChunkTest.mhd", true);
+        exporter->setCompressionChunkSize(chunkSize);
+        exporter->connect(image);
+        exporter->run();
+
+        auto importer = MetaImageImporter::create("MetaImageExporterChunkTest.mhd");
+        auto image2 = importer->runAndGetOutputData<Image>();
+        REQUIRE(image2->getDepth() == depth);
+        auto access = image2->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), data.get(), sliceSize*depth*sizeof(ushort)) == 0);
+
+        auto sliceImporter = MetaImageImporter::create("MetaImageExporterChunkTest.mhd");
+        sliceImporter->setSliceRange(13, 27);
+        auto slices = sliceImporter->runAndGetOutputData<Image>();
+        REQUIRE(slices->getDepth() == 14);
+        auto sliceAccess = slices->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(sliceAccess->get(), &data[sliceSize*13], sliceSize*14*sizeof(ushort)) == 0);
+        CHECK(SceneGraph::getEigenTransformFromData(slices).translation().z() == Approx(26.0f));
+    }
+}
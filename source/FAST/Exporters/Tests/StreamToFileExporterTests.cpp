@@ -0,0 +1,68 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Exporters/StreamToFileExporter.hpp"
+#include "FAST/Data/Image.hpp"
+
+using namespace fast;
+
+// Write a stream of images, the last one is marked as last frame
+static void writeStream(StreamToFileExporter::pointer exporter, int frames) {
+    std::vector<uchar> data(256*256);
+    for(int frame = 0; frame < frames; ++frame) {
+        for(int i = 0; i < data.size(); ++i)
+            data[i] = (uchar)((i + frame*7) % 256);
+        auto image = Image::create(256, 256, TYPE_UINT8, 1, data.data());
+        if(frame == frames - 1)
+            image->setLastFrame("test");
+        exporter->connect(image);
+        exporter->run();
+    }
+}
+
+TEST_CASE("StreamToFileExporter writes all frames asynchronously", "[fast][StreamToFileExporter]") {
+    auto exporter = StreamToFileExporter::create(".", "StreamToFileExporterAsyncTest");
+    exporter->setAsynchronous(true);
+    exporter->setNumberOfWriterThreads(2);
+    exporter->setMaximumQueueSize(4);
+    writeStream(exporter, 20);
+
+    // Queue is flushed on last frame
+    auto statistics = exporter->getStatistics();
+    CHECK(statistics.framesQueued == 20);
+    CHECK(statistics.framesWritten == 20);
+    CHECK(statistics.framesDropped == 0);
+    CHECK(statistics.queueSize == 0);
+    CHECK(statistics.peakQueueSize <= 4);
+    CHECK(statistics.bytesWritten == 20*256*256);
+    for(int frame = 0; frame < 20; ++frame)
+        CHECK(fileExists(join(exporter->getCurrentDestinationFolder(), "frame_" + std::to_string(frame) + ".mhd")));
+    exporter->reset();
+    CHECK(exporter->getStatistics().framesWritten == 0);
+}
+
+TEST_CASE("StreamToFileExporter writes frames synchronously without queueing", "[fast][StreamToFileExporter]") {
+    auto exporter = StreamToFileExporter::create(".", "StreamToFileExporterSyncTest");
+    writeStream(exporter, 5);
+
+    auto statistics = exporter->getStatistics();
+    CHECK(statistics.framesQueued == 0);
+    CHECK(statistics.framesWritten == 5);
+    CHECK(statistics.peakQueueSize == 0);
+    for(int frame = 0; frame < 5; ++frame)
+        CHECK(fileExists(join(exporter->getCurrentDestinationFolder(), "frame_" + std::to_string(frame) + ".mhd")));
+}
+
+TEST_CASE("StreamToFileExporter drops frames when write queue is full", "[fast][StreamToFileExporter]") {
+    auto exporter = StreamToFileExporter::create(".", "StreamToFileExporterDropTest");
+    exporter->setAsynchronous(true);
+    exporter->setNumberOfWriterThreads(1);
+    exporter->setMaximumQueueSize(1);
+    exporter->setQueuePolicy(WriteQueuePolicy::DropNewest);
+    writeStream(exporter, 50);
+
+    auto statistics = exporter->getStatistics();
+    CHECK(statistics.framesWritten + statistics.framesDropped == 50);
+    CHECK(statistics.framesWritten == statistics.framesQueued);
+    CHECK(statistics.queueSize == 0);
+    // Last frame is never dropped
+    CHECK(fileExists(join(exporter->getCurrentDestinationFolder(), "frame_" + std::to_string(exporter->getFrameCounter() - 1) + ".mhd")));
+}
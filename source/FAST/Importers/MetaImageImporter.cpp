@@ -3,8 +3,17 @@
 #include "FAST/Data/Image.hpp"
 #include "FAST/Utility.hpp"
 #include <fstream>
+#include <map>
 #include <set>
-#include <zlib/zlib.h>
+#include "FAST/Compression.hpp"
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 using namespace fast;
 
 MetaImageImporter::MetaImageImporter() {
@@ -14,6 +23,19 @@ MetaImageImporter::MetaImageImporter() {
     setMainDevice(Host::getInstance()); // Default is to put image on host
 }
 
+void MetaImageImporter::setMemoryMapping(bool memoryMapping) {
+    m_memoryMapping = memoryMapping;
+    setModified(true);
+}
+
+void MetaImageImporter::setSliceRange(int start, int end) {
+    if(start < 0 || end <= start)
+        throw Exception("Invalid slice range given to MetaImageImporter");
+    m_sliceRangeStart = start;
+    m_sliceRangeEnd = end;
+    setModified(true);
+}
+
 MetaImageImporter::MetaImageImporter(std::string filename) : FileImporter(filename) {
     createOutputPort(0, "Image");
     setMainDevice(Host::getInstance()); // Default is to put image on host
@@ -37,70 +59,88 @@ std::vector<std::string> stringSplit(std::string str, std::string delimiter) {
     return values;
 }
 
+// Read voxels [firstVoxel, lastVoxel) of the raw file
 template <class T>
-static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize) {
-    auto data = make_uninitialized_unique<T[]>(voxels*nrOfComponents);
+static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, const std::vector<std::size_t>& chunkOffsets, std::size_t chunkSize, std::size_t firstVoxel, std::size_t lastVoxel) {
+    const std::size_t begin = firstVoxel*nrOfComponents*sizeof(T);
+    const std::size_t end = lastVoxel*nrOfComponents*sizeof(T);
+    auto data = make_uninitialized_unique<T[]>((lastVoxel - firstVoxel)*nrOfComponents);
+    std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
+    if(!file.is_open())
+        throw FileNotFoundException(rawFilename);
     if(compressed) {
-        // Read compressed data
-        std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
-        if(!file.is_open())
-            throw FileNotFoundException(rawFilename);
-
-        // Determine the file length
-        file.seekg(0, std::ios_base::end);
-        std::size_t size = file.tellg();
-        file.seekg(0, std::ios_base::beg);
-
-        auto fileData = make_uninitialized_unique<Bytef[]>(size);
-        file.read((char*)&fileData[0], size);
-        file.close();
-
-        unsigned long uncompressedSize = sizeof(T)*voxels*nrOfComponents;
-		int z_result = uncompress(
-            (Bytef*)data.get(),       // destination for the uncompressed
-                                    // data.  This should be the size of
-                                    // the original data, which you should
-                                    // already know.
-
-            (uLongf *)&uncompressedSize,  // length of destination (uncompressed)
-                                    // buffer
-
-            fileData.get(),   // source buffer - the compressed data
-
-            (uLong)compressedFileSize);   // length of compressed data in bytes
-        switch( z_result )
-        {
-        case Z_OK:
-            break;
-
-        case Z_MEM_ERROR:
-            throw Exception("Out of memory while decompressing raw file");
-            break;
-
-        case Z_BUF_ERROR:
-            throw Exception("Output buffer was not large enough while decompressing raw file");
-            break;
+        if(chunkOffsets.empty()) {
+            // Standard zlib stream, decompress sequentially until end of range
+            decompressZlib(file, begin, end, data.get());
+        } else {
+            decompressZlibChunks(file, chunkOffsets, chunkSize, voxels*nrOfComponents*sizeof(T), begin, end, data.get());
         }
-        file.close();
     } else {
-        std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
-        if(!file.is_open())
-            throw FileNotFoundException(rawFilename);
-
         // Determine the file length
         file.seekg(0, std::ios_base::end);
         std::size_t size = file.tellg();
-        file.seekg(0, std::ios_base::beg);
         std::size_t expectedSize = voxels*nrOfComponents*sizeof(T);
         if(size != expectedSize)
             throw Exception("Unexpected file system when opening" + rawFilename + " expected: " + std::to_string(expectedSize) + " got: " + std::to_string(size));
 
-        file.read((char*)data.get(), size);
-        file.close();
+        file.seekg(begin, std::ios_base::beg);
+        file.read((char*)data.get(), end - begin);
     }
+    file.close();
     return data;
 }
 
+// Memory map bytes [begin, end) of a raw file. The mapping is private, thus writing to it does not change the file,
+// but only creates a copy of the pages which are written to. Pages are read from the file when first accessed.
+static std::shared_ptr<void> mapRawData(std::string rawFilename, std::size_t expectedSize, std::size_t begin, std::size_t end) {
+#ifdef WIN32
+    HANDLE file = CreateFileA(rawFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        throw FileNotFoundException(rawFilename);
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    if((std::size_t)fileSize.QuadPart != expectedSize) {
+        CloseHandle(file);
+        throw Exception("Unexpected file system when opening" + rawFilename + " expected: " + std::to_string(expectedSize) + " got: " + std::to_string(fileSize.QuadPart));
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file); // Mapping keeps the file open
+    if(mapping == NULL)
+        throw Exception("Failed to memory map " + rawFilename);
+    // View must start at a multiple of the allocation granularity
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const std::size_t mapBegin = begin - begin % systemInfo.dwAllocationGranularity;
+    void* view = MapViewOfFile(mapping, FILE_MAP_COPY, (DWORD)((uint64_t)mapBegin >> 32), (DWORD)(mapBegin & 0xFFFFFFFF), end - mapBegin);
+    CloseHandle(mapping); // View keeps the mapping alive
+    if(view == NULL)
+        throw Exception("Failed to memory map " + rawFilename);
+    return std::shared_ptr<void>((char*)view + (begin - mapBegin), [view](void*) {
+        UnmapViewOfFile(view);
+    });
+#else
+    int file = open(rawFilename.c_str(), O_RDONLY);
+    if(file == -1)
+        throw FileNotFoundException(rawFilename);
+    struct stat fileInfo;
+    if(fstat(file, &fileInfo) != 0 || (std::size_t)fileInfo.st_size != expectedSize) {
+        close(file);
+        throw Exception("Unexpected file system when opening" + rawFilename + " expected: " + std::to_string(expectedSize) + " got: " + std::to_string(fileInfo.st_size));
+    }
+    // Mapping must start at a multiple of the page size
+    const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    const std::size_t mapBegin = begin - begin % pageSize;
+    const std::size_t mapSize = end - mapBegin;
+    void* mapped = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, mapBegin);
+    close(file); // Mapping keeps the file open
+    if(mapped == MAP_FAILED)
+        throw Exception("Failed to memory map " + rawFilename);
+    return std::shared_ptr<void>((char*)mapped + (begin - mapBegin), [mapped, mapSize](void*) {
+        munmap(mapped, mapSize);
+    });
+#endif
+}
+
 void MetaImageImporter::execute() {
     if(m_filename == "")
         throw Exception("Filename was not set in MetaImageImporter");
@@ -145,14 +185,16 @@ void MetaImageImporter::execute() {
     Vector3f spacing(1,1,1), offset(0,0,0), centerOfRotation(0,0,0);
     Matrix3f transformMatrix = Matrix3f::Identity();
     bool isCompressed = false;
-    std::size_t compressedDataSize = 0;
+    std::size_t chunkSize = 0;
+    std::vector<std::size_t> chunkOffsets;
     std::map<std::string, std::string> metadata;
 
     // Blacklist of keys to avoid importing as metadata
     std::set<std::string> blacklist = {
         "NDims",
         "ObjectType",
-        "BinaryData"
+        "BinaryData",
+        "CompressedDataSize"
     };
 
     do{
@@ -189,8 +231,13 @@ void MetaImageImporter::execute() {
             sizeFound = true;
         } else if(key == "CompressedData" && value == "True") {
             isCompressed = true;
-        } else if(key == "CompressedDataSize") {
-            compressedDataSize = std::stoi(value);
+        } else if(key == "CompressedDataChunkSize") {
+            chunkSize = std::stoull(value);
+        } else if(key == "CompressedDataChunkOffsets") {
+            for(auto&& chunkOffset : split(value)) {
+                if(!chunkOffset.empty())
+                    chunkOffsets.push_back(std::stoull(chunkOffset));
+            }
         } else if(key == "ElementDataFile") {
             rawFilename = value;
             rawFilenameFound = true;
@@ -355,18 +402,51 @@ void MetaImageImporter::execute() {
 
 
     Image::pointer output;
-    std::size_t voxels = size.x()*size.y();
+    std::size_t voxels = (std::size_t)size.x()*size.y();
     if(size.size() == 3)
         voxels *= size.z();
-    if(typeName == "MET_SHORT" || typeName == "MET_INT") {
+    std::size_t firstVoxel = 0;
+    std::size_t lastVoxel = voxels;
+    if(m_sliceRangeStart >= 0) {
+        if(size.size() != 3)
+            throw Exception("Slice range can only be used with 3D images in MetaImageImporter");
+        const int end = std::min(m_sliceRangeEnd, (int)size.z());
+        if(m_sliceRangeStart >= end)
+            throw Exception("Slice range " + std::to_string(m_sliceRangeStart) + "-" + std::to_string(m_sliceRangeEnd) + " is outside of image in MetaImageImporter");
+        firstVoxel = (std::size_t)size.x()*size.y()*m_sliceRangeStart;
+        lastVoxel = (std::size_t)size.x()*size.y()*end;
+        // Move origin to first slice which is read
+        offset += transformMatrix*Vector3f(0, 0, m_sliceRangeStart*spacing.z());
+        size.z() = end - m_sliceRangeStart;
+    }
+    // Types which can be used directly from a memory mapped file
+    const std::map<std::string, DataType> mappableTypes = {
+        {"MET_SHORT", TYPE_INT16},
+        {"MET_USHORT", TYPE_UINT16},
+        {"MET_CHAR", TYPE_INT8},
+        {"MET_UCHAR", TYPE_UINT8},
+        {"MET_FLOAT", TYPE_FLOAT},
+    };
+    bool memoryMap = m_memoryMapping;
+    if(memoryMap && (isCompressed || mappableTypes.count(typeName) == 0 || !getMainDevice()->isHost())) {
+        reportWarning() << "Memory mapping can only be used for uncompressed " << typeName << " data with host as main device, "
+                           "reading " << rawFilename << " instead." << reportEnd();
+        memoryMap = false;
+    }
+    if(memoryMap) {
+        const DataType type = mappableTypes.at(typeName);
+        const std::size_t voxelSize = getSizeOfDataType(type, nrOfComponents);
+        auto data = mapRawData(rawFilename, voxels*voxelSize, firstVoxel*voxelSize, lastVoxel*voxelSize);
+        output = Image::create(size, type, nrOfComponents, data);
+    } else if(typeName == "MET_SHORT" || typeName == "MET_INT") {
         std::unique_ptr<short[]> data;
         if(typeName == "MET_SHORT") {
-            data = std::move(readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize));
+            data = std::move(readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel));
         } else {
             reportWarning() << "Converting original dataset of type MET_INT (32 bit) to short (16 bit) overflow may occur." << reportEnd();
-            auto tmp = readRawData<int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
-            auto tmp2 = make_uninitialized_unique<short[]>(voxels*nrOfComponents);
-            for(int i = 0; i < voxels*nrOfComponents; ++i)
+            auto tmp = readRawData<int>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel);
+            auto tmp2 = make_uninitialized_unique<short[]>((lastVoxel - firstVoxel)*nrOfComponents);
+            for(std::size_t i = 0; i < (lastVoxel - firstVoxel)*nrOfComponents; ++i)
                 tmp2[i] = (short)tmp[i];
 
             data = std::move(tmp2);
@@ -376,25 +456,25 @@ void MetaImageImporter::execute() {
     } else if(typeName == "MET_USHORT" || typeName == "MET_UINT") {
         std::unique_ptr<ushort[]> data;
         if(typeName == "MET_USHORT") {
-            data = std::move(readRawData<unsigned short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize));
+            data = std::move(readRawData<unsigned short>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel));
         } else {
             reportWarning() << "Converting original dataset of type MET_UINT (32 bit) to unsigned short (16 bit) overflow may occur." << reportEnd();
-            auto tmp = readRawData<unsigned int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
-            auto tmp2 = make_uninitialized_unique<ushort[]>(voxels*nrOfComponents);
-            for(int i = 0; i < voxels*nrOfComponents; ++i)
+            auto tmp = readRawData<unsigned int>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel);
+            auto tmp2 = make_uninitialized_unique<ushort[]>((lastVoxel - firstVoxel)*nrOfComponents);
+            for(std::size_t i = 0; i < (lastVoxel - firstVoxel)*nrOfComponents; ++i)
                 tmp2[i] = (unsigned short)tmp[i];
 
             data = std::move(tmp2);
         }
         output = Image::create(size,TYPE_UINT16,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_CHAR") {
-        auto data = readRawData<char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<char>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel);
         output = Image::create(size,TYPE_INT8,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_UCHAR") {
-        auto data = readRawData<unsigned char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<unsigned char>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel);
         output = Image::create(size,TYPE_UINT8,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_FLOAT") {
-        auto data = readRawData<float>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<float>(rawFilename, voxels, nrOfComponents, isCompressed, chunkOffsets, chunkSize, firstVoxel, lastVoxel);
         output = Image::create(size,TYPE_FLOAT,nrOfComponents,getMainDevice(),std::move(data));
     }
 
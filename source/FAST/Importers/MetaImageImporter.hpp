@@ -10,6 +10,8 @@ namespace fast {
  * This importer loads 2D and 3D images stored in the MetaImage format which are pairs of .mhd text files and .raw files
  * contain the raw pixel data.
  * It supports the compressed .zraw format as well using zlib.
+ * If the .mhd file has an index of independently compressed chunks, written by MetaImageExporter,
+ * the chunks are decompressed in parallel.
  * It also loads all meta data stored in the .mhd text file which can be retrived by Image::getMetaData
  *
  * @ingroup importers
@@ -18,9 +20,32 @@ class FAST_EXPORT  MetaImageImporter : public FileImporter {
     FAST_PROCESS_OBJECT(MetaImageImporter)
     public:
         FAST_CONSTRUCTOR(MetaImageImporter, std::string, filename,)
+        /**
+         * @brief Only read slices [start, end) of a 3D image
+         *
+         * For compressed images, only the needed part of the file is decompressed.
+         * The origin of the output image is moved to the first slice.
+         * @param start first slice
+         * @param end slice after the last slice. Clamped to the depth of the image.
+         */
+        void setSliceRange(int start, int end);
+        /**
+         * @brief Memory map the raw file instead of reading it into memory
+         *
+         * Pixel data is then only read from disk when it is accessed, and the image shares memory with the file
+         * cache of the operating system. The mapping is copy-on-write: writing to the image only copies the pages
+         * written to, and never changes the file. Only used for uncompressed data of types short, ushort, char, uchar
+         * and float, and when the main device is host. Default is false.
+         * @param memoryMapping
+         */
+        void setMemoryMapping(bool memoryMapping);
     private:
         MetaImageImporter();
         void execute();
+
+        int m_sliceRangeStart = -1;
+        int m_sliceRangeEnd = -1;
+        bool m_memoryMapping = false;
 };
 
 } // end namespace fast
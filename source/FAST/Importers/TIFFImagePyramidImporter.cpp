@@ -59,7 +59,7 @@ void TIFFImagePyramidImporter::execute() {
         levelData.height = height;
         levelData.tileWidth = tileWidth;
         levelData.tileHeight = tileHeight;
-        levelData.offset = 0;
+        levelData.offset = TIFFCurrentDirOffset(tiff);
         levelList.push_back(levelData);
 
         // Read SubIFD offsets
@@ -112,6 +112,7 @@ void TIFFImagePyramidImporter::execute() {
         }
     }
     auto image = ImagePyramid::create(tiff, levelList, (int)channels, isOMETiff);
+    image->setFilePath(m_filename);
     addOutputData(0, image);
 }
 
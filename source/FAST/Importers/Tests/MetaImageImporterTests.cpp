@@ -2,6 +2,8 @@
 #include "FAST/Importers/MetaImageImporter.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Exporters/MetaImageExporter.hpp"
+#include <cstring>
 
 using namespace fast;
 
@@ -103,3 +105,46 @@ TEST_CASE("Import MetaImage file to OpenCL device", "[fast][MetaImageImporter]")
     CHECK(image->getDataType() == TYPE_UINT8);
 }
 
+
+TEST_CASE("Import uncompressed MetaImage file with memory mapping", "[fast][MetaImageImporter]") {
+    const int width = 64;
+    const int height = 48;
+    const int depth = 40;
+    const int sliceSize = width*height;
+    std::vector<float> data(sliceSize*depth);
+    for(int i = 0; i < sliceSize*depth; ++i)
+        data[i] = (float)((i*7) % 1000);
+    auto exporter = MetaImageExporter::create("MetaImageImporterMemoryMapTest.mhd");
+    exporter->connect(Image::create(width, height, depth, TYPE_FLOAT, 1, data.data()));
+    exporter->run();
+
+    auto importer = MetaImageImporter::create("MetaImageImporterMemoryMapTest.mhd");
+    importer->setMemoryMapping(true);
+    auto image = importer->runAndGetOutputData<Image>();
+    REQUIRE(image->getDepth() == depth);
+    REQUIRE(image->getDataType() == TYPE_FLOAT);
+    {
+        auto access = image->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), data.data(), sliceSize*depth*sizeof(float)) == 0);
+    }
+
+    // Slice range which does not start at a page boundary
+    auto sliceImporter = MetaImageImporter::create("MetaImageImporterMemoryMapTest.mhd");
+    sliceImporter->setMemoryMapping(true);
+    sliceImporter->setSliceRange(13, 27);
+    auto slices = sliceImporter->runAndGetOutputData<Image>();
+    REQUIRE(slices->getDepth() == 14);
+    {
+        auto access = slices->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), &data[sliceSize*13], sliceSize*14*sizeof(float)) == 0);
+    }
+
+    // Writing to a memory mapped image must not change the file
+    {
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        std::memset(access->get(), 0, sliceSize*depth*sizeof(float));
+    }
+    auto image2 = MetaImageImporter::create("MetaImageImporterMemoryMapTest.mhd")->runAndGetOutputData<Image>();
+    auto access = image2->getImageAccess(ACCESS_READ);
+    CHECK(std::memcmp(access->get(), data.data(), sliceSize*depth*sizeof(float)) == 0);
+}
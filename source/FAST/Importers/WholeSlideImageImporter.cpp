@@ -280,6 +280,7 @@ void WholeSlideImageImporter::readVSI(std::string filename) {
     }
 
     auto image = ImagePyramid::create(stream, tiles, levelList, compressionFormat);
+    image->setFilePath(etsFilename);
 
     addOutputData(0, image);
 }
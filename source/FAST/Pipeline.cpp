@@ -516,7 +516,7 @@ DataObject::pointer Pipeline::getPipelineOutputData(std::string name, std::funct
             data = PO->runAndGetOutputData(port);
             if(progressFunction != nullptr) {
                 // Report progress
-                progressFunction(std::stof(data->getFrameData("progress")));
+                progressFunction(data->getFrameData<float>("progress"));
             }
         } while(!data->isLastFrame());
     }
@@ -543,7 +543,7 @@ std::map<std::string, DataObject::pointer> Pipeline::getAllPipelineOutputData(st
                 result[name] = PO->runAndGetOutputData(output.second, executeToken);
                 if(progressFunction != nullptr) {
                     // Report progress
-                    progressFunction(std::stof(result[name]->getFrameData("progress")));
+                    progressFunction(result[name]->getFrameData<float>("progress"));
                 }
             } while(!result[name]->isLastFrame());
         }
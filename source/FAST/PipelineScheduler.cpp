@@ -0,0 +1,206 @@
+#include "PipelineScheduler.hpp"
+#include <FAST/ProcessObject.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
+#include <cmath>
+
+namespace fast {
+
+PipelineScheduler::PipelineScheduler(std::vector<std::shared_ptr<ProcessObject>> processObjects, int threads) {
+    if(processObjects.empty())
+        throw Exception("No process objects given to PipelineScheduler");
+    m_sinks = processObjects;
+    m_pool = std::make_unique<ThreadPool>(threads);
+    buildGraph();
+}
+
+void PipelineScheduler::buildGraph() {
+    // Find all POs by traversing the input connections from the sinks
+    std::vector<std::shared_ptr<ProcessObject>> processObjects;
+    std::unordered_map<ProcessObject*, std::unordered_set<ProcessObject*>> parents;
+    std::unordered_set<ProcessObject*> visited;
+    std::vector<std::shared_ptr<ProcessObject>> stack = m_sinks;
+    while(!stack.empty()) {
+        auto po = stack.back();
+        stack.pop_back();
+        if(visited.count(po.get()) > 0)
+            continue;
+        visited.insert(po.get());
+        processObjects.push_back(po);
+        parents[po.get()];
+        for(auto&& input : po->mInputConnections) {
+            auto parent = input.second->getProcessObject();
+            parents[po.get()].insert(parent.get());
+            stack.push_back(parent);
+        }
+    }
+
+    // Topological sort using Kahn's algorithm
+    std::unordered_map<ProcessObject*, std::vector<ProcessObject*>> children;
+    std::unordered_map<ProcessObject*, int> inDegree;
+    std::unordered_map<ProcessObject*, std::shared_ptr<ProcessObject>> owners;
+    for(auto&& po : processObjects) {
+        owners[po.get()] = po;
+        inDegree[po.get()] = parents[po.get()].size();
+        for(auto parent : parents[po.get()])
+            children[parent].push_back(po.get());
+    }
+    std::queue<ProcessObject*> ready;
+    // Iterate in reverse discovery order to get sources first for deterministic ordering
+    for(auto it = processObjects.rbegin(); it != processObjects.rend(); ++it) {
+        if(inDegree[it->get()] == 0)
+            ready.push(it->get());
+    }
+    std::unordered_map<ProcessObject*, int> indices;
+    std::vector<Node> nodes;
+    while(!ready.empty()) {
+        auto po = ready.front();
+        ready.pop();
+        indices[po] = nodes.size();
+        Node node;
+        node.processObject = owners[po];
+        node.nrOfParents = parents[po].size();
+        node.statistics.name = po->getNameOfClass();
+        nodes.push_back(node);
+        for(auto child : children[po]) {
+            --inDegree[child];
+            if(inDegree[child] == 0)
+                ready.push(child);
+        }
+    }
+    if(nodes.size() != processObjects.size())
+        throw Exception("The pipeline given to PipelineScheduler contains a cycle");
+
+    for(auto&& node : nodes) {
+        for(auto child : children[node.processObject.get()])
+            node.children.push_back(indices[child]);
+        // Keep statistics from previous graph, if any
+        for(auto&& oldNode : m_nodes) {
+            if(oldNode.processObject == node.processObject)
+                node.statistics = oldNode.statistics;
+        }
+    }
+    m_nodes = std::move(nodes);
+}
+
+void PipelineScheduler::run(int64_t executeToken) {
+    // Connections may have changed since last run
+    buildGraph();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_remainingParents.resize(m_nodes.size());
+        for(int i = 0; i < m_nodes.size(); ++i)
+            m_remainingParents[i] = m_nodes[i].nrOfParents;
+        m_remainingNodes = m_nodes.size();
+        m_failed = false;
+        m_exception = nullptr;
+    }
+    for(int i = 0; i < m_nodes.size(); ++i) {
+        if(m_nodes[i].nrOfParents == 0)
+            m_pool->submit([this, i, executeToken]() { runNode(i, executeToken); });
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this]() { return m_remainingNodes == 0; });
+    m_wallTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if(m_exception)
+        std::rethrow_exception(m_exception);
+}
+
+void PipelineScheduler::runNode(int index, int64_t executeToken) {
+    auto& node = m_nodes[index];
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        failed = m_failed;
+    }
+    if(!failed) {
+        int queueDepth = 0;
+        for(auto&& input : node.processObject->mInputConnections)
+            queueDepth += input.second->getSize();
+        auto start = std::chrono::high_resolution_clock::now();
+        try {
+            node.processObject->updateWithoutParents(executeToken);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_failed) {
+                m_failed = true;
+                m_exception = std::current_exception();
+            }
+        }
+        auto runtime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        node.statistics.queueDepth = queueDepth;
+        node.statistics.maximumQueueDepth = std::max(node.statistics.maximumQueueDepth, queueDepth);
+        node.statistics.busyTime += runtime;
+        node.statistics.updates += 1;
+    }
+
+    // Schedule children which have all their parents done
+    std::vector<int> readyChildren;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(int child : node.children) {
+            --m_remainingParents[child];
+            if(m_remainingParents[child] == 0)
+                readyChildren.push_back(child);
+        }
+    }
+    for(int child : readyChildren)
+        m_pool->submit([this, child, executeToken]() { runNode(child, executeToken); });
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_remainingNodes;
+        if(m_remainingNodes == 0)
+            m_finished.notify_all();
+    }
+}
+
+std::vector<PipelineScheduler::NodeStatistics> PipelineScheduler::getStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<NodeStatistics> result;
+    for(auto&& node : m_nodes) {
+        auto statistics = node.statistics;
+        statistics.utilization = m_wallTime > 0 ? (float)(statistics.busyTime / m_wallTime) : 0.0f;
+        result.push_back(statistics);
+    }
+    return result;
+}
+
+std::string PipelineScheduler::getStatisticsString() {
+    std::stringstream ss;
+    for(auto&& statistics : getStatistics()) {
+        ss << statistics.name << ": utilization " << std::round(statistics.utilization*100.0f) << "%"
+           << ", busy " << statistics.busyTime << " ms"
+           << ", updates " << statistics.updates
+           << ", queue depth " << statistics.queueDepth << " (max " << statistics.maximumQueueDepth << ")\n";
+    }
+    return ss.str();
+}
+
+std::shared_ptr<ProcessObject> PipelineScheduler::getBottleneck() {
+    auto statistics = getStatistics();
+    int bottleneck = 0;
+    for(int i = 1; i < statistics.size(); ++i) {
+        if(statistics[i].utilization > statistics[bottleneck].utilization)
+            bottleneck = i;
+    }
+    return m_nodes.at(bottleneck).processObject;
+}
+
+void PipelineScheduler::resetStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto&& node : m_nodes)
+        node.statistics = NodeStatistics{node.processObject->getNameOfClass()};
+    m_wallTime = 0;
+}
+
+int PipelineScheduler::getNumberOfThreads() const {
+    return m_pool->getNumberOfThreads();
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/ThreadPool.hpp>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+namespace fast {
+
+class ProcessObject;
+
+/**
+ * @brief Runs a pipeline with multiple threads
+ *
+ * ProcessObject::update recursively updates every parent and executes all process objects (POs) on the calling thread.
+ * This scheduler is an opt-in alternative: It sorts the graph of POs, given by their input connections,
+ * topologically and executes each PO as soon as all its parents are done on a work-stealing ThreadPool.
+ * Independent branches of a pipeline, e.g. two neural networks fed by the same PatchGenerator,
+ * will thus execute concurrently.
+ * The execute token and execute on last frame only semantics are the same as for ProcessObject::update.
+ *
+ * Example:
+ * @code
+ * auto scheduler = PipelineScheduler::create({segmentationNetwork, classificationNetwork});
+ * int executeToken = 0;
+ * do {
+ *     scheduler->run(executeToken++);
+ *     ...
+ * } while(!done);
+ * std::cout << scheduler->getStatisticsString() << std::endl;
+ * @endcode
+ */
+class FAST_EXPORT PipelineScheduler : public Object {
+    FAST_OBJECT_V4(PipelineScheduler)
+    public:
+        /**
+         * @brief Create a pipeline scheduler
+         * @param processObjects The last POs (sinks) of the pipeline. All parents of these POs will be scheduled as well.
+         * @param threads Number of threads to use. If <= 0, the number of hardware threads is used.
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(PipelineScheduler,
+                         std::vector<std::shared_ptr<ProcessObject>>, processObjects,,
+                         int, threads, = -1
+        )
+        /**
+         * @brief Update all POs of the pipeline once. Blocks until all POs are done.
+         *
+         * If any PO throws an exception, no more POs are started, and the first exception is rethrown
+         * when all running POs have finished.
+         *
+         * @param executeToken Negative value means that the execute token is disabled.
+         */
+        void run(int64_t executeToken = -1);
+        /**
+         * @brief Statistics for a single process object (node) in the pipeline
+         */
+        struct NodeStatistics {
+            std::string name;
+            /**
+             * Number of frames waiting in the input data channels of this PO the last time it was scheduled
+             */
+            int queueDepth = 0;
+            int maximumQueueDepth = 0;
+            uint64_t updates = 0;
+            /**
+             * Total time in milliseconds spent updating this PO
+             */
+            double busyTime = 0;
+            /**
+             * Fraction of the wall time of all calls to run() this PO was busy (0.0-1.0).
+             * The PO with the highest utilization is the bottleneck of the pipeline.
+             */
+            float utilization = 0;
+        };
+        /**
+         * @brief Get statistics for each PO in the pipeline, in topological order
+         */
+        std::vector<NodeStatistics> getStatistics();
+        std::string getStatisticsString();
+        /**
+         * @brief Get the PO with the highest utilization
+         */
+        std::shared_ptr<ProcessObject> getBottleneck();
+        void resetStatistics();
+        int getNumberOfThreads() const;
+        ~PipelineScheduler() override = default;
+    private:
+        struct Node {
+            std::shared_ptr<ProcessObject> processObject;
+            std::vector<int> children;
+            int nrOfParents = 0;
+            NodeStatistics statistics;
+        };
+        /**
+         * Create nodes from the graph of POs, sorted topologically
+         */
+        void buildGraph();
+        void runNode(int index, int64_t executeToken);
+
+        std::vector<std::shared_ptr<ProcessObject>> m_sinks;
+        std::vector<Node> m_nodes;
+        std::unique_ptr<ThreadPool> m_pool;
+
+        // State for the current call to run()
+        std::vector<int> m_remainingParents;
+        int m_remainingNodes = 0;
+        bool m_failed = false;
+        std::exception_ptr m_exception;
+        std::mutex m_mutex;
+        std::condition_variable m_finished;
+
+        double m_wallTime = 0;
+};
+
+}
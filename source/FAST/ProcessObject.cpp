@@ -4,6 +4,7 @@
 #include "FAST/Streamers/Streamer.hpp"
 #include <unordered_set>
 #include <FAST/DataChannels/QueuedDataChannel.hpp>
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
 #include <FAST/DataChannels/NewestFrameDataChannel.hpp>
 #include <FAST/DataChannels/StaticDataChannel.hpp>
 
@@ -24,14 +25,19 @@ static bool isStreamer(ProcessObject* po) {
     return isStreamer;
 }
 
-void ProcessObject::update(int executeToken) {
+void ProcessObject::update(int64_t executeToken) {
     // Call update on all parents
+    for(auto parent : mInputConnections)
+        parent.second->getProcessObject()->update(executeToken);
+
+    updateWithoutParents(executeToken);
+}
+
+void ProcessObject::updateWithoutParents(int64_t executeToken) {
     bool newInputData = false;
     bool inputMarkedAsLastFrame = false;
     for(auto parent : mInputConnections) {
         auto port = parent.second;
-        port->getProcessObject()->update(executeToken);
-
         if(mLastProcessed.count(parent.first) > 0) {
             // Compare the last processed data with the new data for this data port
             std::pair<DataObject::pointer, uint64_t> data = mLastProcessed[parent.first];
@@ -133,9 +139,17 @@ DataChannel::pointer ProcessObject::getOutputPort(uint portID) {
     // Create DataChannel, and it to list and return it
     DataChannel::pointer dataChannel;
     if(isStreamer(this)) {
-        auto streamingMode = std::dynamic_pointer_cast<Streamer>(mPtr.lock())->getStreamingMode();
+        auto streamer = std::dynamic_pointer_cast<Streamer>(mPtr.lock());
+        auto streamingMode = streamer->getStreamingMode();
         if(streamingMode == StreamingMode::ProcessAllFrames) {
-            dataChannel = QueuedDataChannel::New();
+            if(streamer->getLockFreeDataChannel()) {
+                // Streamers have a single thread producing data, and each channel has a single consumer
+                auto ringBuffer = RingBufferDataChannel::New();
+                ringBuffer->setSingleProducerSingleConsumer(true);
+                dataChannel = ringBuffer;
+            } else {
+                dataChannel = QueuedDataChannel::New();
+            }
             if(m_maximumNrOfFrames > 0)
                 dataChannel->setMaximumNumberOfFrames(m_maximumNrOfFrames);
         } else if(streamingMode == StreamingMode::NewestFrameOnly) {
@@ -187,8 +201,7 @@ void ProcessObject::addOutputData(uint portID, DataObject::pointer data, bool pr
         }
     }
     if(propagateFrameData)
-        for(auto&& frameData : m_frameData)
-            data->setFrameData(frameData.first, frameData.second);
+        data->addFrameData(m_frameData);
 
     // Add to current data for this port
     mOutputPorts[portID].currentData = data;
@@ -437,7 +450,7 @@ std::shared_ptr<ProcessObject> ProcessObject::connect(uint inputPortID, std::sha
     return std::static_pointer_cast<ProcessObject>(mPtr.lock());
 }
 
-int ProcessObject::getLastExecuteToken() const {
+int64_t ProcessObject::getLastExecuteToken() const {
     return m_lastExecuteToken;
 }
 
@@ -19,6 +19,7 @@ namespace fast {
 
 class OpenCLProgram;
 class ProcessObject;
+class PipelineScheduler;
 
 /**
  * @defgroup segmentation Segmentation
@@ -76,9 +77,12 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
          * duplicate execution for the same frames when using streaming.
          * Increment the token for every timestep with a positive value.
          *
+         * All POs are executed on the calling thread. Use PipelineScheduler to
+         * execute independent branches of the pipeline concurrently.
+         *
          * @param executeToken Negative value means that the execute token is disabled.
          */
-        void update(int executeToken = -1);
+        void update(int64_t executeToken = -1);
         typedef std::shared_ptr<ProcessObject> pointer;
 
         // Runtime stuff
@@ -151,7 +155,7 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
         std::shared_ptr<ProcessObject> connect(uint inputPortID, std::shared_ptr<ProcessObject> parentProcessObject, uint outputPortID = 0);
         std::shared_ptr<ProcessObject> connect(std::shared_ptr<DataObject> inputDataObject);
         std::shared_ptr<ProcessObject> connect(uint inputPortID, std::shared_ptr<DataObject> inputDataObject);
-        int getLastExecuteToken() const;
+        int64_t getLastExecuteToken() const;
         /**
          * If set to true, this will only trigger this PO to execute if one of its inputs is marked as being "last frame".
          * This is useful if one want to export the results of a PatchStitcher, but only when it is complete.
@@ -179,7 +183,17 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
         bool mIsModified;
 
         // An integer id which act as a token of when this PO last executed
-        int m_lastExecuteToken = -1;
+        int64_t m_lastExecuteToken = -1;
+
+        /**
+         * @brief Execute this PO if needed, assuming all parents have already been updated.
+         *
+         * This is the non-recursive part of update(), used by PipelineScheduler
+         * to run each PO of a pipeline as a separate task.
+         *
+         * @param executeToken Negative value means that the execute token is disabled.
+         */
+        void updateWithoutParents(int64_t executeToken = -1);
 
         // Pure virtual method for executing the pipeline object
         virtual void execute()=0;
@@ -244,7 +258,7 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::unordered_map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
@@ -253,6 +267,7 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
 
         std::mutex m_mutex;
 
+        friend class PipelineScheduler;
 };
 
 template<class DataType>
@@ -282,8 +297,7 @@ std::shared_ptr<DataType> ProcessObject::getInputData(uint portID) {
     // Store frame data for this input data so it can be added to output data later
     for(auto&& lastFrame : data->getLastFrame())
         m_lastFrame.insert(lastFrame);
-    for(auto&& frameData : data->getFrameData())
-        m_frameData[frameData.first] = frameData.second;
+    m_frameData.merge(data->getFrameDataContainer());
 
     return convertedData;
 }
@@ -115,3 +115,35 @@ def test_tensor_array_interface_exceptions():
     #data = np.ndarray((16,0,1), dtype=np.float32)
     #with pytest.raises(ValueError):
     #    fast.Tensor.createFromArray(data)
+
+
+def test_image_array_zero_copy():
+    data = np.zeros((37, 64), dtype=np.uint8)
+    image = fast.Image.createFromArray(data)
+    copied_image = fast.Image.createFromArray(data, copy=True)
+    # Image uses memory of the array
+    data[1, 2] = 42
+    assert np.asarray(image)[1, 2, 0] == 42
+    assert np.asarray(copied_image)[1, 2, 0] == 0
+
+    # Array view keeps data alive after image is deleted
+    view = np.asarray(image)
+    del image
+    del data
+    assert view[1, 2, 0] == 42
+
+    # Read-only arrays are copied
+    data = np.ones((37, 64), dtype=np.float32)
+    data.setflags(write=False)
+    image = fast.Image.createFromArray(data)
+    assert np.array_equal(np.asarray(image)[..., 0], data)
+
+
+def test_tensor_array_zero_copy():
+    data = np.zeros((2, 3, 4), dtype=np.float32)
+    tensor = fast.Tensor.createFromArray(data)
+    data[1, 2, 3] = 1.5
+    assert np.asarray(tensor)[1, 2, 3] == 1.5
+    view = np.asarray(tensor)
+    del tensor
+    assert view[1, 2, 3] == 1.5
@@ -0,0 +1,55 @@
+import fast
+import numpy as np
+import os
+import pytest
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+# Benchmarks are slow and use a lot of memory, thus they are only run when FAST_BENCHMARK is set
+benchmark = pytest.mark.skipif(not os.environ.get('FAST_BENCHMARK'), reason='Benchmark, set FAST_BENCHMARK=1 to run')
+
+
+def smooth(data):
+    image = fast.Image.createFromArray(data)
+    smoothing = fast.GaussianSmoothing.create(2.0, 9).connect(image)
+    smoothing.setMainDevice(fast.Host.getInstance())
+    return np.asarray(smoothing.runAndGetOutputData())
+
+
+@benchmark
+def test_pipelines_run_in_parallel_python_threads():
+    """Benchmark of FAST pipelines run from multiple Python threads.
+    The wrapped C++ calls release the GIL, thus the pipelines should run in parallel."""
+    frames = [np.random.rand(64, 256, 256).astype(np.float32) for i in range(8)]
+
+    start = time.perf_counter()
+    sequential = [smooth(frame) for frame in frames]
+    sequential_time = time.perf_counter() - start
+
+    start = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        threaded = list(executor.map(smooth, frames))
+    threaded_time = time.perf_counter() - start
+    print('Sequential: {:.3f} s, 4 Python threads: {:.3f} s, speedup: {:.2f}'.format(
+        sequential_time, threaded_time, sequential_time/threaded_time))
+
+    for a, b in zip(sequential, threaded):
+        assert np.allclose(a, b)
+
+
+@benchmark
+def test_create_from_array_zero_copy_benchmark():
+    data = np.random.rand(256, 512, 512).astype(np.float32)
+
+    start = time.perf_counter()
+    for i in range(10):
+        fast.Image.createFromArray(data, copy=True)
+    copy_time = (time.perf_counter() - start)/10
+
+    start = time.perf_counter()
+    for i in range(10):
+        image = fast.Image.createFromArray(data)
+        view = np.asarray(image)
+    zero_copy_time = (time.perf_counter() - start)/10
+    print('createFromArray of 256 MB, copy: {:.2f} ms, zero-copy: {:.2f} ms'.format(copy_time*1000, zero_copy_time*1000))
+    assert np.shares_memory(view, data)
@@ -3,10 +3,107 @@
 #include "FileStreamer.hpp"
 #include <fstream>
 #include <chrono>
+#include <map>
+#include "FAST/ThreadPool.hpp"
 #include "FAST/Data/Image.hpp" // TODO should not be here
 
 namespace fast {
 
+namespace {
+typedef std::pair<int, int> FrameKey; // Sequence and frame number
+
+// Reads frames ahead of playback in parallel, and keeps frames in memory for looping within a memory budget
+class FileReadAhead {
+    public:
+        typedef std::function<DataObject::pointer(FrameKey)> ReadFunction;
+        // Change key to the frame after it, returns false if there is no next frame
+        typedef std::function<bool(FrameKey&)> NextFunction;
+        FileReadAhead(ReadFunction read, NextFunction next, int frames, int threads, std::size_t cacheSize) :
+                m_read(std::move(read)), m_next(std::move(next)), m_frames(frames), m_cacheSize(cacheSize) {
+            if(m_frames > 0) {
+                if(threads <= 0)
+                    threads = std::min(m_frames, std::max(1, (int)std::thread::hardware_concurrency()));
+                m_pool = std::make_unique<ThreadPool>(threads);
+            }
+        }
+        // Get frame, this blocks until it has been read
+        DataObject::pointer getFrame(FrameKey key) {
+            auto cached = m_cache.find(key);
+            if(cached != m_cache.end()) {
+                readAhead(key);
+                return copyImage(cached->second);
+            }
+            if(!m_pool) {
+                auto frame = m_read(key);
+                store(key, frame);
+                return frame;
+            }
+            std::future<DataObject::pointer> future;
+            auto buffered = m_buffer.find(key);
+            if(buffered != m_buffer.end()) {
+                future = std::move(buffered->second);
+                m_buffer.erase(buffered);
+            } else {
+                // Playback jumped to a frame which is not read yet
+                future = submit(key);
+            }
+            readAhead(key);
+            auto frame = future.get(); // Rethrows any exception from reading, e.g. FileNotFoundException
+            store(key, frame);
+            return frame;
+        }
+    private:
+        std::future<DataObject::pointer> submit(FrameKey key) {
+            auto read = m_read;
+            return m_pool->submit([read, key]() { return read(key); });
+        }
+        // Start reading the frames after key, and discard frames read ahead which are no longer needed
+        void readAhead(FrameKey key) {
+            if(!m_pool)
+                return;
+            std::map<FrameKey, std::future<DataObject::pointer>> window;
+            for(int i = 0; i < m_frames && m_next(key); ++i) {
+                if(m_cache.count(key) > 0 || window.count(key) > 0)
+                    continue;
+                auto buffered = m_buffer.find(key);
+                window[key] = buffered != m_buffer.end() ? std::move(buffered->second) : submit(key);
+            }
+            m_buffer = std::move(window);
+        }
+        // The cache keeps its own copy of the frame, as the emitted frame may be modified by consumers
+        void store(FrameKey key, const DataObject::pointer& frame) {
+            auto image = std::dynamic_pointer_cast<Image>(frame);
+            if(!image) // Size of other data types is unknown
+                return;
+            const std::size_t size = (std::size_t)image->getNrOfVoxels()*getSizeOfDataType(image->getDataType(), image->getNrOfChannels());
+            if(m_cacheBytes + size > m_cacheSize)
+                return;
+            m_cache[key] = copyImage(image);
+            m_cacheBytes += size;
+        }
+        // A cached frame is emitted as a new object each time. Process objects only execute when the input object
+        // is new, and a consumer writing to, or setting the timestamp of, a frame must not change the cached frame.
+        static Image::pointer copyImage(const Image::pointer& image) {
+            auto copy = image->copy(Host::getInstance());
+            copy->getSceneGraphNode()->setTransform(image->getSceneGraphNode()->getTransform()->get());
+            copy->setCreationTimestamp(image->getCreationTimestamp());
+            copy->setMetadata(image->getMetadata());
+            copy->setFrameDataContainer(image->getFrameDataContainer());
+            return copy;
+        }
+
+        ReadFunction m_read;
+        NextFunction m_next;
+        int m_frames;
+        std::size_t m_cacheSize;
+        std::size_t m_cacheBytes = 0;
+        std::map<FrameKey, Image::pointer> m_cache;
+        std::map<FrameKey, std::future<DataObject::pointer>> m_buffer;
+        // Declared last, so that the pool, which finishes all tasks, is destroyed first
+        std::unique_ptr<ThreadPool> m_pool;
+};
+}
+
 void FileStreamer::loadAttributes() {
     setFilenameFormats(getStringListAttribute("fileformat"));
     if (getBooleanAttribute("loop")) {
@@ -103,8 +200,6 @@ void FileStreamer::generateStream() {
 
     // Read timestamp file if available
     std::ifstream timestampFile;
-    uint64_t previousTimestamp = 0;
-    auto previousTimestampTime = std::chrono::high_resolution_clock::time_point::min();
     if(!mTimestampFilename.empty() && mUseTimestamp) {
         timestampFile.open(mTimestampFilename.c_str());
         if(!timestampFile.is_open()) {
@@ -129,7 +224,43 @@ void FileStreamer::generateStream() {
 
     int replays = 0;
     int currentSequence = 0;
-    auto previousTime = std::chrono::high_resolution_clock::now();
+    // Frames are kept for reuse only if the stream will be played again
+    const std::size_t cacheSize = m_loop || mNrOfReplays > 0 ? (std::size_t)m_loopCacheSize*1024*1024 : 0;
+    FileReadAhead reader(
+            [this](FrameKey key) {
+                std::string filename = getFilename(mStartNumber + key.second*mStepSize, key.first);
+                reportInfo() << "Filestreamer reading " << filename << reportEnd();
+                return getDataFrame(filename);
+            },
+            [this](FrameKey& key) {
+                uint64_t i = mStartNumber + (key.second + 1)*mStepSize;
+                if((mMaximumNrOfFrames <= 0 || i < (uint64_t)mMaximumNrOfFrames) && fileExists(getFilename(i, key.first))) {
+                    key.second++;
+                    return true;
+                }
+                // Only wrap around when looping a single sequence, as sequences are switched at the end of stream
+                if(m_loop && mFilenameFormats.size() == 1 && key.second > 0) {
+                    key.second = 0;
+                    return true;
+                }
+                return false;
+            },
+            m_readAheadFrames, m_readerThreads, cacheSize);
+
+    // Frames are scheduled relative to a reference time, so that time spent reading frames does not add up
+    typedef std::chrono::high_resolution_clock Clock;
+    Clock::time_point referenceTime;
+    uint64_t referenceTimestamp = 0;
+    int64_t framesSinceReference = 0;
+    bool scheduleStarted = false;
+    int previousFrameNr = -1;
+    // Sleep until the given time. If playback has fallen far behind, e.g. after a stall, returns false to restart the schedule.
+    auto waitUntil = [](Clock::time_point time) {
+        if(Clock::now() - time > std::chrono::seconds(1))
+            return false;
+        std::this_thread::sleep_until(time);
+        return true;
+    };
     while(true) {
         bool pause = getPause();
         if(pause)
@@ -147,19 +278,30 @@ void FileStreamer::generateStream() {
         int frameNr = getCurrentFrameIndex();
         uint64_t i = mStartNumber + frameNr*mStepSize;
 
-        std::string filename = getFilename(i, currentSequence);
         try {
-            reportInfo() << "Filestreamer reading " << filename << reportEnd();
-            DataObject::pointer dataFrame = getDataFrame(filename);
+            DataObject::pointer dataFrame = reader.getFrame(FrameKey(currentSequence, frameNr));
 
             // Timing
             if(!pause) {
+                // Start a new schedule when playback jumps, e.g. when seeking or looping
+                if(frameNr != previousFrameNr + 1)
+                    scheduleStarted = false;
                 if(m_framerate > 0) {
-                    std::chrono::duration<float, std::milli> passedTime = std::chrono::high_resolution_clock::now() - previousTime;
-                    std::chrono::duration<int, std::milli> sleepFor(1000 / m_framerate - (int)passedTime.count());
-                    if(sleepFor.count() > 0)
-                        std::this_thread::sleep_for(sleepFor);
-                    previousTime = std::chrono::high_resolution_clock::now();
+                    if(!scheduleStarted) {
+                        if(framesSinceReference > 0) {
+                            // Keep one frame interval to the previous frame, e.g. when looping
+                            referenceTime += std::chrono::microseconds((framesSinceReference - 1)*1000000/m_framerate);
+                            framesSinceReference = 1;
+                        } else {
+                            referenceTime = Clock::now();
+                        }
+                        scheduleStarted = true;
+                    }
+                    if(!waitUntil(referenceTime + std::chrono::microseconds(framesSinceReference*1000000/m_framerate))) {
+                        referenceTime = Clock::now();
+                        framesSinceReference = 0;
+                    }
+                    ++framesSinceReference;
                 } else if(!mTimestampFilename.empty() && mUseTimestamp) {
                     // Set and use timestamp if available
                     std::string line;
@@ -169,26 +311,23 @@ void FileStreamer::generateStream() {
                         dataFrame->setCreationTimestamp(timestamp);
                     }
                 } else if(dataFrame->getCreationTimestamp() != 0 && mUseTimestamp) {
+                    // Wait until the time of this frame relative to the first frame
                     uint64_t timestamp = dataFrame->getCreationTimestamp();
-                    // Wait as long as necessary before adding image
-                    // Time passed since last frame
-                    auto timePassed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            std::chrono::high_resolution_clock::now() - previousTimestampTime);
-                    while (timestamp > previousTimestamp + timePassed.count()) {
-                        // Wait
-                        int64_t left = (timestamp - previousTimestamp) - timePassed.count();
-                        reportInfo() << "Sleeping for " << left << " ms" << reportEnd();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(left));
-                        timePassed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                std::chrono::high_resolution_clock::now() - previousTimestampTime);
+                    if(!scheduleStarted || timestamp < referenceTimestamp) {
+                        referenceTime = Clock::now();
+                        referenceTimestamp = timestamp;
+                        scheduleStarted = true;
+                    }
+                    if(!waitUntil(referenceTime + std::chrono::milliseconds(timestamp - referenceTimestamp))) {
+                        referenceTime = Clock::now();
+                        referenceTimestamp = timestamp;
                     }
-                    previousTimestamp = timestamp;
-                    previousTimestampTime = std::chrono::high_resolution_clock::now();
                 }
                 // End timing
 
                 getCurrentFrameIndexAndUpdate(); // Update index
             }
+            previousFrameNr = pause ? -2 : frameNr;
 
             if(!fileExists(getFilename(i+mStepSize, currentSequence)) && !m_loop)
                 dataFrame->setLastFrame(getNameOfClass());
@@ -211,8 +350,7 @@ void FileStreamer::generateStream() {
                    (mNrOfReplays > 0 && replays != mNrOfReplays) ||
                    (currentSequence < mFilenameFormats.size()-1)) {
                     // Restart stream
-                    previousTimestamp = 0;
-                    previousTimestampTime = std::chrono::high_resolution_clock::time_point::min();
+                    scheduleStarted = false;
                     if(timestampFile.is_open()) {
                         timestampFile.seekg(0); // reset file to start
                     }
@@ -284,4 +422,20 @@ void FileStreamer::setUseTimestamp(bool use) {
     mUseTimestamp = use;
 }
 
+void FileStreamer::setReadAheadFrames(int frames) {
+    m_readAheadFrames = frames;
+}
+
+int FileStreamer::getReadAheadFrames() const {
+    return m_readAheadFrames;
+}
+
+void FileStreamer::setNumberOfReaderThreads(int threads) {
+    m_readerThreads = threads;
+}
+
+void FileStreamer::setLoopCacheSize(uint megabytes) {
+    m_loopCacheSize = megabytes;
+}
+
 } // end namespace fast
@@ -39,6 +39,32 @@ class FAST_EXPORT FileStreamer : public RandomAccessStreamer {
          * @param use
          */
         void setUseTimestamp(bool use);
+        /**
+         * @brief Set number of frames to read ahead of playback
+         *
+         * Frames after the current frame are read in parallel on a pool of reader threads,
+         * and are still output in order. Set to 0 to read each frame when it is needed.
+         * Default is 4.
+         *
+         * @param frames
+         */
+        void setReadAheadFrames(int frames);
+        int getReadAheadFrames() const;
+        /**
+         * @brief Set number of threads used to read frames ahead of playback
+         *
+         * @param threads If <= 0, the number of hardware threads is used, but at most one thread per read-ahead frame.
+         */
+        void setNumberOfReaderThreads(int threads);
+        /**
+         * @brief Set how much memory can be used to keep frames for looping
+         *
+         * When looping or replaying, frames are kept in memory as long as the total size is within this limit,
+         * so that they don't have to be read from disk again. Set to 0 to disable. Default is 256 MB.
+         *
+         * @param megabytes
+         */
+        void setLoopCacheSize(uint megabytes);
 
         ~FileStreamer();
 
@@ -61,6 +87,9 @@ class FAST_EXPORT FileStreamer : public RandomAccessStreamer {
         uint mStepSize;
 
         bool mUseTimestamp = true;
+        int m_readAheadFrames = 4;
+        int m_readerThreads = -1;
+        uint m_loopCacheSize = 256;
 
         std::vector<std::string> mFilenameFormats;
         std::string mTimestampFilename;
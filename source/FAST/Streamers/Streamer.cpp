@@ -60,6 +60,14 @@ void Streamer::setStreamingMode(StreamingMode mode) {
     m_streamingMode = mode;
 }
 
+void Streamer::setLockFreeDataChannel(bool lockFree) {
+    m_lockFreeDataChannel = lockFree;
+}
+
+bool Streamer::getLockFreeDataChannel() const {
+    return m_lockFreeDataChannel;
+}
+
 DataChannel::pointer Streamer::getOutputPort(uint portID) {
     if(m_outputPOs.count(portID) == 0) {
         auto channel = ProcessObject::getOutputPort(portID);
@@ -55,6 +55,15 @@ class FAST_EXPORT Streamer : public ProcessObject {
         void setStreamingMode(StreamingMode mode);
         StreamingMode getStreamingMode() const;
 
+        /**
+         * @brief Use the lock-free RingBufferDataChannel on the output ports of this streamer.
+         * Only has an effect when streaming mode is ProcessAllFrames.
+         * Must be set before any output ports are created.
+         * @param lockFree
+         */
+        void setLockFreeDataChannel(bool lockFree);
+        bool getLockFreeDataChannel() const;
+
         virtual DataChannel::pointer getOutputPort(uint portID = 0) override;
     protected:
         /**
@@ -81,6 +90,7 @@ class FAST_EXPORT Streamer : public ProcessObject {
         bool m_streamIsStarted = false;
         bool m_stop = false;
         StreamingMode m_streamingMode = StreamingMode::ProcessAllFrames;
+        bool m_lockFreeDataChannel = false;
 
         std::mutex m_firstFrameMutex;
         std::mutex m_stopMutex;
@@ -4,6 +4,10 @@
 #include "FAST/Streamers/ImageFileStreamer.hpp"
 #include "FAST/Tests/DummyObjects.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Exporters/MetaImageExporter.hpp"
+#include "FAST/DataStream.hpp"
+#include "FAST/Algorithms/Lambda/RunLambda.hpp"
+#include <chrono>
 
 using namespace fast;
 
@@ -17,3 +21,67 @@ TEST_CASE("No hash tag in filename format given to ImageFileStreamer", "[fast][I
     CHECK_THROWS(mhdStreamer->setFilenameFormat("asd"));
 }
 
+TEST_CASE("ImageFileStreamer with read-ahead outputs frames in order at framerate", "[fast][ImageFileStreamer]") {
+    const int frames = 20;
+    for(int frame = 0; frame < frames; ++frame) {
+        auto image = Image::create(64, 64, TYPE_UINT8, 1);
+        image->fill(frame);
+        auto exporter = MetaImageExporter::create("ImageFileStreamerReadAheadTest_" + std::to_string(frame) + ".mhd", true);
+        exporter->connect(image);
+        exporter->run();
+    }
+
+    for(int readAhead : {0, 4}) {
+        auto streamer = ImageFileStreamer::create("ImageFileStreamerReadAheadTest_#.mhd", false, false, 50);
+        streamer->setReadAheadFrames(readAhead);
+        streamer->setNumberOfReaderThreads(2);
+        auto start = std::chrono::high_resolution_clock::now();
+        auto stream = DataStream(streamer);
+        int frame = 0;
+        while(!stream.isDone()) {
+            auto image = stream.getNextFrame<Image>();
+            auto access = image->getImageAccess(ACCESS_READ);
+            CHECK(access->getScalar(Vector2i(0, 0)) == frame);
+            ++frame;
+        }
+        CHECK(frame == frames);
+        // Frames are paced at 50 FPS
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        CHECK(seconds >= (frames - 1)/50.0 - 0.01);
+    }
+}
+
+TEST_CASE("Looping ImageFileStreamer gives a new frame downstream every time", "[fast][ImageFileStreamer]") {
+    for(int frames : {1, 3}) {
+        INFO("Frames: " << frames);
+        for(int frame = 0; frame < frames; ++frame) {
+            auto image = Image::create(64, 64, TYPE_UINT8, 1);
+            image->fill(frame);
+            auto exporter = MetaImageExporter::create("ImageFileStreamerLoopTest" + std::to_string(frames) + "_" + std::to_string(frame) + ".mhd");
+            exporter->connect(image);
+            exporter->run();
+        }
+
+        auto streamer = ImageFileStreamer::create("ImageFileStreamerLoopTest" + std::to_string(frames) + "_#.mhd", true, false, 100);
+        int executed = 0;
+        std::vector<int> values;
+        auto consumer = RunLambda::create([&](DataObject::pointer data) {
+            ++executed;
+            // Consumer modifies the frame, this must not change frames emitted later
+            auto access = std::static_pointer_cast<Image>(data)->getImageAccess(ACCESS_READ_WRITE);
+            values.push_back((int)access->getScalar(Vector2i(0, 0)));
+            access->setScalar(Vector2i(0, 0), 255);
+            return DataList(data);
+        })->connect(streamer);
+        auto port = consumer->getOutputPort();
+        const int emissions = 3*frames + 2;
+        for(int i = 0; i < emissions; ++i) {
+            consumer->run(i);
+            port->getNextFrame<Image>();
+        }
+        CHECK(executed == emissions);
+        REQUIRE(values.size() == emissions);
+        for(int i = 0; i < emissions; ++i)
+            CHECK(values[i] == i % frames);
+    }
+}
@@ -0,0 +1,118 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Streamers/UFFStreamer.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/DataStream.hpp"
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#define H5_BUILT_AS_DYNAMIC_LIB
+#include <H5Cpp.h>
+
+using namespace fast;
+
+static void writeStringAttribute(H5::H5Object& object, const std::string& name, const std::string& value) {
+    H5::StrType type(H5::PredType::C_S1, value.size());
+    auto attribute = object.createAttribute(name, type, H5::DataSpace(H5S_SCALAR));
+    attribute.write(type, value);
+}
+
+/**
+ * Write a small UFF file with scan converted grayscale data, and return the expected image of each frame.
+ * UFF stores each frame column major, i.e. the value of pixel (x, y) is at index y + x*height.
+ * If not readable, the frame data set is stored with a compound type which can't be read as pixels.
+ */
+static std::vector<std::vector<uchar>> writeUFF(const std::string& filename, int frames, int width, int height, bool readable = true) {
+    H5::H5File file(filename, H5F_ACC_TRUNC);
+    auto group = file.createGroup("b_data");
+    writeStringAttribute(group, "class", "uff.beamformed_data");
+    auto scanGroup = file.createGroup("b_data/scan");
+    writeStringAttribute(scanGroup, "class", "uff.linear_scan");
+    auto writeAxis = [&scanGroup](const std::string& name, int size) {
+        std::vector<float> axis(size);
+        for(int i = 0; i < size; ++i)
+            axis[i] = i*0.0005f;
+        hsize_t dims[2] = {1, (hsize_t)size};
+        auto dataset = scanGroup.createDataSet(name, H5::PredType::NATIVE_FLOAT, H5::DataSpace(2, dims));
+        dataset.write(axis.data(), H5::PredType::NATIVE_FLOAT);
+    };
+    writeAxis("x_axis", width);
+    writeAxis("z_axis", height);
+
+    std::vector<uchar> data((std::size_t)frames*width*height);
+    std::vector<std::vector<uchar>> expected(frames, std::vector<uchar>(width*height));
+    for(int frame = 0; frame < frames; ++frame) {
+        for(int y = 0; y < height; ++y) {
+            for(int x = 0; x < width; ++x) {
+                const uchar value = frame*20 + (x + y*width) % 20;
+                data[(std::size_t)frame*width*height + y + x*height] = value;
+                expected[frame][x + y*width] = value;
+            }
+        }
+    }
+    hsize_t dims[2] = {(hsize_t)frames, (hsize_t)(width*height)};
+    if(!readable) {
+        H5::CompType type(sizeof(int));
+        type.insertMember("value", 0, H5::PredType::NATIVE_INT);
+        group.createDataSet("data", type, H5::DataSpace(2, dims));
+        return expected;
+    }
+    auto dataset = group.createDataSet("data", H5::PredType::NATIVE_UCHAR, H5::DataSpace(2, dims));
+    dataset.write(data.data(), H5::PredType::NATIVE_UCHAR);
+    return expected;
+}
+
+static bool isEqual(Image::pointer image, const std::vector<uchar>& expected) {
+    auto access = image->getImageAccess(ACCESS_READ);
+    return std::memcmp(access->get(), expected.data(), expected.size()) == 0;
+}
+
+TEST_CASE("UFFStreamer reading frames when needed gives same frames as loading all frames", "[fast][UFFStreamer]") {
+    const int frames = 10;
+    const int width = 16;
+    const int height = 12;
+    const std::string filename = "UFFStreamerTest.uff";
+    // Expected frames, as they were when the entire file was loaded up front
+    const auto expected = writeUFF(filename, frames, width, height);
+
+    // Prefetching all frames corresponds to loading the entire file
+    for(int prefetchFrames : {1, 3, frames}) {
+        INFO("Prefetch frames: " << prefetchFrames);
+        auto streamer = UFFStreamer::create(filename, false, 0, 10, 60, 1024, 1024, false);
+        streamer->setPrefetchFrames(prefetchFrames);
+        REQUIRE(streamer->getNrOfFrames() == frames);
+        auto stream = DataStream(streamer);
+        int frame = 0;
+        while(!stream.isDone()) {
+            auto image = stream.getNextFrame<Image>();
+            REQUIRE(frame < frames);
+            REQUIRE(image->getWidth() == width);
+            REQUIRE(image->getHeight() == height);
+            CHECK(isEqual(image, expected[frame]));
+            ++frame;
+        }
+        CHECK(frame == frames);
+
+        // Seek backwards, outside the prefetched frames, and then forwards.
+        // The streamer is paused after the last frame, and outputs a single frame after each seek.
+        for(int seekFrame : {2, 7}) {
+            INFO("Seek to frame: " << seekFrame);
+            // Let the streamer reach the pause after the previous frame
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            streamer->setCurrentFrameIndex(seekFrame);
+            auto image = stream.getNextFrame<Image>();
+            CHECK(isEqual(image, expected[seekFrame]));
+        }
+    }
+}
+
+TEST_CASE("UFFStreamer stops the stream with an error when frames can not be read", "[fast][UFFStreamer]") {
+    const std::string filename = "UFFStreamerUnreadableTest.uff";
+    writeUFF(filename, 4, 16, 12, false);
+
+    auto streamer = UFFStreamer::create(filename, false, 0, 10, 60, 1024, 1024, false);
+    // File attributes can be read, but not the frames
+    REQUIRE(streamer->getNrOfFrames() == 4);
+    auto stream = DataStream(streamer);
+    CHECK_THROWS(stream.getNextFrame<Image>());
+}
@@ -6,6 +6,8 @@
 #include <H5Cpp.h>
 #include <FAST/Algorithms/Ultrasound/ScanConverter.hpp>
 #include <FAST/Algorithms/Ultrasound/EnvelopeAndLogCompressor.hpp>
+#include <map>
+#include <exception>
 
 namespace fast {
 
@@ -29,15 +31,14 @@ public:
     bool isScanConverted;
     std::string dataGroupName;
     int numFrames;
+    int numDimensions;
     bool polarCoordinates;
-    std::vector<Image::pointer> dataScanconverted;
-    std::vector<Image::pointer> iqData;
 
     std::vector<float> azimuth_axis;
     std::vector<float> depth_axis;
 
     bool hasGrayscaleData() {
-        return !dataScanconverted.empty();
+        return isScanConverted;
     }
 };
 
@@ -48,6 +49,10 @@ class UFFReader {
         void close();
         std::string findHDF5BeamformedDataGroupName();
         std::shared_ptr<UFFData> getUFFData();
+        /**
+         * Read a range of consecutive frames with a single hyperslab read
+         */
+        std::vector<Image::pointer> readFrames(std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames);
 
     private:
         H5::H5File mFile;
@@ -55,9 +60,9 @@ class UFFReader {
         void getImageSize(H5::Group scanGroup, std::shared_ptr<UFFData> dataStruct);
         void getSpacing(H5::Group scanGroup, std::shared_ptr<UFFData> dataStruct);
         H5::Group getDataGroupAndIsScanconverted(std::shared_ptr<UFFData> dataStruct);
-        void readData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct);
-        void readNotScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct);
-        void readScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct);
+        void getFrameCount(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct);
+        std::vector<Image::pointer> readNotScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames);
+        std::vector<Image::pointer> readScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames);
 };
 
 //Operator function to be used with H5Literate
@@ -117,7 +122,7 @@ std::shared_ptr<UFFData> UFFReader::getUFFData() {
     H5::Group dataGroup = getDataGroupAndIsScanconverted(retVal);
     getSpacing(scanGroup, retVal);
 
-    readData(dataGroup, retVal);
+    getFrameCount(dataGroup, retVal);
 
     return retVal;
 }
@@ -224,29 +229,43 @@ H5::Group UFFReader::getDataGroupAndIsScanconverted(std::shared_ptr<UFFData> dat
     return dataGroup;
 }
 
-void UFFReader::readData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct) {
+void UFFReader::getFrameCount(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct) {
+    auto dataset = dataGroup.openDataSet(dataStruct->isScanConverted ? "data" : "imag");
+    auto dataspace = dataset.getSpace();
+    const int ndims = dataspace.getSimpleExtentNdims();
+    if(ndims != 4 && ndims != 2) {
+        throw Exception("Exepected 4 or 2 dimensions in UFF file, got " + std::to_string(ndims));
+    }
+    hsize_t dims_out[4];
+    dataspace.getSimpleExtentDims(dims_out, NULL);
+
+    dataStruct->numFrames = dims_out[0];
+    dataStruct->numDimensions = ndims;
+    Reporter::info() << "Number of frames in UFF file: " << dataStruct->numFrames << Reporter::end();
+}
 
+std::vector<Image::pointer> UFFReader::readFrames(std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames) {
+    H5::Group dataGroup = mFile.openGroup(dataStruct->dataGroupName);
     if(dataStruct->isScanConverted)
-        readScanconvertedData(dataGroup, dataStruct);
+        return readScanconvertedData(dataGroup, dataStruct, firstFrame, frames);
     else
-        readNotScanconvertedData(dataGroup, dataStruct);
+        return readNotScanconvertedData(dataGroup, dataStruct, firstFrame, frames);
 }
 
-
-void UFFReader::readNotScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct) {
-    auto dataset = dataGroup.openDataSet("imag");
-    auto dataspace = dataset.getSpace();
-    hsize_t dims_out[4];
-    int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
-
-    if(ndims != 4 && ndims != 2) {
-        throw Exception("Exepected 4 or 2 dimensions in UFF file, got " + std::to_string(ndims));
+// Hyperslab selecting frames [firstFrame, firstFrame+frames) in a 4D or 2D UFF dataset
+static void getFrameHyperslab(std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames, std::vector<hsize_t>& count, std::vector<hsize_t>& blockSize, std::vector<hsize_t>& offset) {
+    if(dataStruct->numDimensions == 4) {
+        count = { 1, 1, 1, 1 }; // how many blocks to extract
+        blockSize = { hsize_t(frames), 1, 1, hsize_t(dataStruct->width * dataStruct->height) }; // block
+        offset = { hsize_t(firstFrame), 0, 0, 0 };   // hyperslab offset in the file
+    } else {
+        count = { 1, 1 }; // how many blocks to extract
+        blockSize = { hsize_t(frames), hsize_t(dataStruct->width * dataStruct->height) }; // block
+        offset = { hsize_t(firstFrame), 0 };   // hyperslab offset in the file
     }
+}
 
-    int frameCount = dims_out[0];
-    Reporter::info() << "Number of frames in UFF file: " << frameCount << Reporter::end();
-    dataStruct->numFrames = frameCount;//TODO
-
+std::vector<Image::pointer> UFFReader::readNotScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames) {
     auto imagDataset = dataGroup.openDataSet("imag");
     auto imagDataspace = imagDataset.getSpace();
     auto realDataset = dataGroup.openDataSet("real");
@@ -255,105 +274,218 @@ void UFFReader::readNotScanconvertedData(H5::Group dataGroup, std::shared_ptr<UF
     std::vector<hsize_t> count;
     std::vector<hsize_t> blockSize;
     std::vector<hsize_t> offset;
-    if(ndims == 4) {
-        count = { 1, 1, 1, 1 }; // how many blocks to extract
-        blockSize = { 1, 1, 1, hsize_t(dataStruct->width * dataStruct->height) }; // block
-        offset = { 0, 0, 0, 0 };   // hyperslab offset in the file
-    } else {
-        count = { 1, 1 }; // how many blocks to extract
-        blockSize = { 1, hsize_t(dataStruct->width * dataStruct->height) }; // block
-        offset = { 0, 0 };   // hyperslab offset in the file
-    }
-
-    H5::DataSpace memspace(ndims, blockSize.data());
-
-    //dataStruct.dataNotScanconverted.resize(frameCount);//Make room for pointers in vector
-    dataStruct->iqData.resize(frameCount);//Make room for pointers in vector
-
-    for(int frameNr = 0; frameNr < frameCount; ++frameNr) {
-        //std::cout << "Extracting frame " << frameNr << " in UFF file" << std::endl;
-        // Extract 1 frame
-        auto imaginary = std::make_unique<float[]>(dataStruct->width * dataStruct->height);
-        auto real = std::make_unique<float[]>(dataStruct->width * dataStruct->height);
-        offset[0] = frameNr;
-        imagDataspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data(), NULL, blockSize.data());
-        imagDataset.read(imaginary.get(), H5::PredType::NATIVE_FLOAT, memspace, imagDataspace);
-        realDataspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data(), NULL, blockSize.data());
-        realDataset.read(real.get(), H5::PredType::NATIVE_FLOAT, memspace, realDataspace);
-
-        int dataSize = dataStruct->width * dataStruct->height;
+    getFrameHyperslab(dataStruct, firstFrame, frames, count, blockSize, offset);
+    H5::DataSpace memspace(dataStruct->numDimensions, blockSize.data());
+
+    const int dataSize = dataStruct->width * dataStruct->height;
+    auto imaginary = make_uninitialized_unique<float[]>((std::size_t)dataSize*frames);
+    auto real = make_uninitialized_unique<float[]>((std::size_t)dataSize*frames);
+    imagDataspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data(), NULL, blockSize.data());
+    imagDataset.read(imaginary.get(), H5::PredType::NATIVE_FLOAT, memspace, imagDataspace);
+    realDataspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data(), NULL, blockSize.data());
+    realDataset.read(real.get(), H5::PredType::NATIVE_FLOAT, memspace, realDataspace);
+
+    std::vector<Image::pointer> result;
+    for(int frame = 0; frame < frames; ++frame) {
+        const float* frameReal = &real[(std::size_t)frame*dataSize];
+        const float* frameImaginary = &imaginary[(std::size_t)frame*dataSize];
         auto complex_image = make_uninitialized_unique<float[]>(dataSize*2);
 
         for(int y = 0; y < dataStruct->height; ++y) {
             for(int x = 0; x < dataStruct->width; ++x) {
                 int pos = x + y * dataStruct->width;
                 int pos2 = y + x * dataStruct->height;
-                complex_image[pos*2] = real[pos2];
-                complex_image[pos*2+1] = imaginary[pos2];
+                complex_image[pos*2] = frameReal[pos2];
+                complex_image[pos*2+1] = frameImaginary[pos2];
             }
         }
         auto image = Image::create(dataStruct->width, dataStruct->height, TYPE_FLOAT, 2, std::move(complex_image));
-        if(frameNr == frameCount-1)
+        if(firstFrame + frame == dataStruct->numFrames-1)
             image->setLastFrame("UFFStreamer");
-        dataStruct->iqData[frameNr] = image;
-    }//for
+        result.push_back(image);
+    }
+    return result;
 }
 
-void UFFReader::readScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct) {
+std::vector<Image::pointer> UFFReader::readScanconvertedData(H5::Group dataGroup, std::shared_ptr<UFFData> dataStruct, int firstFrame, int frames) {
     auto dataset = dataGroup.openDataSet("data");
     auto dataspace = dataset.getSpace();
-    hsize_t dims_out[4];
-    int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
-
-    if(ndims != 4 && ndims != 2) {
-        throw Exception("Exepected 4 or 2 dimensions in UFF file, got " + std::to_string(ndims));
-    }
-
-    int frameCount = dims_out[0];
-    Reporter::info() << "Number of frames in UFF file: " << frameCount << Reporter::end();
-
-    dataStruct->numFrames = frameCount;
 
     std::vector<hsize_t> count;
     std::vector<hsize_t> blockSize;
     std::vector<hsize_t> offset;
-    if(ndims == 4) {
-        count = { 1, 1, 1, 1 }; // how many blocks to extract
-        blockSize = { 1, 1, 1, hsize_t(dataStruct->width * dataStruct->height) }; // block
-        offset = { 0, 0, 0, 0 };   // hyperslab offset in the file
-    } else {
-        count = { 1, 1 }; // how many blocks to extract
-        blockSize = { 1, hsize_t(dataStruct->width * dataStruct->height) }; // block
-        offset = { 0, 0 };   // hyperslab offset in the file
-    }
-
-    H5::DataSpace memspace(4, blockSize.data());
+    getFrameHyperslab(dataStruct, firstFrame, frames, count, blockSize, offset);
+    H5::DataSpace memspace(dataStruct->numDimensions, blockSize.data());
 
-    dataStruct->dataScanconverted.resize(frameCount);//Make room for pointers in vector
+    const int dataSize = dataStruct->width * dataStruct->height;
+    auto data = make_uninitialized_unique<unsigned char[]>((std::size_t)dataSize*frames);
+    dataspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data(), NULL, blockSize.data());
+    dataset.read(data.get(), H5::PredType::NATIVE_UCHAR, memspace, dataspace);
 
-    for (int frameNr = 0; frameNr < frameCount; ++frameNr) {
-        //std::cout << "Extracting frame " << frameNr << " in UFF file" << std::endl;
-        // Extract 1 frame
-        auto data = std::make_unique<unsigned char[]>(dataStruct->width * dataStruct->height);
-        offset[0] = frameNr;
-        dataspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data(), NULL, blockSize.data());
-        dataset.read(data.get(), H5::PredType::NATIVE_UCHAR, memspace, dataspace);
-
-        int dataSize = dataStruct->width * dataStruct->height;
+    std::vector<Image::pointer> result;
+    for(int frame = 0; frame < frames; ++frame) {
+        const unsigned char* frameData = &data[(std::size_t)frame*dataSize];
         auto image_data = make_uninitialized_unique<uchar[]>(dataSize);
         for (int y = 0; y < dataStruct->height; ++y) {
             for (int x = 0; x < dataStruct->width; ++x) {
                 //TODO: Should axes be swapped?
                 int pos = y + x * dataStruct->height;
-                image_data[x + y * dataStruct->width] = data[pos];
+                image_data[x + y * dataStruct->width] = frameData[pos];
             }
         }
         auto image = Image::create(dataStruct->width, dataStruct->height, TYPE_UINT8, 1, std::move(image_data));
         image->setSpacing(dataStruct->spacing.x(), dataStruct->spacing.y(), dataStruct->spacing.z());
-        if(frameNr == frameCount-1)
+        if(firstFrame + frame == dataStruct->numFrames-1)
             image->setLastFrame("UFFStreamer");
-        dataStruct->dataScanconverted[frameNr] = image;
-    }//for
+        result.push_back(image);
+    }
+    return result;
+}
+
+/**
+ * Reads frames from a UFF file in a background thread.
+ * Frames from the current playback position and a given number of frames ahead are kept in memory.
+ */
+class UFFFrameReader {
+    public:
+        UFFFrameReader(std::shared_ptr<UFFReader> reader, std::shared_ptr<UFFData> data, int prefetchFrames);
+        ~UFFFrameReader();
+        /**
+         * Move playback position to the given frame and get it. Blocks until the frame is read.
+         */
+        Image::pointer getFrame(int frameNr, bool loop);
+        /**
+         * Move playback position, so that the prefetch thread starts reading from this frame
+         */
+        void seek(int frameNr, bool loop);
+    private:
+        void prefetch();
+        bool isInWindow(int frameNr) const;
+        // Remove frames outside the window. m_mutex must be locked.
+        void evict();
+        // Max number of frames to read with a single hyperslab read
+        static constexpr int m_framesPerRead = 4;
+        std::shared_ptr<UFFReader> m_reader;
+        std::shared_ptr<UFFData> m_data;
+        const int m_prefetchFrames;
+        std::map<int, Image::pointer> m_frames;
+        int m_position = 0;
+        bool m_loop = false;
+        bool m_stop = false;
+        std::exception_ptr m_error;
+        std::mutex m_mutex;
+        std::condition_variable m_frameRead;
+        std::condition_variable m_positionChanged;
+        std::thread m_thread;
+};
+
+UFFFrameReader::UFFFrameReader(std::shared_ptr<UFFReader> reader, std::shared_ptr<UFFData> data, int prefetchFrames) :
+        m_reader(reader), m_data(data), m_prefetchFrames(std::max(1, prefetchFrames)) {
+    m_thread = std::thread(&UFFFrameReader::prefetch, this);
+}
+
+UFFFrameReader::~UFFFrameReader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_positionChanged.notify_all();
+    m_frameRead.notify_all();
+    m_thread.join();
+}
+
+bool UFFFrameReader::isInWindow(int frameNr) const {
+    int distance = frameNr - m_position;
+    if(distance < 0 && m_loop)
+        distance += m_data->numFrames;
+    return distance >= 0 && distance < m_prefetchFrames;
+}
+
+void UFFFrameReader::evict() {
+    for(auto it = m_frames.begin(); it != m_frames.end();) {
+        if(isInWindow(it->first)) {
+            ++it;
+        } else {
+            it = m_frames.erase(it);
+        }
+    }
+}
+
+void UFFFrameReader::seek(int frameNr, bool loop) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_position = frameNr;
+        m_loop = loop;
+        evict();
+    }
+    m_positionChanged.notify_all();
+}
+
+Image::pointer UFFFrameReader::getFrame(int frameNr, bool loop) {
+    if(frameNr < 0 || frameNr >= m_data->numFrames)
+        throw Exception("Frame " + std::to_string(frameNr) + " is out of range in UFF file");
+    seek(frameNr, loop);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_frameRead.wait(lock, [this, frameNr]() { return m_frames.count(frameNr) > 0 || m_error || m_stop; });
+    if(m_error)
+        std::rethrow_exception(m_error);
+    if(m_stop)
+        throw ThreadStopped();
+    return m_frames[frameNr];
+}
+
+void UFFFrameReader::prefetch() {
+    while(true) {
+        int firstFrame = -1;
+        int frames = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // Find first frame in window which is not read yet
+            m_positionChanged.wait(lock, [this, &firstFrame]() {
+                if(m_stop || m_error)
+                    return true;
+                for(int i = 0; i < m_prefetchFrames; ++i) {
+                    int frameNr = m_position + i;
+                    if(frameNr >= m_data->numFrames) {
+                        if(!m_loop)
+                            break;
+                        frameNr -= m_data->numFrames;
+                    }
+                    if(m_frames.count(frameNr) == 0) {
+                        firstFrame = frameNr;
+                        return true;
+                    }
+                }
+                return false;
+            });
+            if(m_stop || m_error)
+                break;
+            // Read consecutive missing frames in the window together
+            while(frames < m_framesPerRead && firstFrame + frames < m_data->numFrames &&
+                    isInWindow(firstFrame + frames) && m_frames.count(firstFrame + frames) == 0)
+                ++frames;
+        }
+        try {
+            auto images = m_reader->readFrames(m_data, firstFrame, frames);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // Playback position may have moved while reading
+                for(int i = 0; i < frames; ++i) {
+                    if(isInWindow(firstFrame + i))
+                        m_frames[firstFrame + i] = images[i];
+                }
+            }
+        } catch(H5::Exception &e) {
+            // HDF5 exceptions are not std::exceptions, convert them so that the streamer can report them
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::make_exception_ptr(Exception("Failed to read frame " + std::to_string(firstFrame) +
+                    " from UFF file: " + e.getDetailMsg()));
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::current_exception();
+        }
+        m_frameRead.notify_all();
+    }
 }
 
 void UFFStreamer::load() {
@@ -364,13 +496,18 @@ void UFFStreamer::load() {
     if(!fileExists(m_filename))
         throw FileNotFoundException(m_filename);
 
-    auto uffReader = UFFReader();
-    uffReader.open(m_filename);
-    m_uffData = uffReader.getUFFData();
+    auto uffReader = std::make_shared<UFFReader>();
+    uffReader->open(m_filename);
+    m_uffData = uffReader->getUFFData();
+    // Frames are read when needed, and the file is kept open by the frame reader
+    m_frameReader = std::make_shared<UFFFrameReader>(uffReader, m_uffData, m_prefetchFrames);
 }
 
 void UFFStreamer::execute() {
     if(!m_streamIsStarted) {
+        // Envelope detection and scan conversion run on the same device as the streamer
+        m_envelopeAndLogCompressor->setMainDevice(getMainDevice());
+        m_scanConverter->setMainDevice(getMainDevice());
         load();
         m_streamIsStarted = true;
         m_thread = std::make_unique<std::thread>(std::bind(&UFFStreamer::generateStream, this));
@@ -430,103 +567,132 @@ void UFFStreamer::generateStream() {
         m_currentFrameIndex = 0;
     }
 
-    while (true){
-        bool pause = getPause();
-        if(pause)
-            waitForUnpause();
-        pause = getPause();
-
-        {
-            std::lock_guard<std::mutex> lock(m_stopMutex);
-            if(m_stop) break;
-        }
-
-        int frameNr = getCurrentFrameIndex();
-
-        // DO SCAN CONVERSION ETC.
-        float startRadius = m_uffData->depth_axis.front();
-        float stopRadius = m_uffData->depth_axis.back();
-        float startTheta = m_uffData->azimuth_axis.front();
-        float stopTheta = m_uffData->azimuth_axis.back();
+    try {
+        while (true){
+            bool pause = getPause();
+            if(pause)
+                waitForUnpause();
+            pause = getPause();
+
+            {
+                std::lock_guard<std::mutex> lock(m_stopMutex);
+                if(m_stop) break;
+            }
 
-        Image::pointer image ;
-        if(m_uffData->hasGrayscaleData()) {
-            image = m_uffData->dataScanconverted[frameNr];
-        } else {
-            image = m_uffData->iqData[frameNr];
-        }
-        image->updateModifiedTimestamp();
-
-        float startX, startY, stopX, stopY, notUsed;
-        if(m_uffData->polarCoordinates) {
-            pol2cart(startRadius, startTheta, startY, notUsed);
-            pol2cart(stopRadius, startTheta, notUsed, startX);
-            pol2cart(stopRadius, 0, stopY, notUsed);
-            pol2cart(stopRadius, stopTheta, notUsed, stopX);
-            image->setFrameData("isPolar", "true");
-        } else {
-            startX = startTheta;
-            stopX = stopTheta;
-            startY = startRadius;
-            stopY = stopRadius;
-            image->setFrameData("isPolar", "false");
-        }
+            int frameNr = getCurrentFrameIndex();
 
-        float newXSpacing = (stopX - startX) / (m_scanConverter->getWidth() - 1); //Subtract 1 because num spaces is 1 less than num elements
-        float newYSpacing = (stopY - startY) / (m_scanConverter->getHeight() - 1);
+            // DO SCAN CONVERSION ETC.
+            float startRadius = m_uffData->depth_axis.front();
+            float stopRadius = m_uffData->depth_axis.back();
+            float startTheta = m_uffData->azimuth_axis.front();
+            float stopTheta = m_uffData->azimuth_axis.back();
 
-        image->setFrameData("startRadius", std::to_string(startRadius));
-        image->setFrameData("stopRadius", std::to_string(stopRadius));
-        image->setFrameData("startTheta", std::to_string(startTheta));
-        image->setFrameData("stopTheta", std::to_string(stopTheta));
+            Image::pointer image = m_frameReader->getFrame(frameNr, getLooping());
+            image->updateModifiedTimestamp();
 
-        Image::pointer resultImage;
-        if(m_doScanConversion) {
-            // Do scan conversion
-            if(m_uffData->hasGrayscaleData()) {
-                m_scanConverter->connect(image);
+            float startX, startY, stopX, stopY, notUsed;
+            if(m_uffData->polarCoordinates) {
+                pol2cart(startRadius, startTheta, startY, notUsed);
+                pol2cart(stopRadius, startTheta, notUsed, startX);
+                pol2cart(stopRadius, 0, stopY, notUsed);
+                pol2cart(stopRadius, stopTheta, notUsed, stopX);
+                image->setFrameData("isPolar", "true");
             } else {
-                // We must perform envelope and log compression
-                m_envelopeAndLogCompressor->connect(image);
+                startX = startTheta;
+                stopX = stopTheta;
+                startY = startRadius;
+                stopY = stopRadius;
+                image->setFrameData("isPolar", "false");
             }
-            resultImage = m_scanConverter->runAndGetOutputData<Image>();
-        } else {
-            // Skip scan conversion
-            if(m_uffData->hasGrayscaleData()) {
-                //resultImage = image;
-                // This is a hack to make UFFStreamer work with InterleavePlayback
-                resultImage = image->copy(getMainDevice());
-                resultImage->setFrameData(image->getFrameData());
-                if(image->isLastFrame())
-                    resultImage->setLastFrame("UFFStreamer");
+
+            float newXSpacing = (stopX - startX) / (m_scanConverter->getWidth() - 1); //Subtract 1 because num spaces is 1 less than num elements
+            float newYSpacing = (stopY - startY) / (m_scanConverter->getHeight() - 1);
+
+            image->setFrameData("startRadius", startRadius);
+            image->setFrameData("stopRadius", stopRadius);
+            image->setFrameData("startTheta", startTheta);
+            image->setFrameData("stopTheta", stopTheta);
+
+            Image::pointer resultImage;
+            if(m_doScanConversion) {
+                // Do scan conversion
+                if(m_uffData->hasGrayscaleData()) {
+                    m_scanConverter->connect(image);
+                } else {
+                    // We must perform envelope and log compression
+                    m_envelopeAndLogCompressor->connect(image);
+                }
+                resultImage = m_scanConverter->runAndGetOutputData<Image>();
             } else {
-                // We must perform envelope and log compression
-                m_envelopeAndLogCompressor->connect(image);
-                resultImage = m_envelopeAndLogCompressor->runAndGetOutputData<Image>();
+                // Skip scan conversion
+                if(m_uffData->hasGrayscaleData()) {
+                    //resultImage = image;
+                    // This is a hack to make UFFStreamer work with InterleavePlayback
+                    resultImage = image->copy(getMainDevice());
+                    resultImage->setFrameDataContainer(image->getFrameDataContainer());
+                    if(image->isLastFrame())
+                        resultImage->setLastFrame("UFFStreamer");
+                } else {
+                    // We must perform envelope and log compression
+                    m_envelopeAndLogCompressor->connect(image);
+                    resultImage = m_envelopeAndLogCompressor->runAndGetOutputData<Image>();
+                }
             }
-        }
 
-        if(!pause) {
-            std::chrono::duration<float, std::milli> passedTime = std::chrono::high_resolution_clock::now() - previousTime;
-            if(m_framerate > 0) {
-                std::chrono::duration<int, std::milli> sleepFor(1000 / m_framerate - (int)passedTime.count());
-                if(sleepFor.count() > 0)
-                    std::this_thread::sleep_for(sleepFor);
+            if(!pause) {
+                std::chrono::duration<float, std::milli> passedTime = std::chrono::high_resolution_clock::now() - previousTime;
+                if(m_framerate > 0) {
+                    std::chrono::duration<int, std::milli> sleepFor(1000 / m_framerate - (int)passedTime.count());
+                    if(sleepFor.count() > 0)
+                        std::this_thread::sleep_for(sleepFor);
+                }
+                previousTime = std::chrono::high_resolution_clock::now();
+                getCurrentFrameIndexAndUpdate(); // Update
+            }
+            try {
+                addOutputData(0, resultImage);
+                frameAdded();
+            } catch(ThreadStopped & e) {
+                break;
             }
-            previousTime = std::chrono::high_resolution_clock::now();
-            getCurrentFrameIndexAndUpdate(); // Update
         }
-        try {
-            addOutputData(0, resultImage);
-            frameAdded();
-        } catch(ThreadStopped & e) {
-            break;
+    } catch(ThreadStopped &e) {
+        // Frame reader was stopped
+    } catch(std::exception &e) {
+        // Frames are read in this thread, e.g. a truncated file. Stop pipeline, and propagate error message.
+        reportError() << "Error in UFFStreamer: " << e.what() << reportEnd();
+        for(auto item : mOutputConnections) {
+            for(auto output : item.second) {
+                output.lock()->stop(e.what());
+            }
         }
+        frameAdded(); // To unlock if happens before first frame
     }
 }
 
 UFFStreamer::~UFFStreamer() {
 	stop();
+	// Stop prefetch thread
+	m_frameReader.reset();
+}
+
+void UFFStreamer::setCurrentFrameIndex(int index) {
+    RandomAccessStreamer::setCurrentFrameIndex(index);
+    // Start reading the new frame immediately
+    if(m_frameReader && index >= 0 && index < m_uffData->numFrames)
+        m_frameReader->seek(index, getLooping());
+}
+
+void UFFStreamer::setPrefetchFrames(int frames) {
+    if(frames < 1)
+        throw Exception("Number of frames to prefetch in UFFStreamer must be at least 1");
+    if(m_frameReader)
+        throw Exception("Number of frames to prefetch in UFFStreamer must be set before the file is loaded");
+    m_prefetchFrames = frames;
+}
+
+int UFFStreamer::getPrefetchFrames() const {
+    return m_prefetchFrames;
 }
 
 int UFFStreamer::getNrOfFrames() {
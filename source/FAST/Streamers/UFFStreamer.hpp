@@ -9,12 +9,15 @@ namespace fast {
 class ScanConverter;
 class EnvelopeAndLogCompressor;
 class UFFData;
+class UFFFrameReader;
 
 /**
  * @brief Stream ultrasound file format (UFF) data
  *
  * A streamer for reading data stored in the ultrasound file format (UFF)
  * which is essentially and HDF5 file with ultrasound image/beam data.
+ * Frames are read from the file when needed, one or a few frames at a time.
+ * A background thread reads frames ahead of the current playback position, see setPrefetchFrames.
  *
  * There is GUI tool called the 'UFFviewer' which uses the UFF streamer,
  * enabling you to load and play with UFF data without programming.
@@ -71,6 +74,14 @@ class FAST_EXPORT UFFStreamer : public RandomAccessStreamer {
          * @brief Set name of which HDF5 group to stream.
          */
         void setName(std::string name);
+        /**
+         * @brief Set number of frames, starting at the current frame, to read ahead of playback and keep in memory.
+         * Must be set before the file is loaded. Default is 8.
+         * @param frames
+         */
+        void setPrefetchFrames(int frames);
+        int getPrefetchFrames() const;
+        void setCurrentFrameIndex(int index) override;
         void loadAttributes() override;
         ~UFFStreamer();
 
@@ -81,6 +92,8 @@ class FAST_EXPORT UFFStreamer : public RandomAccessStreamer {
         std::string m_filename;
         std::string m_name;
         std::shared_ptr<UFFData> m_uffData;
+        std::shared_ptr<UFFFrameReader> m_frameReader;
+        int m_prefetchFrames = 8;
         float m_dynamicRange = 60;
         float m_gain = 10;
         bool m_doScanConversion = true;
@@ -0,0 +1,71 @@
+#include <FAST/Testing.hpp>
+#include <FAST/PipelineScheduler.hpp>
+#include "DummyObjects.hpp"
+
+using namespace fast;
+
+TEST_CASE("Pipeline scheduler with two branches from one streamer", "[fast][PipelineScheduler]") {
+    const int frames = 20;
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(frames);
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamer->getOutputPort());
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(streamer->getOutputPort());
+
+    auto port1 = po1->getOutputPort();
+    auto port2 = po2->getOutputPort();
+
+    auto scheduler = PipelineScheduler::create({po1, po2}, 2);
+    CHECK(scheduler->getNumberOfThreads() == 2);
+    int executeToken = 0;
+    bool lastFrame = false;
+    while(!lastFrame) {
+        scheduler->run(executeToken);
+        auto data1 = port1->getNextFrame<DummyDataObject>();
+        auto data2 = port2->getNextFrame<DummyDataObject>();
+        CHECK(data1->getID() == executeToken);
+        CHECK(data2->getID() == executeToken);
+        lastFrame = data1->isLastFrame();
+        CHECK(data2->isLastFrame() == lastFrame);
+        ++executeToken;
+    }
+    CHECK(executeToken == frames);
+
+    auto statistics = scheduler->getStatistics();
+    // Streamer, its output PO and the two dummy POs
+    CHECK(statistics.size() == 4);
+    CHECK(statistics.back().updates == frames);
+    CHECK(scheduler->getBottleneck() != nullptr);
+}
+
+TEST_CASE("Pipeline scheduler with diamond shaped pipeline", "[fast][PipelineScheduler]") {
+    auto importer = DummyImporter::New();
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(importer->getOutputPort());
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(importer->getOutputPort());
+    auto po3 = DummyProcessObject2::New();
+    po3->setInputConnection(0, po1->getOutputPort());
+    po3->setInputConnection(1, po2->getOutputPort());
+
+    auto port = po3->getOutputPort();
+    auto scheduler = PipelineScheduler::create({po3});
+    scheduler->run();
+    auto data = port->getNextFrame<DummyDataObject>();
+    CHECK(data->getID() == 0);
+    CHECK(po3->getStaticDataID() == 0);
+    CHECK(scheduler->getStatistics().size() == 4);
+    CHECK(scheduler->getStatistics().front().name == "DummyImporter");
+}
+
+TEST_CASE("Pipeline scheduler rethrows exceptions", "[fast][PipelineScheduler]") {
+    // Required input connection is missing
+    auto po = DummyProcessObject::New();
+    po->setIsModified();
+    auto scheduler = PipelineScheduler::create({po});
+    CHECK_THROWS(scheduler->run());
+}
@@ -0,0 +1,116 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace fast {
+
+// Which pool and worker the current thread belongs to, if any
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int threads) {
+    if(threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    for(int i = 0; i < threads; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+    for(int i = 0; i < threads; ++i)
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_taskAvailable.notify_all();
+    for(auto& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    int index;
+    if(currentPool == this) {
+        index = currentWorker;
+    } else {
+        index = (int)(m_nextWorker++ % m_workers.size());
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queued;
+        ++m_unfinished;
+    }
+    m_taskAvailable.notify_one();
+}
+
+bool ThreadPool::popTask(int workerIndex, std::function<void()>& task) {
+    // First check own queue, newest task first for cache locality
+    {
+        auto& worker = *m_workers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if(!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+    // Then try to steal the oldest task from other workers
+    const int size = m_workers.size();
+    for(int i = 1; i < size; ++i) {
+        auto& victim = *m_workers[(workerIndex + i) % size];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int workerIndex) {
+    currentPool = this;
+    currentWorker = workerIndex;
+    while(true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAvailable.wait(lock, [this]() { return m_stop || m_queued > 0; });
+            if(m_stop && m_queued == 0)
+                break;
+            // Reserve a task, so that other workers don't search for it
+            --m_queued;
+        }
+        while(!popTask(workerIndex, task)) // Task is in another queue which is currently being pushed to
+            std::this_thread::yield();
+        task(); // packaged_task stores any exceptions in the future
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_unfinished;
+            if(m_unfinished == 0)
+                m_allFinished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_allFinished.wait(lock, [this]() { return m_unfinished == 0; });
+}
+
+int ThreadPool::getNumberOfThreads() const {
+    return m_threads.size();
+}
+
+int ThreadPool::getNumberOfQueuedTasks() const {
+    return m_queued;
+}
+
+ThreadPool& ThreadPool::getGlobal() {
+    static ThreadPool pool;
+    return pool;
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "FASTExport.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fast {
+
+/**
+ * @brief A work-stealing thread pool
+ *
+ * Every worker thread has its own task queue. Tasks submitted from a worker thread are put in the queue of that
+ * worker, while tasks submitted from other threads are distributed round-robin. When a worker runs out of tasks
+ * it will try to steal tasks from the other workers.
+ */
+class FAST_EXPORT ThreadPool {
+    public:
+        /**
+         * @brief Create a thread pool
+         * @param threads Number of worker threads. If <= 0, the number of hardware threads is used.
+         */
+        explicit ThreadPool(int threads = -1);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        /**
+         * @brief Submit a task to the pool
+         * @param task callable with no arguments
+         * @return future with the return value of the task, any exception thrown by the task is rethrown on get()
+         */
+        template <class Function>
+        std::future<std::invoke_result_t<Function>> submit(Function&& task);
+        /**
+         * @brief Block until all submitted tasks have finished
+         */
+        void wait();
+        int getNumberOfThreads() const;
+        /**
+         * @return number of tasks which are queued, but not yet started
+         */
+        int getNumberOfQueuedTasks() const;
+        /**
+         * @brief Get a process wide thread pool shared by all FAST objects
+         */
+        static ThreadPool& getGlobal();
+    private:
+        struct Worker {
+            std::deque<std::function<void()>> tasks;
+            std::mutex mutex;
+        };
+        void enqueue(std::function<void()> task);
+        bool popTask(int workerIndex, std::function<void()>& task);
+        void workerLoop(int workerIndex);
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        std::atomic<uint64_t> m_nextWorker = {0}; // Unsigned, so that it never overflows to a negative index
+        std::atomic_int m_queued = {0};
+        std::atomic_int m_unfinished = {0};
+        std::mutex m_mutex;
+        std::condition_variable m_taskAvailable;
+        std::condition_variable m_allFinished;
+        bool m_stop = false;
+};
+
+template <class Function>
+std::future<std::invoke_result_t<Function>> ThreadPool::submit(Function&& task) {
+    typedef std::invoke_result_t<Function> ReturnType;
+    auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Function>(task));
+    auto future = packagedTask->get_future();
+    enqueue([packagedTask]() { (*packagedTask)(); });
+    return future;
+}
+
+}
@@ -124,7 +124,7 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
 #endif
             uint64_t memoryUsage = 0;
             while(true) {
-                std::string tileID;
+                TileID tileID;
                 {
                     std::unique_lock<std::mutex> lock(m_tileQueueMutex);
                     // If queue is empty, we wait here
@@ -143,16 +143,12 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
                 if(mTexturesToRender.count(tileID) > 0)
                     continue;
 
-                //std::cout << "Loading tile " << tileID << " queue size: " << m_tileQueue.size() << std::endl;
+                //std::cout << "Loading tile " << tileID.toString() << " queue size: " << m_tileQueue.size() << std::endl;
 
                 // Create texture
-                auto parts = split(tileID, "_");
-                if(parts.size() != 3)
-                    throw Exception("incorrect tile format");
-
-                int level = std::stoi(parts[0]);
-                int tile_x = std::stoi(parts[1]);
-                int tile_y = std::stoi(parts[2]);
+                const int level = tileID.getLevel();
+                const int tile_x = tileID.getTileX();
+                const int tile_y = tileID.getTileY();
                 //std::cout << "Creating texture for tile " << tile_x << " " << tile_y << " at level " << level << std::endl;
                 Image::pointer tile;
                 {
@@ -294,8 +290,7 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
 
         for(int tile_x = 0; tile_x < mTilesX; ++tile_x) {
             for(int tile_y = 0; tile_y < mTilesY; ++tile_y) {
-                const std::string tileString =
-                        std::to_string(level) + "_" + std::to_string(tile_x) + "_" + std::to_string(tile_y);
+                const TileID tile(level, tile_x, tile_y);
 
                 float tile_offset_x = tile_x * tileWidth;
                 float tile_offset_y = tile_y * tileHeight;
@@ -343,31 +338,31 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
                 uint textureID;
                 {
 					std::lock_guard<std::mutex> lock(m_tileQueueMutex);
-                    textureReady = mTexturesToRender.count(tileString) > 0;
+                    textureReady = mTexturesToRender.count(tile) > 0;
                 }
                 if(!textureReady) {
                     // Add to queue if not in cache
                     {
                         std::lock_guard<std::mutex> lock(m_tileQueueMutex);
                         // Remove any duplicates first
-                        m_tileQueue.remove(tileString); // O(n) time complexity..
-						m_tileQueue.push_back(tileString);
-                        //std::cout << "Added tile " << tileString << " to queue" << std::endl;
+                        m_tileQueue.remove(tile); // O(n) time complexity..
+						m_tileQueue.push_back(tile);
+                        //std::cout << "Added tile " << tile.toString() << " to queue" << std::endl;
                     }
                     m_queueEmptyCondition.notify_one();
                     continue;
                 } else {
-                    textureID = mTexturesToRender[tileString];
+                    textureID = mTexturesToRender[tile];
                 }
 
                 if(textureID == 0) // This tile was missing or something, just skip it
                     continue;
 
-                if(mVAO.count(tileString) == 0) {
+                if(mVAO.count(tile) == 0) {
                     // Create VAO
                     uint VAO_ID;
                     glGenVertexArrays(1, &VAO_ID);
-                    mVAO[tileString] = VAO_ID;
+                    mVAO[tile] = VAO_ID;
                     glBindVertexArray(VAO_ID);
 
                     // Create VBO
@@ -389,7 +384,7 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
                     };
                     uint VBO;
                     glGenBuffers(1, &VBO);
-                    mVBO[tileString] = VBO;
+                    mVBO[tile] = VBO;
                     glBindBuffer(GL_ARRAY_BUFFER, VBO);
                     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
                     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
@@ -400,7 +395,7 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
                     // Create EBO
                     uint EBO;
                     glGenBuffers(1, &EBO);
-                    mEBO[tileString] = EBO;
+                    mEBO[tile] = EBO;
                     uint indices[] = {  // note that we start from 0!
                             0, 1, 3,   // first triangle
                             1, 2, 3    // second triangle
@@ -411,7 +406,7 @@ ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
                 }
 
                 glBindTexture(GL_TEXTURE_2D, textureID);
-                glBindVertexArray(mVAO[tileString]);
+                glBindVertexArray(mVAO[tile]);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
                 glBindTexture(GL_TEXTURE_2D, 0);
                 glBindVertexArray(0);
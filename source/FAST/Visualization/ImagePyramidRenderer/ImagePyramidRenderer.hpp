@@ -1,12 +1,12 @@
 #pragma once
 
 #include <FAST/Visualization/Renderer.hpp>
+#include <FAST/Data/ImagePyramid.hpp>
 #include <deque>
 #include <thread>
 
 namespace fast {
 
-class ImagePyramid;
 class ImageSharpening;
 
 /**
@@ -28,21 +28,21 @@ class FAST_EXPORT ImagePyramidRenderer : public Renderer {
         draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D, int viewWidth,
              int viewHeight);
 
-        std::unordered_map<std::string, uint> mTexturesToRender;
+        std::unordered_map<TileID, uint> mTexturesToRender;
         std::unordered_map<uint, std::shared_ptr<ImagePyramid>> mImageUsed;
-        std::unordered_map<std::string, uint> mVAO;
-        std::unordered_map<std::string, uint> mVBO;
-        std::unordered_map<std::string, uint> mEBO;
+        std::unordered_map<TileID, uint> mVAO;
+        std::unordered_map<TileID, uint> mVBO;
+        std::unordered_map<TileID, uint> mEBO;
 
         // Queue of tiles to be loaded
-        std::list<std::string> m_tileQueue; // LIFO queue
+        std::list<TileID> m_tileQueue; // LIFO queue
         // Buffer to process queue
         std::unique_ptr<std::thread> m_bufferThread;
         // Condition variable to wait if queue is empty
         std::condition_variable m_queueEmptyCondition;
         std::mutex m_tileQueueMutex;
         bool m_stop = false;
-        std::unordered_set<std::string> m_loaded;
+        std::unordered_set<TileID> m_loaded;
 
         int m_currentLevel = -1;
 
@@ -175,7 +175,7 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
 
                 m_memoryUsage = 0;
                 while(true) {
-                    std::string tileID;
+                    TileID tileID;
                     {
                         std::unique_lock<std::mutex> lock(m_tileQueueMutex);
                         // If queue is empty, we wait here
@@ -191,13 +191,9 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
                     }
 
                     // Create texture
-                    auto parts = split(tileID, "_");
-                    if(parts.size() != 3)
-                        throw Exception("incorrect tile format");
-
-                    int level = std::stoi(parts[0]);
-                    int tile_x = std::stoi(parts[1]);
-                    int tile_y = std::stoi(parts[2]);
+                    const int level = tileID.getLevel();
+                    const int tile_x = tileID.getTileX();
+                    const int tile_y = tileID.getTileY();
                     //std::cout << "Segmentation creating texture for tile " << tile_x << " " << tile_y << " at level " << level << std::endl;
 
                     Image::pointer patch;
@@ -296,7 +292,7 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
         {
             std::lock_guard<std::mutex> lock(m_tileQueueMutex);
             for(auto&& patch : m_input->getDirtyPatches()) {
-                if(patch.substr(0, patch.find("_")) != std::to_string(levelToUse))
+                if(patch.getLevel() != levelToUse)
                     continue;
                 // Add dirty patches to queue
                 m_tileQueue.push_back(patch); // Avoid duplicates somehow?
@@ -342,8 +338,7 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
 
         for(int tile_x = 0; tile_x < mTilesX; ++tile_x) {
             for(int tile_y = 0; tile_y < mTilesY; ++tile_y) {
-                const std::string tileString =
-                        std::to_string(level) + "_" + std::to_string(tile_x) + "_" + std::to_string(tile_y);
+                const TileID tile(level, tile_x, tile_y);
 
                 float tile_offset_x = tile_x * tileWidth;
                 float tile_offset_y = tile_y * tileHeight;
@@ -392,30 +387,30 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
                 {
                     std::lock_guard<std::mutex> lock(m_tileQueueMutex);
                     // Add to queue if texture is not loaded
-                    textureReady = mPyramidTexturesToRender.count(tileString) > 0;
+                    textureReady = mPyramidTexturesToRender.count(tile) > 0;
                 }
-                if(!textureReady || m_input->isDirtyPatch(tileString)) {
+                if(!textureReady || m_input->isDirtyPatch(tile)) {
                     // Add to queue
                     {
                         std::lock_guard<std::mutex> lock(m_tileQueueMutex);
                         // Remove any duplicates first
-                        m_tileQueue.remove(tileString); // O(n) time complexity..
-                        m_tileQueue.push_back(tileString);
-                        //std::cout << "Added tile " << tileString << " to queue" << std::endl;
+                        m_tileQueue.remove(tile); // O(n) time complexity..
+                        m_tileQueue.push_back(tile);
+                        //std::cout << "Added tile " << tile.toString() << " to queue" << std::endl;
                     }
                     m_queueEmptyCondition.notify_one();
                     if(!textureReady) {
                         continue;
                     }
                 }
-                textureID = mPyramidTexturesToRender[tileString];
+                textureID = mPyramidTexturesToRender[tile];
 
                 // Delete old VAO
-                if(mPyramidVAO.count(tileString) == 0) {
+                if(mPyramidVAO.count(tile) == 0) {
                     // Create VAO
                     uint VAO_ID;
                     glGenVertexArrays(1, &VAO_ID);
-                    mPyramidVAO[tileString] = VAO_ID;
+                    mPyramidVAO[tile] = VAO_ID;
                     glBindVertexArray(VAO_ID);
 
                     // Create VBO
@@ -436,7 +431,7 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
                     };
                     uint VBO;
                     glGenBuffers(1, &VBO);
-                    mPyramidVBO[tileString] = VBO;
+                    mPyramidVBO[tile] = VBO;
                     glBindBuffer(GL_ARRAY_BUFFER, VBO);
                     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
                     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
@@ -447,7 +442,7 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
                     // Create EBO
                     uint EBO;
                     glGenBuffers(1, &EBO);
-                    mPyramidEBO[tileString] = EBO;
+                    mPyramidEBO[tile] = EBO;
                     uint indices[] = {  // note that we start from 0!
                             0, 1, 3,   // first triangle
                             1, 2, 3    // second triangle
@@ -460,7 +455,7 @@ void SegmentationRenderer::drawPyramid(std::shared_ptr<SpatialDataObject> dataTo
                 glBindTexture(GL_TEXTURE_2D, textureID);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterMethod);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filterMethod);
-                glBindVertexArray(mPyramidVAO[tileString]);
+                glBindVertexArray(mPyramidVAO[tile]);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
                 glBindTexture(GL_TEXTURE_2D, 0);
                 glBindVertexArray(0);
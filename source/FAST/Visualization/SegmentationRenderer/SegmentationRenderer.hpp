@@ -2,6 +2,7 @@
 
 #include "FAST/Visualization/ImageRenderer/ImageRenderer.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Data/ImagePyramid.hpp"
 #include "FAST/Data/Color.hpp"
 #include "FAST/Utility.hpp"
 #include <unordered_map>
@@ -10,7 +11,6 @@
 
 namespace fast {
 
-class ImagePyramid;
 
 /**
  * @brief Renders 2D segmentation data
@@ -51,14 +51,14 @@ class FAST_EXPORT  SegmentationRenderer : public ImageRenderer, public LabelColo
         float mBorderOpacity = 0.5;
 
         // Queue of tiles to be loaded
-        std::list<std::string> m_tileQueue; // LIFO queue of unique items
+        std::list<TileID> m_tileQueue; // LIFO queue of unique items
         // Buffer to process queue
         std::unique_ptr<std::thread> m_bufferThread;
         // Condition variable to wait if queue is empty
         std::condition_variable m_queueEmptyCondition;
         std::mutex m_tileQueueMutex;
         bool m_stop = false;
-        std::unordered_set<std::string> m_loaded;
+        std::unordered_set<TileID> m_loaded;
 
         int m_currentLevel = -1;
 
@@ -66,10 +66,10 @@ class FAST_EXPORT  SegmentationRenderer : public ImageRenderer, public LabelColo
 
         std::atomic<uint64_t> m_memoryUsage;
         std::mutex m_texturesToRenderMutex;
-        std::unordered_map<std::string, uint> mPyramidTexturesToRender;
-        std::unordered_map<std::string, uint> mPyramidVAO;
-        std::unordered_map<std::string, uint> mPyramidVBO;
-        std::unordered_map<std::string, uint> mPyramidEBO;
+        std::unordered_map<TileID, uint> mPyramidTexturesToRender;
+        std::unordered_map<TileID, uint> mPyramidVAO;
+        std::unordered_map<TileID, uint> mPyramidVBO;
+        std::unordered_map<TileID, uint> mPyramidEBO;
 };
 
 } // end namespace fast